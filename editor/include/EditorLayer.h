@@ -52,6 +52,9 @@ namespace Strontium
     void onScenePlay();
     void onSceneStop();
 
+    // Swap out the current scene, cancelling the loads of the old one.
+    void replaceScene(const Shared<Scene> &newScene);
+
     // The current scene.
     Shared<Scene> currentScene;
     // The framebuffer for the scene.
@@ -8,6 +8,7 @@
 #include "GuiElements/Panels.h"
 #include "Serialization/YamlSerialization.h"
 #include "Scenes/Components.h"
+#include "Utils/AsyncAssetLoading.h"
 
 // Some math for decomposing matrix transformations.
 #include "glm/gtx/matrix_decompose.hpp"
@@ -139,7 +140,7 @@ namespace Strontium
 
           if (success)
           {
-            this->currentScene = tempScene;
+            this->replaceScene(tempScene);
             this->currentScene->getSaveFilepath() = loadEvent.getAbsPath();
             static_cast<SceneGraphWindow*>(this->windows[0])->setSelectedEntity(Entity());
             static_cast<ModelWindow*>(this->windows[4])->setSelectedEntity(Entity());
@@ -168,7 +169,7 @@ namespace Strontium
             Shared<Scene> tempScene = createShared<Scene>();
             if (YAMLSerialization::deserializeScene(tempScene, this->dndScenePath))
             {
-              this->currentScene = tempScene;
+              this->replaceScene(tempScene);
               this->currentScene->getSaveFilepath() = this->dndScenePath;
             }
             this->dndScenePath = "";
@@ -318,7 +319,7 @@ namespace Strontium
           auto storage = Renderer3D::getStorage();
           storage->currentEnvironment->unloadEnvironment();
 
-          this->currentScene = createShared<Scene>();
+          this->replaceScene(createShared<Scene>());
        	}
         if (ImGui::MenuItem(ICON_FA_FOLDER_OPEN_O" Open...", "Ctrl+O"))
        	{
@@ -518,7 +519,7 @@ namespace Strontium
           Shared<Scene> tempScene = createShared<Scene>();
           if (YAMLSerialization::deserializeScene(tempScene, this->dndScenePath))
           {
-            this->currentScene = tempScene;
+            this->replaceScene(tempScene);
             this->currentScene->getSaveFilepath() = this->dndScenePath;
           }
           this->dndScenePath = "";
@@ -541,7 +542,7 @@ namespace Strontium
         Shared<Scene> tempScene = createShared<Scene>();
         if (YAMLSerialization::deserializeScene(tempScene, this->dndScenePath))
         {
-          this->currentScene = tempScene;
+          this->replaceScene(tempScene);
           this->currentScene->getSaveFilepath() = this->dndScenePath;
         }
         this->dndScenePath = "";
@@ -561,7 +562,7 @@ namespace Strontium
       Shared<Scene> tempScene = createShared<Scene>();
       if (YAMLSerialization::deserializeScene(tempScene, this->dndScenePath))
       {
-        this->currentScene = tempScene;
+        this->replaceScene(tempScene);
         this->currentScene->getSaveFilepath() = this->dndScenePath;
       }
       this->dndScenePath = "";
@@ -592,7 +593,7 @@ namespace Strontium
           auto storage = Renderer3D::getStorage();
           storage->currentEnvironment->unloadEnvironment();
 
-          this->currentScene = createShared<Scene>();
+          this->replaceScene(createShared<Scene>());
           static_cast<SceneGraphWindow*>(this->windows[0])->setSelectedEntity(Entity());
           static_cast<ModelWindow*>(this->windows[4])->setSelectedEntity(Entity());
         }
@@ -672,6 +673,14 @@ namespace Strontium
     this->sceneState = SceneState::Edit;
   }
 
+  void
+  EditorLayer::replaceScene(const Shared<Scene> &newScene)
+  {
+    // Models still loading for the old scene are no longer needed.
+    AsyncLoading::cancelSceneLoads(this->currentScene.get());
+    this->currentScene = newScene;
+  }
+
   Entity
   EditorLayer::getSelectedEntity()
   {
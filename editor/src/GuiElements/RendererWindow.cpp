@@ -2,6 +2,7 @@
 
 // Project includes.
 #include "Graphics/Renderer.h"
+#include "Utils/AsyncAssetLoading.h"
 
 // ImGui includes.
 #include "imgui/imgui.h"
@@ -26,6 +27,7 @@ namespace Strontium
 
     ImGui::Begin("Renderer Settings", &isOpen);
 
+    ImGui::Text("Culling pass frametime: %f ms", stats->cullFrametime);
     ImGui::Text("Geometry pass frametime: %f ms", stats->geoFrametime);
     ImGui::Text("Shadow pass frametime: %f ms", stats->shadowFrametime);
     ImGui::Text("Lighting pass frametime: %f ms", stats->lightFrametime);
@@ -33,12 +35,46 @@ namespace Strontium
     ImGui::Text("");
 
     ImGui::Text("Drawcalls: %u", stats->drawCalls);
+    ImGui::Text("Drawcalls saved by instancing: %u", stats->drawCallsSaved);
+    ImGui::Text("Material binds skipped: %u", stats->materialBindsSkipped);
+    auto& bindStats = StateCache::getStats();
+    ImGui::Text("State binds: %u issued, %u skipped", bindStats.bindsIssued,
+                bindStats.bindsSkipped);
     ImGui::Text("Total vertices: %u", stats->numVertices);
     ImGui::Text("Total triangles: %u", stats->numTriangles);
+    ImGui::Text("Triangles saved by LODs and meshlets: %u", stats->trianglesSaved);
+    ImGui::Text("Meshlets culled: %u", stats->meshletsCulled);
+    ImGui::Text("Drawn vertex memory: %.2f MB", stats->vertexBytes / (1024.0f * 1024.0f));
+    ImGui::Text("Geometry arena: %.2f / %.2f MB", stats->arenaUsedBytes / (1024.0f * 1024.0f),
+                stats->arenaCapacityBytes / (1024.0f * 1024.0f));
+    ImGui::Text("Per-draw uniforms: %.2f / %.2f MB", stats->drawDataBytes / (1024.0f * 1024.0f),
+                stats->drawDataFrameBytes / (1024.0f * 1024.0f));
     ImGui::Text("Total lights: D: %u, P: %u, S: %u", stats->numDirLights,
                 stats->numPointLights, stats->numSpotLights);
 
+    auto meshMemory = Mesh::getMemoryReport();
+    ImGui::Text("Released mesh data: %u meshes (%.2f MB)", meshMemory.numReleased,
+                meshMemory.releasedBytes / (1024.0f * 1024.0f));
+    ImGui::Text("Reloaded mesh data: %u meshes (%.2f MB)", meshMemory.numReloaded,
+                meshMemory.reloadedBytes / (1024.0f * 1024.0f));
+
+    auto pendingUploads = AsyncLoading::getPendingUploads();
+    ImGui::Text("Pending texture uploads: %u (%.2f MB)", pendingUploads.numTextures,
+                pendingUploads.numBytes / (1024.0f * 1024.0f));
+    ImGui::Text("Texture upload frametime: %f ms", pendingUploads.lastFrameMilliseconds);
+
+    auto uploadBudget = AsyncLoading::getUploadBudget();
+    if (ImGui::SliderFloat("Upload Budget (ms)", &uploadBudget.maxMilliseconds, 0.5f, 16.0f))
+      AsyncLoading::setUploadBudget(uploadBudget);
+
     ImGui::Checkbox("Frustum Cull", &state->frustumCull);
+    ImGui::Checkbox("Packed Vertices", &state->packedVertices);
+    ImGui::SliderFloat("LOD Error (px)", &state->lodErrorThreshold, 0.0f, 8.0f);
+    ImGui::Checkbox("Meshlet Cull", &state->meshletCull);
+    ImGui::Checkbox("Meshlet Cone Cull", &state->meshletConeCull);
+    ImGui::Checkbox("Indirect Draws", &state->indirectDraws);
+    ImGui::Checkbox("Instancing", &state->instancing);
+    ImGui::Checkbox("Sort Render Queue", &state->sortRenderQueue);
     ImGui::Checkbox("Enable FXAA", &state->enableFXAA);
 
     // TODO: Soft shadow quality settings (Hard shadows, Low, medium, high, ultra). 
@@ -0,0 +1,129 @@
+#pragma once
+
+#define BVH_MAX_LEAF_SIZE 4
+#define BVH_NUM_BINS 16
+
+// Macro include file.
+#include "StrontiumPCH.h"
+
+// Project includes.
+#include "Core/ApplicationBase.h"
+#include "Core/Math.h"
+
+namespace Strontium
+{
+  // Interior nodes have two children at firstIndex and firstIndex + 1, and a
+  // count of 0. Leaves own objectIndices[firstIndex, firstIndex + count).
+  struct BVHNode
+  {
+    glm::vec3 min;
+    uint firstIndex;
+    glm::vec3 max;
+    uint count;
+    uint parent;
+  };
+
+  struct BVHRayHit
+  {
+    uint id;
+    float distance;
+  };
+
+  // Dynamic bounding volume hierarchy over axis aligned boxes keyed by an ID.
+  // Built top down with a binned surface area heuristic. Moving boxes are
+  // refit in place, which is much cheaper than a rebuild but lets the tree
+  // degrade, so it's rebuilt once its SAH cost grows past a threshold. Adding
+  // or removing boxes also rebuilds. Edits are queued and only take effect on
+  // commit(). Moved boxes are queried at their old bounds until then, and the
+  // tree can't be queried at all after adds or removes until it's committed.
+  class BVH
+  {
+  public:
+    BVH();
+    ~BVH() = default;
+
+    // Add a box, or move it if the ID is already in the tree. Moving a box to
+    // the bounds it already has does nothing.
+    void insert(uint id, const glm::vec3 &min, const glm::vec3 &max);
+    void remove(uint id);
+    bool contains(uint id) const;
+    void clear();
+
+    // Apply the queued edits. Returns true if the tree was rebuilt.
+    bool commit();
+
+    // Full rebuild, and bottom up refit of every node.
+    void build();
+    void refit();
+
+    // Append the IDs of the boxes which pass the frustum test, the same test
+    // the renderer culls with.
+    void queryFrustum(const Frustum &frustum, std::vector<uint> &outIDs) const;
+
+    // Append the IDs of the boxes which intersect the sphere.
+    void querySphere(const glm::vec3 &center, float radius, std::vector<uint> &outIDs) const;
+
+    // Append every box the ray hits within maxDistance, nearest first. The
+    // distances are to where the ray enters the box, in units of the
+    // direction's length.
+    void queryRay(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance,
+                  std::vector<BVHRayHit> &outHits) const;
+
+    // Nearest box along the ray. Returns false on a miss.
+    bool raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance,
+                 BVHRayHit &outHit) const;
+
+    // Bounds of everything in the tree. Returns false if it's empty.
+    bool getBounds(glm::vec3 &outMin, glm::vec3 &outMax) const;
+
+    // SAH cost relative to a rebuild past which commit() rebuilds.
+    void setRebuildThreshold(float threshold) { this->rebuildThreshold = threshold; }
+
+    float getCost() const;
+    float getBuildCost() const { return this->buildCost; }
+    uint size() const { return static_cast<uint>(this->objects.size()); }
+    const std::vector<BVHNode>& getNodes() const { return this->nodes; }
+
+    // IDs in insertion order, with removals swapped in from the end.
+    const std::vector<uint>& getIDs() const { return this->objectIDs; }
+  private:
+    struct Object
+    {
+      glm::vec3 min;
+      glm::vec3 max;
+      uint leaf;
+      bool dirty;
+    };
+
+    struct Bin
+    {
+      glm::vec3 min;
+      glm::vec3 max;
+      uint count;
+    };
+
+    void splitNode(uint nodeIndex);
+    void refitLeaf(uint nodeIndex);
+    void refitPath(uint objectIndex);
+
+    std::vector<BVHNode> nodes;
+    std::vector<Object> objects;
+    std::vector<uint> objectIDs;
+    std::vector<uint> objectIndices;
+    std::unordered_map<uint, uint> objectLookup;
+
+    // Build scratch, kept to avoid reallocating on rebuilds.
+    std::vector<glm::vec3> centroids;
+    std::vector<uint> buildStack;
+
+    std::vector<uint> dirtyObjects;
+    bool structureDirty;
+
+    // Boxes refit since the cost was last checked. Checking walks every node,
+    // so it's only done once a good fraction of the tree has moved.
+    uint refitsSinceCheck;
+
+    float rebuildThreshold;
+    float buildCost;
+  };
+}
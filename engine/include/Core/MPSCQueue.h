@@ -0,0 +1,146 @@
+#pragma once
+
+// Macro include file.
+#include "StrontiumPCH.h"
+
+// Project includes.
+#include "Core/ApplicationBase.h"
+
+// STL includes.
+#include <atomic>
+#include <thread>
+#include <cstddef>
+
+namespace Strontium
+{
+  // A bounded lock-free queue with any number of producers and a single
+  // consumer. Based on Dmitry Vyukov's bounded queue: every slot carries a
+  // sequence number which tells producers and the consumer whether it's free
+  // or filled, so neither side ever takes a lock.
+  // Only one thread may pop at a time, usually the main thread.
+  template <typename T>
+  class MPSCQueue
+  {
+  public:
+    // The capacity is rounded up to a power of two.
+    MPSCQueue(uint capacity)
+      : enqueuePos(0)
+      , dequeuePos(0)
+    {
+      uint roundedCapacity = 2;
+      while (roundedCapacity < capacity)
+        roundedCapacity <<= 1;
+
+      this->mask = roundedCapacity - 1;
+      this->cells = new Cell[roundedCapacity];
+      for (uint i = 0; i < roundedCapacity; i++)
+        this->cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    ~MPSCQueue() { delete[] this->cells; }
+
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue &operator=(const MPSCQueue&) = delete;
+
+    // Push a value. Returns false without touching the value if the queue is
+    // full.
+    bool tryPush(T &&value)
+    {
+      Cell* cell;
+      std::size_t pos = this->enqueuePos.load(std::memory_order_relaxed);
+      while (true)
+      {
+        cell = &this->cells[pos & this->mask];
+        std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence)
+                                    - static_cast<std::ptrdiff_t>(pos);
+
+        // The slot is free, try to claim it.
+        if (difference == 0)
+        {
+          if (this->enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            break;
+        }
+        // The consumer hasn't freed the slot from the last lap yet.
+        else if (difference < 0)
+          return false;
+        // Another producer claimed the slot, try the next one.
+        else
+          pos = this->enqueuePos.load(std::memory_order_relaxed);
+      }
+
+      cell->data = std::move(value);
+      cell->sequence.store(pos + 1, std::memory_order_release);
+      return true;
+    }
+
+    // Push a value, waiting for the consumer to make room if the queue is
+    // full. Gives up and returns false if giveUp() returns true while waiting,
+    // so producers can't get stuck if the consumer stops.
+    template <typename Predicate>
+    bool push(T &&value, Predicate &&giveUp)
+    {
+      while (!this->tryPush(std::move(value)))
+      {
+        if (giveUp())
+          return false;
+        std::this_thread::yield();
+      }
+
+      return true;
+    }
+
+    // Fetch the value at the front of the queue without popping it. Returns
+    // nullptr if the queue is empty. Consumer only.
+    T* peek()
+    {
+      std::size_t pos = this->dequeuePos.load(std::memory_order_relaxed);
+      Cell& cell = this->cells[pos & this->mask];
+      if (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+        return nullptr;
+
+      return &cell.data;
+    }
+
+    // Pop the value at the front of the queue. Returns false if the queue is
+    // empty. Consumer only.
+    bool tryPop(T &outValue)
+    {
+      std::size_t pos = this->dequeuePos.load(std::memory_order_relaxed);
+      Cell& cell = this->cells[pos & this->mask];
+      if (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+        return false;
+
+      outValue = std::move(cell.data);
+      cell.data = T();
+
+      // Hand the slot back to the producers for the next lap.
+      cell.sequence.store(pos + this->mask + 1, std::memory_order_release);
+      this->dequeuePos.store(pos + 1, std::memory_order_relaxed);
+      return true;
+    }
+
+    // Number of values in the queue. Only a snapshot if producers are active.
+    uint size() const
+    {
+      std::size_t head = this->dequeuePos.load(std::memory_order_relaxed);
+      std::size_t tail = this->enqueuePos.load(std::memory_order_relaxed);
+      return tail > head ? static_cast<uint>(tail - head) : 0;
+    }
+
+    bool empty() const { return this->size() == 0; }
+    uint capacity() const { return static_cast<uint>(this->mask + 1); }
+  private:
+    struct Cell
+    {
+      std::atomic<std::size_t> sequence;
+      T data;
+    };
+
+    // Producers and the consumer work on separate cache lines.
+    Cell* cells;
+    std::size_t mask;
+    alignas(64) std::atomic<std::size_t> enqueuePos;
+    alignas(64) std::atomic<std::size_t> dequeuePos;
+  };
+}
@@ -1,5 +1,13 @@
 #pragma once
 
+// SIMD width of the batched frustum tests. AVX2 has to be enabled for the
+// whole build, SSE2 is always there on x64.
+#if defined(__AVX2__)
+  #define SR_FRUSTUM_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define SR_FRUSTUM_SIMD_SSE2
+#endif
+
 // Macro include file.
 #include "StrontiumPCH.h"
 
@@ -7,6 +15,9 @@
 #include "Core/ApplicationBase.h"
 #include "Graphics/ShadingPrimatives.h"
 
+// STL includes.
+#include <cstdint>
+
 namespace Strontium
 {
   struct Plane
@@ -32,6 +43,26 @@ namespace Strontium
     float bSphereRadius;
   };
 
+  // The planes of a frustum with one array per component, for testing
+  // several boxes against a plane at once.
+  struct FrustumPlanes
+  {
+    float normalX[6], normalY[6], normalZ[6];
+    float absNormalX[6], absNormalY[6], absNormalZ[6];
+    float d[6];
+  };
+
+  // Bounding boxes as centers and extents, one array per component.
+  struct BoundingBoxArrays
+  {
+    const float* centerX;
+    const float* centerY;
+    const float* centerZ;
+    const float* extentX;
+    const float* extentY;
+    const float* extentZ;
+  };
+
   // Builds a bounding box given the min+max coordinates of an object (in local space).
   BoundingBox buildBoundingBox(const glm::vec3 &min, const glm::vec3 &max);
   // Builds an AABB given the min+max coordinates of an object plus the localspace to worldspace transformation matrix.
@@ -50,4 +81,15 @@ namespace Strontium
   bool boundingBoxInFrustum(const Frustum &frustum, const glm::vec3 min, const glm::vec3 max);
   bool boundingBoxInFrustum(const Frustum& frustum, const glm::vec3 min, const glm::vec3 max, 
                             const glm::mat4 &transform);
+
+  // Batched frustum tests. Sets the bit in the mask of every box in
+  // [start, end) which is in the frustum. The results are exactly those of
+  // boundingBoxOnPlane over the six planes, SIMD or not. The SIMD version
+  // tests 8 boxes at a time with AVX2 and 4 with SSE2, and falls back to
+  // the scalar loop for the remainder and on other targets.
+  FrustumPlanes packFrustumPlanes(const Frustum &frustum);
+  void boundingBoxesInFrustum(const FrustumPlanes &planes, const BoundingBoxArrays &boxes,
+                              uint start, uint end, uint8_t bit, uint8_t* masks);
+  void boundingBoxesInFrustumScalar(const FrustumPlanes &planes, const BoundingBoxArrays &boxes,
+                                    uint start, uint end, uint8_t bit, uint8_t* masks);
 }
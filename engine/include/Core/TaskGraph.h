@@ -0,0 +1,75 @@
+#pragma once
+
+// Macro include file.
+#include "StrontiumPCH.h"
+
+// Project includes.
+#include "Core/ApplicationBase.h"
+#include "Core/ThreadPool.h"
+
+namespace Strontium
+{
+  // Handle to a task in a task graph. Handles are only valid for the graph
+  // which created them.
+  typedef uint TaskHandle;
+
+  // A dependency-aware collection of tasks. Each task lists the tasks it
+  // depends on and only starts once all of them have finished. Parents have to
+  // be added before their children, so a graph can never contain a cycle.
+  class TaskGraph
+  {
+  public:
+    TaskGraph();
+    ~TaskGraph() = default;
+
+    // Add a task which starts once all of its parents have finished.
+    TaskHandle addTask(const std::function<void()> &task,
+                       const std::vector<TaskHandle> &parents = {});
+
+    // Run every task in the graph on the pool. The calling thread helps out
+    // and this returns once every task has finished. A graph can be executed
+    // as many times as needed.
+    void execute(ThreadPool* pool);
+
+    // Remove all the tasks from the graph.
+    void clear();
+
+    uint size() const { return static_cast<uint>(this->state->tasks.size()); }
+  private:
+    struct Task
+    {
+      std::function<void()> function;
+      std::vector<TaskHandle> children;
+      uint numParents;
+      std::atomic<uint> remainingParents;
+
+      Task(const std::function<void()> &function, uint numParents)
+        : function(function)
+        , numParents(numParents)
+        , remainingParents(numParents)
+      { }
+    };
+
+    // Everything the pool's helper jobs touch. Shared so stragglers which
+    // dequeue after the graph finishes don't read freed memory.
+    struct GraphState
+    {
+      std::vector<Unique<Task>> tasks;
+
+      std::mutex readyMutex;
+      std::vector<TaskHandle> readyTasks;
+      std::atomic<uint> remainingTasks;
+
+      GraphState()
+        : remainingTasks(0)
+      { }
+    };
+
+    // Run ready tasks until the graph is done. Helpers give up when nothing
+    // is ready, the thread which called execute() waits for the stragglers.
+    static void drainReadyTasks(const Shared<GraphState> &state, ThreadPool* pool,
+                                bool isCaller);
+
+    Shared<GraphState> state;
+  };
+}
@@ -13,11 +13,147 @@
 #include <functional>
 #include <future>
 #include <atomic>
+#include <deque>
+#include <type_traits>
+#include <cstddef>
+#include <new>
+#include <array>
+#include <chrono>
 
 namespace Strontium
 {
-  // A thread pool to support safe concurrency in SciRender. Its a singleton to
+  // Which set of workers a job runs on. Decoding files and other IO bound work
+  // gets its own workers so a pile of texture loads can't hold up CPU bound
+  // work like mesh processing. CPU workers help out with IO jobs when idle.
+  enum class JobLane
+  {
+    CPU = 0,
+    IO = 1
+  };
+
+  // How many workers to spawn for each lane. Defaults are picked from the
+  // number of hardware threads.
+  struct ThreadPoolSettings
+  {
+    uint numCPUWorkers;
+    uint numIOWorkers;
+
+    ThreadPoolSettings();
+  };
+
+  // How to treat jobs which are still queued when the pool shuts down.
+  enum class ShutdownMode
+  {
+    Drain, // Run every queued job before the workers exit.
+    Cancel // Throw away queued jobs, only wait on the ones already running.
+  };
+
+  // A set of jobs which can be cancelled together. Jobs which haven't started
+  // by the time their group is cancelled are skipped (their futures report a
+  // broken promise). Jobs which are already running can poll isCancelled() to
+  // bail out early.
+  class JobGroup
+  {
+  public:
+    JobGroup()
+      : cancelled(false)
+      , numPending(0)
+    { }
+
+    void cancel() { this->cancelled.store(true); }
+    bool isCancelled() const { return this->cancelled.load(); }
+
+    // Number of jobs in the group which are queued or still running.
+    uint getNumPending() const { return this->numPending.load(); }
+
+    // Block until every job in the group has either finished or been skipped.
+    void wait() const;
+  private:
+    std::atomic_bool cancelled;
+    std::atomic<uint> numPending;
+
+    friend class ThreadPool;
+  };
+
+  // Options for a single job. Jobs with a label get their timings tracked
+  // separately in the pool's stats.
+  struct JobParams
+  {
+    JobLane lane;
+    Shared<JobGroup> group;
+    std::string label;
+
+    JobParams(JobLane lane = JobLane::CPU, const Shared<JobGroup> &group = nullptr,
+              const std::string &label = "")
+      : lane(lane)
+      , group(group)
+      , label(label)
+    { }
+  };
+
+  // Histogram of job timings in power of two buckets. Bucket 0 holds samples
+  // under 1us, bucket i holds samples in [2^(i - 1), 2^i) us and the last
+  // bucket holds everything longer.
+  struct JobTimeHistogram
+  {
+    static constexpr uint numBuckets = 24;
+
+    std::array<uint64_t, numBuckets> buckets {};
+    uint64_t numSamples = 0;
+    double totalMicroseconds = 0.0;
+    double maxMicroseconds = 0.0;
+
+    double getMeanMicroseconds() const
+    {
+      return this->numSamples > 0 ? this->totalMicroseconds / this->numSamples : 0.0;
+    }
+  };
+
+  // Totals for all the jobs sharing a label.
+  struct JobLabelStats
+  {
+    uint64_t numCompleted = 0;
+    double totalWaitMicroseconds = 0.0;
+    double totalExecMicroseconds = 0.0;
+  };
+
+  struct ThreadPoolWorkerStats
+  {
+    JobLane lane = JobLane::CPU;
+    uint64_t numCompleted = 0;
+
+    // Fraction of the time since the stats were reset spent running jobs.
+    double utilisation = 0.0;
+  };
+
+  // A snapshot of the pool's counters. Everything but the queued and running
+  // counts accumulates from the last time the stats were reset.
+  struct ThreadPoolStats
+  {
+    uint numQueued = 0;
+    uint numQueuedCPU = 0;
+    uint numQueuedIO = 0;
+    uint numRunning = 0;
+
+    uint64_t numSubmitted = 0;
+    uint64_t numCompleted = 0;
+    uint64_t numCancelled = 0;
+
+    // Time between a job being pushed and starting, and time spent running.
+    JobTimeHistogram waitTimes;
+    JobTimeHistogram execTimes;
+
+    std::vector<ThreadPoolWorkerStats> workers;
+    std::map<std::string, JobLabelStats> labels;
+
+    double elapsedSeconds = 0.0;
+  };
+
+  // A thread pool to support safe concurrency in Strontium. Its a singleton to
   // force all modes of execution to go through one pipeline, preventing unnecessary spawns.
+  // Each worker owns a deque of jobs. Workers pop from the back of their own
+  // deque and steal from the front of the others when they run dry, so jobs
+  // are never executed while holding a lock shared by the whole pool.
   class ThreadPool
   {
   public:
@@ -28,73 +164,366 @@ namespace Strontium
 
     ~ThreadPool();
 
-    // Fetch the pool.
-    static ThreadPool* getInstance(unsigned int numThreads);
+    // Fetch the pool. It's created on first use and sized from the hardware,
+    // unless the SR_CPU_WORKERS or SR_IO_WORKERS environment variables say
+    // otherwise.
+    static ThreadPool* getInstance();
 
-    // Queue up jobs for the workers to execute.
+    // Queue up jobs for the workers to execute on the CPU lane.
     template <typename Function, typename... Args >
     auto push(Function&& func, Args&&... args)
+    {
+      return this->pushJob(JobParams(), std::forward<Function>(func),
+                           std::forward<Args>(args)...);
+    }
+
+    // Queue up jobs with explicit job options.
+    template <typename Function, typename... Args >
+    auto pushJob(const JobParams &params, Function&& func, Args&&... args)
     {
       // Fetch the return type of the function.
       typedef decltype(func(args...)) retType;
 
       // Package up the function and its arguements.
-      std::packaged_task<retType()> newTask(std::move(std::bind(func, args...)));
-
-      // Lock out the task queue so the new task can be added async.
-      std::unique_lock<std::mutex> lock(taskMutex);
+      std::packaged_task<retType()> newTask(std::bind(std::forward<Function>(func),
+                                                      std::forward<Args>(args)...));
 
       // Get the future for tasks which return non-void.
       std::future<retType> returnValue = newTask.get_future();
 
-      // Push the task and notify one of the workers a job is available.
-      this->tasks.emplace(createShared<ReturnJob<retType>>(std::move(newTask)));
-      this->signal.notify_one();
+      // The packaged task is stored inline in the job, no extra allocation.
+      this->enqueue(Job(std::move(newTask), params), params.lane);
 
       return returnValue;
     }
 
-  private:
-    friend class Job;
-    friend class ReturnJob;
+    // Split [start, end) into chunks of grainSize indices and call func(index)
+    // for each of them across the pool. The calling thread works through
+    // chunks as well and only returns once every index has been processed, so
+    // it never ends up waiting on unrelated jobs.
+    template <typename Function>
+    void parallelFor(uint start, uint end, uint grainSize, Function&& func)
+    {
+      if (end <= start)
+        return;
 
-    // Inner classes to abuse function polymorphism.
-    class Job
+      grainSize = grainSize == 0 ? 1 : grainSize;
+      const uint numChunks = (end - start + grainSize - 1) / grainSize;
+
+      // Not worth going wide for a single chunk.
+      if (numChunks == 1)
+      {
+        for (uint i = start; i < end; i++)
+          func(i);
+        return;
+      }
+
+      // Helpers may be dequeued after every chunk is done, so the counters
+      // they touch have to outlive this call. The function is only touched
+      // after a chunk is claimed, at which point the caller is still waiting.
+      auto state = createShared<ParallelForState>();
+      state->numChunks = numChunks;
+
+      auto runChunks = [state, start, end, grainSize, funcPtr = &func]()
+      {
+        uint chunk;
+        while ((chunk = state->nextChunk.fetch_add(1)) < state->numChunks)
+        {
+          const uint chunkStart = start + chunk * grainSize;
+          const uint chunkEnd = std::min(chunkStart + grainSize, end);
+          for (uint i = chunkStart; i < chunkEnd; i++)
+            (*funcPtr)(i);
+
+          state->chunksDone.fetch_add(1, std::memory_order_release);
+        }
+      };
+
+      const uint numHelpers = std::min(numChunks - 1, this->getNumWorkers(JobLane::CPU));
+      for (uint i = 0; i < numHelpers; i++)
+        this->enqueue(Job(runChunks), JobLane::CPU);
+
+      runChunks();
+
+      while (state->chunksDone.load(std::memory_order_acquire) < numChunks)
+        std::this_thread::yield();
+    }
+
+    // Push a fire-and-forget job without a future attached.
+    template <typename Function>
+    void pushDetached(Function&& func, JobLane lane = JobLane::CPU)
     {
-    public:
-      virtual ~Job()
-      { }
+      this->enqueue(Job(std::forward<Function>(func)), lane);
+    }
 
-      virtual void execute()
-      { }
-    };
+    // Run a single pending job on the calling thread, if there is one. Lets
+    // threads which are waiting on the pool help out instead of blocking.
+    bool tryRunPendingJob();
+
+    // Stop the workers and join them. Jobs which are queued are either run
+    // or thrown away depending on the mode, jobs which are already running
+    // always finish. Jobs pushed after this are dropped. Can't be called from
+    // one of the pool's workers.
+    void shutdown(ShutdownMode mode = ShutdownMode::Drain);
+    bool isShutdown() const { return this->hasShutdown.load(); }
+
+    // True once shutdown has started. Jobs waiting on the main thread should
+    // give up when this is set, the main thread is busy joining the workers.
+    bool isShuttingDown() const { return !this->isActive.load(); }
+
+    // Fetch a snapshot of the pool's counters and timings. Safe to call while
+    // jobs are running, counters may be off by the jobs in flight.
+    ThreadPoolStats getStats() const;
+    void resetStats();
 
-    template <typename ReturnType>
-    class ReturnJob : public Job
+    // Check if the calling thread is one of the pool's workers.
+    bool isWorkerThread() const;
+
+    uint getNumWorkers() const { return static_cast<uint>(this->workers.size()); }
+    uint getNumWorkers(JobLane lane) const { return this->lanes[static_cast<uint>(lane)].numQueues; }
+
+  private:
+    // A move-only type erased callable. Small callables (packaged tasks and
+    // most lambdas) are stored inline to avoid a heap allocation per job.
+    class Job
     {
     public:
-      ReturnJob(std::packaged_task<ReturnType()> function)
-        : function(std::move(function))
+      static constexpr std::size_t inlineSize = 64;
+
+      Job() noexcept
+        : vtable(nullptr)
       { }
 
-      void execute() override
+      template <typename Callable, typename Stored = std::decay_t<Callable>,
+                typename = std::enable_if_t<!std::is_same_v<Stored, Job>>>
+      Job(Callable&& callable, const JobParams &params = JobParams())
+        : vtable(&vtableFor<Stored>)
+        , group(params.group)
+        , label(params.label)
+      {
+        if constexpr (fitsInline<Stored>())
+          new (this->storage) Stored(std::forward<Callable>(callable));
+        else
+          new (this->storage) Stored*(new Stored(std::forward<Callable>(callable)));
+
+        if (this->group)
+          this->group->numPending.fetch_add(1);
+      }
+
+      Job(Job&& other) noexcept
+        : vtable(other.vtable)
+        , group(std::move(other.group))
+        , label(std::move(other.label))
+        , queuedTime(other.queuedTime)
+      {
+        if (this->vtable)
+          this->vtable->relocate(this->storage, other.storage);
+        other.vtable = nullptr;
+      }
+
+      Job& operator=(Job&& other) noexcept
       {
-        this->function();
+        if (this != &other)
+        {
+          this->reset();
+          this->vtable = other.vtable;
+          this->group = std::move(other.group);
+          this->label = std::move(other.label);
+          this->queuedTime = other.queuedTime;
+          if (this->vtable)
+            this->vtable->relocate(this->storage, other.storage);
+          other.vtable = nullptr;
+        }
+        return *this;
       }
+
+      ~Job() { this->reset(); }
+
+      // Jobs of a cancelled group are skipped, not run. Returns true if the
+      // job actually ran.
+      bool operator()()
+      {
+        if (this->group && this->group->isCancelled())
+          return false;
+
+        this->vtable->invoke(this->storage);
+        return true;
+      }
+
+      const std::string& getLabel() const { return this->label; }
+      std::chrono::steady_clock::time_point& getQueuedTime() { return this->queuedTime; }
+      explicit operator bool() const { return this->vtable != nullptr; }
+
     private:
-      std::packaged_task<ReturnType()> function;
+      struct VTable
+      {
+        void (*invoke)(void*);
+        void (*relocate)(void*, void*);
+        void (*destroy)(void*);
+      };
+
+      template <typename Stored>
+      static constexpr bool fitsInline()
+      {
+        return sizeof(Stored) <= inlineSize
+               && alignof(Stored) <= alignof(std::max_align_t)
+               && std::is_nothrow_move_constructible_v<Stored>;
+      }
+
+      template <typename Stored>
+      static Stored* get(void* storage)
+      {
+        if constexpr (fitsInline<Stored>())
+          return std::launder(reinterpret_cast<Stored*>(storage));
+        else
+          return *std::launder(reinterpret_cast<Stored**>(storage));
+      }
+
+      template <typename Stored>
+      static inline const VTable vtableFor =
+      {
+        [](void* storage) { (*get<Stored>(storage))(); },
+        [](void* dst, void* src)
+        {
+          // Move into the new storage and end the old object's lifetime.
+          if constexpr (fitsInline<Stored>())
+          {
+            new (dst) Stored(std::move(*get<Stored>(src)));
+            get<Stored>(src)->~Stored();
+          }
+          else
+            new (dst) Stored*(get<Stored>(src));
+        },
+        [](void* storage)
+        {
+          if constexpr (fitsInline<Stored>())
+            get<Stored>(storage)->~Stored();
+          else
+            delete get<Stored>(storage);
+        }
+      };
+
+      // The job leaves its group once it's destroyed, whether it ran or not.
+      void reset()
+      {
+        if (this->vtable)
+          this->vtable->destroy(this->storage);
+        this->vtable = nullptr;
+
+        if (this->group)
+          this->group->numPending.fetch_sub(1);
+        this->group.reset();
+      }
+
+      alignas(std::max_align_t) unsigned char storage[inlineSize];
+      const VTable* vtable;
+      Shared<JobGroup> group;
+      std::string label;
+      std::chrono::steady_clock::time_point queuedTime;
+    };
+
+    // The job deque owned by a single worker. Padded out to a cache line so
+    // workers don't false share each other's locks.
+    struct alignas(64) WorkerQueue
+    {
+      std::mutex queueMutex;
+      std::deque<Job> jobs;
+    };
+
+    // Shared counters for a parallel for loop.
+    struct ParallelForState
+    {
+      uint numChunks = 0;
+      std::atomic<uint> nextChunk { 0 };
+      std::atomic<uint> chunksDone { 0 };
+    };
+
+    // The workers and counters of a single lane. Workers of a lane own a
+    // contiguous range of the queues.
+    struct alignas(64) Lane
+    {
+      uint firstQueue = 0;
+      uint numQueues = 0;
+      std::atomic<uint> nextQueue { 0 };
+      std::atomic<uint> pendingJobs { 0 };
+      std::atomic<uint> numSleeping { 0 };
+      std::atomic<uint64_t> numSubmitted { 0 };
+      std::condition_variable signal;
+    };
+
+    static constexpr uint numLanes = 2;
+
+    // Lock free version of the timing histogram, so it can be read while
+    // workers are adding samples.
+    struct AtomicHistogram
+    {
+      std::atomic<uint64_t> buckets[JobTimeHistogram::numBuckets];
+      std::atomic<uint64_t> numSamples { 0 };
+      std::atomic<uint64_t> totalNanoseconds { 0 };
+      std::atomic<uint64_t> maxNanoseconds { 0 };
+
+      AtomicHistogram();
+
+      void addSample(uint64_t nanoseconds);
+      void accumulate(JobTimeHistogram &outHistogram) const;
+      void reset();
+    };
+
+    // Counters for the jobs run by a single thread. Each worker has its own
+    // so recording doesn't contend, threads outside the pool share the last.
+    struct alignas(64) WorkerCounters
+    {
+      std::atomic<uint> numRunning { 0 };
+      std::atomic<uint64_t> numCompleted { 0 };
+      std::atomic<uint64_t> numCancelled { 0 };
+      std::atomic<uint64_t> busyNanoseconds { 0 };
+
+      AtomicHistogram waitTimes;
+      AtomicHistogram execTimes;
+
+      std::mutex labelMutex;
+      std::unordered_map<std::string, JobLabelStats> labels;
     };
 
     // Construct the thread pool.
-    ThreadPool(unsigned int numThreads);
+    ThreadPool(const ThreadPoolSettings &settings);
+
+    // Push a job into one of the lane's worker queues and wake a sleeping worker.
+    void enqueue(Job &&job, JobLane lane);
+
+    // Fetch a job from the worker's own queue, or steal one from another
+    // worker in the given lane.
+    bool popJob(uint workerIndex, Job &outJob);
+    bool stealJob(uint thiefIndex, JobLane lane, Job &outJob);
+
+    // Run a job and record its timings in the thread's counters.
+    void runJob(Job &job, WorkerCounters &counters);
+
+    // Counters for the calling thread.
+    WorkerCounters& getCounters();
+
+    // Check if a worker of the given lane has anything it could pick up.
+    bool hasPendingJobs(JobLane workerLane) const;
+
+    JobLane getWorkerLane(uint workerIndex) const;
+    Lane& getLane(JobLane lane) { return this->lanes[static_cast<uint>(lane)]; }
+
+    void workerLoop(uint workerIndex);
 
     static ThreadPool* instance;
 
     // Member variables for the pool.
     std::vector<std::thread> workers;
-    std::queue<Shared<Job>> tasks;
-    std::condition_variable signal;
-    std::mutex taskMutex;
+    std::vector<Unique<WorkerQueue>> queues;
+    Lane lanes[numLanes];
+
+    // One set of counters per worker, plus one for everyone else.
+    std::vector<Unique<WorkerCounters>> counters;
+    std::atomic<int64_t> statsStartTime;
+
+    // Only used to park idle workers, never held while a job runs.
+    std::mutex sleepMutex;
     std::atomic_bool isActive;
+    std::atomic_bool cancelQueued;
+    std::atomic_bool hasShutdown;
   };
 }
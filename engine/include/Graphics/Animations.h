@@ -68,6 +68,9 @@ namespace Strontium
   public:
     Animation(const aiAnimation* animation, Model* parentModel);
     Animation(Model* parentModel);
+    // Empty animation whose nodes are filled in afterwards, used by cooked models.
+    Animation(const std::string &name, float duration, float ticksPerSecond,
+              Model* parentModel);
     ~Animation();
 
     void loadAnimation(const aiAnimation* animation);
@@ -93,6 +93,29 @@ namespace Strontium
   //----------------------------------------------------------------------------
   // Uniform buffer here.
   //----------------------------------------------------------------------------
+  // std140 layout rules, for checking CPU copies of uniform blocks at compile
+  // time. Scalars align to 4 bytes, vec3s and vec4s to 16, and every array
+  // element and matrix column to 16.
+  namespace Std140
+  {
+    constexpr uint scalarSize = 4;
+    constexpr uint vec4Size = 16;
+    constexpr uint mat4Size = 64;
+
+    constexpr uint
+    align(uint offset, uint alignment)
+    {
+      return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    // Offset of a member following one at offset of the given size.
+    constexpr uint
+    next(uint offset, uint size, uint alignment = vec4Size)
+    {
+      return align(offset + size, alignment);
+    }
+  }
+
   class UniformBuffer
   {
   public:
@@ -115,6 +138,13 @@ namespace Strontium
     // Set a specific part of the buffer data.
     void setData(uint start, uint newDataSize, const void* newData);
 
+    // Upload a whole block in one call.
+    template <typename T>
+    void setData(const T &block)
+    {
+      this->setData(0, sizeof(T), &block);
+    }
+
     uint getID() { return this->bufferID; }
     bool hasData() { return this->filled; }
   protected:
@@ -216,4 +246,63 @@ namespace Strontium
     // The size of the data currently in the buffer.
     uint dataSize;
   };
+
+  //----------------------------------------------------------------------------
+  // Uniform ring buffer here.
+  //----------------------------------------------------------------------------
+  // Persistently mapped uniform buffer split into a region per frame in
+  // flight. Per-draw data is copied into the current frame's region and
+  // bound with an offset, instead of a glBufferSubData on a shared buffer per
+  // draw. Each region is fenced at the end of its frame and waited on before
+  // it's written again, so the CPU never overwrites data the GPU still reads.
+  class UniformRingBuffer
+  {
+  public:
+    UniformRingBuffer(uint frameSize, uint numFrames = 3);
+    ~UniformRingBuffer();
+
+    // Delete the copy constructor and the assignment operator. Prevents
+    // issues related to the underlying API.
+    UniformRingBuffer(const UniformRingBuffer&) = delete;
+    UniformRingBuffer& operator=(const UniformRingBuffer&) = delete;
+
+    // Move to the next region, waiting for the GPU to finish with it.
+    void beginFrame();
+    // Fence the current region.
+    void endFrame();
+
+    // Copy the data into the current region and bind it to a uniform block.
+    // If the region is full the buffer grows. The blocks written earlier in
+    // the frame are copied over and rebound, so their bindings stay valid.
+    void bindData(uint bindPoint, const void* data, uint dataSize);
+
+    uint getID() { return this->bufferID; }
+    uint getFrameSize() const { return this->frameSize; }
+    uint getFrameUsage() const { return this->head; }
+  protected:
+    void allocateStorage();
+    void releaseStorage();
+    void grow(uint minFrameSize);
+
+    // OpenGL buffer ID.
+    uint bufferID;
+
+    // The persistently mapped buffer memory.
+    unsigned char* mappedData;
+
+    // Size of a region, the required offset alignment, and the next free
+    // byte in the current region.
+    uint frameSize;
+    uint alignment;
+    uint head;
+
+    // The region being written this frame, and a fence per region.
+    uint numFrames;
+    uint currentFrame;
+    std::vector<void*> fences;
+
+    // The last range bound to each block this frame, relative to the start
+    // of the region, to rebind if the buffer grows.
+    std::unordered_map<uint, std::pair<uint, uint>> frameBindings;
+  };
 }
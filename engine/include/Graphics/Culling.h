@@ -0,0 +1,68 @@
+#pragma once
+
+#define MAX_CULLING_FRUSTUMS 8
+
+// Macro include file.
+#include "StrontiumPCH.h"
+
+// Project includes.
+#include "Core/ApplicationBase.h"
+#include "Core/Math.h"
+#include "Core/ThreadPool.h"
+
+// STL includes.
+#include <cstdint>
+
+namespace Strontium
+{
+  // World space bounding boxes as centers and extents, one array per
+  // component. The frustum tests stream through each array instead of
+  // striding over whole boxes.
+  struct CullingBounds
+  {
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+
+    void resize(uint numBounds);
+    void set(uint index, const BoundingBox &box);
+
+    uint size() const { return static_cast<uint>(this->centerX.size()); }
+
+    BoundingBoxArrays getArrays() const
+    {
+      return { this->centerX.data(), this->centerY.data(), this->centerZ.data(),
+               this->extentX.data(), this->extentY.data(), this->extentZ.data() };
+    }
+  };
+
+  // Tests bounds against a set of frustums and writes a compact list of the
+  // visible indices per frustum, in ascending order. The bounds are split into
+  // chunks which are culled across the thread pool. The lists and scratch
+  // space are kept between calls so culling every frame doesn't allocate.
+  class FrustumCuller
+  {
+  public:
+    FrustumCuller() = default;
+
+    // Cull against up to MAX_CULLING_FRUSTUMS frustums. Without a pool the
+    // culling runs on the calling thread.
+    void cull(const CullingBounds &bounds, const Frustum* frustums, uint numFrustums,
+              ThreadPool* pool = nullptr, uint grainSize = 4096);
+
+    // Mark every box visible in every frustum, for when culling is disabled.
+    void setAllVisible(uint numBounds, uint numFrustums);
+
+    const std::vector<uint>& getVisible(uint frustum) const { return this->visible[frustum]; }
+    uint getNumFrustums() const { return this->numFrustums; }
+  private:
+    // Bit i of a box's mask is set if it's visible in frustum i.
+    std::vector<uint8_t> masks;
+
+    // Visible boxes per chunk and frustum, then the offset of each chunk's
+    // indices in the lists.
+    std::vector<uint> chunkOffsets;
+
+    std::vector<uint> visible[MAX_CULLING_FRUSTUMS];
+    uint numFrustums = 0;
+  };
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+// Macro include file.
+#include "StrontiumPCH.h"
+
+// Project includes.
+#include "Core/ApplicationBase.h"
+
+// STL includes.
+#include <map>
+
+namespace Strontium
+{
+  struct Vertex;
+
+  // Layout of a glMultiDrawElementsIndirect command.
+  struct DrawElementsIndirectCommand
+  {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+  };
+
+  // A block of vertices and indices in the geometry arena.
+  struct ArenaAllocation
+  {
+    uint firstVertex;
+    uint numVertices;
+    uint firstIndex;
+    uint numIndices;
+
+    ArenaAllocation()
+      : firstVertex(0)
+      , numVertices(0)
+      , firstIndex(0)
+      , numIndices(0)
+    { }
+  };
+
+  // First fit allocator for ranges of a buffer. Freed ranges are merged with
+  // their neighbours.
+  class RangeAllocator
+  {
+  public:
+    RangeAllocator();
+
+    bool allocate(uint size, uint &outOffset);
+    void free(uint offset, uint size);
+
+    // Add space to the end of the range.
+    void grow(uint newCapacity);
+
+    uint getCapacity() { return this->capacity; }
+    uint getUsed() { return this->used; }
+  private:
+    // Offset to size of each free range.
+    std::map<uint, uint> freeRanges;
+
+    uint capacity;
+    uint used;
+  };
+
+  // One vertex buffer and one index buffer shared by every mesh drawn through
+  // the indirect path, so a whole batch of meshes can be drawn with a single
+  // glMultiDrawElementsIndirect. The buffers double in size when they run out
+  // of space. Vertices are always in the full format.
+  //
+  // Each command's baseInstance is passed to the vertex shader through an
+  // instanced draw ID attribute (location 7), which shaders use to index the
+  // per-draw data.
+  class GeometryArena
+  {
+  public:
+    // Created on first use, which must be on the thread with the graphics
+    // context.
+    static GeometryArena* getInstance();
+    ~GeometryArena();
+
+    // Delete the copy constructor and the assignment operator. Prevents
+    // issues related to the underlying API.
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+
+    bool allocate(uint numVertices, uint numIndices, ArenaAllocation &outAllocation);
+    void free(const ArenaAllocation &allocation);
+
+    // Fill part of an allocation.
+    void setVertices(uint firstVertex, const Vertex* vertices, uint numVertices);
+    void setIndices(uint firstIndex, const uint* indices, uint numIndices);
+
+    // Upload the commands for the frame, then draw ranges of them.
+    void setCommands(const std::vector<DrawElementsIndirectCommand> &commands);
+    void drawCommands(uint firstCommand, uint numCommands);
+
+    // Bind/unbind the arena and its commands.
+    void bind();
+    void unbind();
+
+    uint64_t getUsedBytes();
+    uint64_t getCapacityBytes();
+  private:
+    GeometryArena();
+
+    void growVertices(uint minCapacity);
+    void growIndices(uint minCapacity);
+    void growDrawIDs(uint minCapacity);
+
+    // Copy a buffer into a new, larger one and delete the old one.
+    uint growBuffer(uint bufferID, uint64_t oldSize, uint64_t newSize);
+
+    // OpenGL objects.
+    uint arrayID;
+    uint vertexBufferID;
+    uint indexBufferID;
+    uint commandBufferID;
+    uint drawIDBufferID;
+
+    RangeAllocator vertexRanges;
+    RangeAllocator indexRanges;
+    uint commandCapacity;
+    uint drawIDCapacity;
+  };
+}
@@ -170,6 +170,9 @@ namespace Strontium
     // Reflect the attached shader.
     void reflect();
 
+    // Sampler uniform handles in the order of the 2D samplers.
+    std::vector<UniformHandle>& getSamplerHandles(Shader* shader);
+
     // The location (if any) on disk.
     std::string filepath;
 
@@ -191,6 +194,14 @@ namespace Strontium
     std::vector<std::pair<std::string, Strontium::AssetHandle>> sampler3Ds;
     std::vector<std::pair<std::string, Strontium::AssetHandle>> samplerCubes;
 
+    // Sampler handles per shader the material has been configured with.
+    struct SamplerHandles
+    {
+      uint linkCount = 0;
+      std::vector<UniformHandle> handles;
+    };
+    std::unordered_map<Shader*, SamplerHandles> samplerHandles;
+
     // The uniform buffer to store shader data in.
     UniformBuffer materialData;
   };
@@ -0,0 +1,84 @@
+#pragma once
+
+// Macro include file.
+#include "StrontiumPCH.h"
+
+// Project includes.
+#include "Core/ApplicationBase.h"
+#include "Graphics/Meshes.h"
+
+namespace Strontium
+{
+  // Post-import optimisations for triangle meshes. Everything here works on
+  // the CPU-side vertex and index data only, so it can run on worker threads
+  // and be measured without a GPU.
+  namespace MeshOptimizer
+  {
+    // Efficiency of an index buffer against a simulated FIFO post-transform
+    // cache. ACMR is the average number of vertices transformed per triangle
+    // (0.5 is the ideal for large meshes, 3 is the worst), ATVR is the number
+    // of vertices transformed per unique vertex (1 is the ideal).
+    struct VertexCacheStats
+    {
+      float acmr;
+      float atvr;
+
+      VertexCacheStats()
+        : acmr(0.0f)
+        , atvr(0.0f)
+      { }
+    };
+
+    // Before and after numbers for a single mesh.
+    struct OptimizationReport
+    {
+      VertexCacheStats before;
+      VertexCacheStats after;
+    };
+
+    VertexCacheStats analyzeVertexCache(const std::vector<uint> &indices, uint numVertices,
+                                        uint cacheSize = 16);
+
+    // Reorder the triangles for the post-transform cache (Forsyth's linear
+    // speed vertex cache optimisation).
+    void optimizeVertexCache(std::vector<uint> &indices, uint numVertices);
+
+    // Reorder clusters of triangles so outward-facing clusters on the far
+    // side of the mesh come first, cutting down on overdraw. Only splits the
+    // triangle order where the cache efficiency stays within the threshold
+    // of the input order, so this should run after optimizeVertexCache.
+    void optimizeOverdraw(std::vector<uint> &indices, const std::vector<Vertex> &vertices,
+                          float threshold = 1.05f);
+
+    // Reorder the vertices into the order they're first used in, so vertex
+    // fetches walk through memory linearly. Unused vertices are dropped.
+    void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<uint> &indices);
+
+    // Quadric error simplification. Collapses edges onto existing vertices
+    // until the index count drops to the target or the next collapse would
+    // exceed the target error, and returns the new index buffer. Errors are
+    // relative to the mesh extent. The target is checked against the quadric
+    // estimate, which is a mean over the planes and can be lower than the
+    // real deviation, so the reported error is measured between the two
+    // surfaces instead. Border and UV seam vertices are locked so the result
+    // doesn't crack. The vertices aren't touched.
+    std::vector<uint> simplify(const std::vector<uint> &indices, const std::vector<Vertex> &vertices,
+                               uint targetIndexCount, float targetError,
+                               float* outError = nullptr);
+
+    // Run every optimisation on a mesh, in order.
+    OptimizationReport optimizeMesh(Mesh &mesh);
+
+    // Build the simplified levels of detail for a mesh, each with roughly
+    // half the triangles of the last. Meshes which are too small or don't
+    // simplify well get fewer levels.
+    void generateLODs(Mesh &mesh, float maxError = 0.05f);
+
+    // Split the full detail triangles into meshlets of at most
+    // MAX_MESHLET_VERTICES unique vertices and MAX_MESHLET_TRIANGLES
+    // triangles, each with a bounding sphere and normal cone for culling.
+    // Scans the triangles in their optimised order, so each meshlet is a
+    // contiguous range of the index buffer and no reordering is undone.
+    void buildMeshlets(Mesh &mesh);
+  }
+}
@@ -7,6 +7,14 @@
 #include "Core/ApplicationBase.h"
 #include "Graphics/VertexArray.h"
 #include "Graphics/Shaders.h"
+#include "Graphics/GeometryArena.h"
+
+// Maximum number of detail levels per mesh, including the full mesh.
+#define MAX_MESH_LODS 4
+
+// Meshlet limits, sized for mesh shader friendly clusters.
+#define MAX_MESHLET_VERTICES 64
+#define MAX_MESHLET_TRIANGLES 124
 
 namespace Strontium
 {
@@ -20,7 +28,7 @@ namespace Strontium
     glm::vec2 uv;
     glm::vec3 tangent;
     glm::vec3 bitangent;
-    glm::ivec4 boneIDs;
+    glm::uvec4 boneIDs; // Unused slots are bone 0 with no weight.
     glm::vec4 boneWeights;
 
     Vertex()
@@ -29,11 +37,34 @@ namespace Strontium
       , uv(0.0f)
       , tangent(0.0f)
       , bitangent(0.0f)
-      , boneIDs(-1)
+      , boneIDs(0)
       , boneWeights(0.0f)
     { }
   };
 
+  // Layouts the vertex data can be uploaded to the GPU in.
+  enum class VertexFormat
+  {
+    Full = 0,
+    Packed = 1
+  };
+
+  // Compact GPU-side vertex, 32 bytes instead of the 92 bytes of a full
+  // vertex. Normals and tangents are octahedral encoded with the bitangent
+  // replaced by its handedness, texture coordinates are half floats and the
+  // bone indices and weights are a byte each. The position drops its w, which
+  // the attribute fetch fills back in as 1.
+  struct PackedVertex
+  {
+    glm::vec3 position;
+    uint32_t normal; // Octahedral snorm16 (x, y).
+    uint32_t tangent; // Octahedral snorm10 (x, y), bitangent sign (w).
+    uint32_t uv; // Half float (x, y).
+    uint32_t boneIDs; // uint8 (x, y, z, w).
+    uint32_t boneWeights; // unorm8 (x, y, z, w).
+  };
+  static_assert(sizeof(PackedVertex) == 32, "Packed vertices should be 32 bytes.");
+
   // Material info from assimp.
   struct UnloadedMaterialInfo
   {
@@ -54,6 +85,61 @@ namespace Strontium
     { }
   };
 
+  // A simplified version of a mesh. Shares the vertices of the full mesh.
+  struct MeshLOD
+  {
+    std::vector<uint> indices;
+    uint numIndices; // Kept once the indices are released.
+    float error; // Simplification error relative to the mesh extent.
+
+    MeshLOD(std::vector<uint> &&indices, float error)
+      : indices(std::move(indices))
+      , numIndices(static_cast<uint>(this->indices.size()))
+      , error(error)
+    { }
+
+    MeshLOD()
+      : numIndices(0)
+      , error(0.0f)
+    { }
+  };
+
+  // A cluster of triangles from the full detail mesh, for culling parts of a
+  // mesh. The triangles are a contiguous range of the mesh's indices.
+  struct Meshlet
+  {
+    uint indexOffset;
+    uint indexCount;
+    uint vertexCount;
+    uint padding;
+
+    // Center (xyz) and radius (w), in mesh space.
+    glm::vec4 boundingSphere;
+    // Axis (xyz) of the cone of face normals, and the cosine cutoff (w) of
+    // the view directions which can only see back faces. A cutoff of 1 never
+    // culls.
+    glm::vec4 normalCone;
+
+    Meshlet()
+      : indexOffset(0)
+      , indexCount(0)
+      , vertexCount(0)
+      , padding(0)
+      , boundingSphere(0.0f)
+      , normalCone(0.0f, 0.0f, 1.0f, 1.0f)
+    { }
+  };
+
+  // Totals for the CPU-side mesh data released after upload and reloaded
+  // from the cooked cache since startup.
+  struct MeshMemoryReport
+  {
+    uint numReleased;
+    uint64_t releasedBytes;
+    uint numReloaded;
+    uint64_t reloadedBytes;
+  };
+
   class Mesh
   {
   public:
@@ -65,8 +151,28 @@ namespace Strontium
     ~Mesh();
     Mesh(Mesh&&) = default;
 
-    // Generate/delete the vertex array object.
-    void generateVAO();
+    // Generate/delete the vertex array object. Meshes which can't be packed
+    // (more than 256 bones) fall back to the full format. Released data is
+    // reloaded first, and released again afterwards if the parent model
+    // allows it.
+    void generateVAO(VertexFormat format = VertexFormat::Full);
+
+    // Drop the CPU copies of the vertices and indices, keeping only the
+    // bounds and counts. Only meshes of cooked models can be released, since
+    // the data has to be reloaded from the cooked file if it's needed again.
+    // Returns the number of bytes freed.
+    uint64_t releaseData();
+    bool reloadData();
+
+    // Copy the mesh and its levels of detail into the shared geometry arena,
+    // for the indirect draw path. The levels are stored back to back after
+    // the full mesh.
+    bool uploadToArena();
+    void freeArena();
+    bool isInArena() { return this->inArena; }
+    ArenaAllocation& getArenaAllocation() { return this->arenaAllocation; }
+    uint getArenaFirstIndex(uint lod);
+    static MeshMemoryReport getMemoryReport();
 
     // Set the loaded state.
     void setLoaded(bool isLoaded) { this->loaded = isLoaded; }
@@ -78,19 +184,45 @@ namespace Strontium
     glm::vec3& getMaxPos() { return this->maxPos; }
     glm::mat4& getTransform() { return this->localTransform; }
     VertexArray*  getVAO() { return this->vArray.get(); }
+    VertexFormat getVertexFormat() { return this->vertexFormat; }
+    uint64_t getVertexBytes() { return this->vertexBytes; }
     std::string& getFilepath() { return this->filepath; }
     std::string& getName() { return this->name; }
     UnloadedMaterialInfo& getMaterialInfo() { return this->materialInfo; }
 
+    // Level 0 is the full mesh, the rest are progressively simpler.
+    std::vector<MeshLOD>& getLODs() { return this->lods; }
+    uint getNumLODs() { return static_cast<uint>(this->lods.size()) + 1; }
+    uint getNumVertices() { return this->dataReleased ? this->numVertices : static_cast<uint>(this->data.size()); }
+    uint getNumIndices(uint lod);
+    float getLODError(uint lod) { return lod == 0 ? 0.0f : this->lods[lod - 1].error; }
+
+    // Meshlets of the full mesh. Kept when the rest of the data is released.
+    std::vector<Meshlet>& getMeshlets() { return this->meshlets; }
+
     // Check for states.
     bool hasVAO() { return this->vArray != nullptr; }
+    bool hasVAO(VertexFormat format) { return this->vArray != nullptr && this->requestedFormat == format; }
     bool isLoaded() { return this->loaded; }
+    bool hasData() { return !this->dataReleased; }
+
+    // Where the vertices start in the parent model's cooked file.
+    void setCookedOffset(uint64_t offset) { this->cookedOffset = offset; }
+    uint64_t getCookedOffset() { return this->cookedOffset; }
   protected:
     // Mesh properties.
     bool loaded;
     bool skinned;
     std::vector<Vertex> data;
     std::vector<uint> indices;
+    std::vector<MeshLOD> lods;
+    std::vector<Meshlet> meshlets;
+
+    // Counts which outlive the data.
+    bool dataReleased;
+    uint numVertices;
+    uint numIndices;
+    uint64_t cookedOffset;
 
     glm::vec3 minPos;
     glm::vec3 maxPos;
@@ -105,5 +237,12 @@ namespace Strontium
 
     // Vertex array object for the mesh data.
     Unique<VertexArray> vArray;
+    VertexFormat requestedFormat;
+    VertexFormat vertexFormat;
+    uint64_t vertexBytes;
+
+    // Space in the geometry arena.
+    bool inArena;
+    ArenaAllocation arenaAllocation;
   };
 }
@@ -16,6 +16,8 @@ struct aiMesh;
 
 namespace Strontium
 {
+  class JobGroup;
+
   // Model class
   class Model : public Asset
   {
@@ -23,8 +25,9 @@ namespace Strontium
     Model();
     ~Model();
 
-    // Load a model.
-    void load(const std::string& filepath);
+    // Load a model. If a job group is given the import stops early once the
+    // group is cancelled, leaving the model unloaded.
+    void load(const std::string& filepath, const JobGroup* cancelGroup = nullptr);
     void unload();
 
     // Is the model loaded or not.
@@ -44,11 +47,22 @@ namespace Strontium
     std::string& getFilepath() { return this->filepath; }
 
     bool hasSkins() { return this->isSkinned; }
+
+    // Submeshes drop their CPU-side data once it's uploaded, unless something
+    // still needs it. Anything reading the vertices or indices after the
+    // model is on the GPU (picking, exporting) should retain the data for as
+    // long as it needs it, which reloads anything already released.
+    void retainMeshData();
+    void releaseMeshData();
+    bool canReleaseMeshData();
   private:
-    void processNode(aiNode* node, const aiScene* scene, const std::string &directory, 
+    void processNode(aiNode* node, const aiScene* scene,
+                     std::vector<std::pair<aiMesh*, glm::mat4>> &outMeshes,
                      const glm::mat4 &parentTransform = glm::mat4(1.0f));
-    void processMesh(aiMesh* mesh, const aiScene* scene, const std::string &directory, 
-                     const glm::mat4& localTransform = glm::mat4(1.0f));
+    void processMesh(aiMesh* mesh, const aiScene* scene, const std::string &directory,
+                     Mesh &outMesh);
+    void processBones(aiMesh* mesh, std::vector<uint> &outBoneIndices);
+    void loadBoneWeights(aiMesh* mesh, const std::vector<uint> &boneIndices, Mesh &outMesh);
 
     void addBoneData(unsigned int boneIndex, float boneWeight, Vertex &toMod);
 
@@ -70,6 +84,11 @@ namespace Strontium
     bool loaded;
     bool isSkinned;
 
+    // The cooked file the submesh data can be reloaded from.
+    bool hasCookedFile;
+    uint64_t cookedKey;
+    uint meshDataRetains;
+
     glm::vec3 minPos;
     glm::vec3 maxPos;
 
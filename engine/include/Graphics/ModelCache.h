@@ -0,0 +1,49 @@
+#pragma once
+
+// Macro include file.
+#include "StrontiumPCH.h"
+
+// Project includes.
+#include "Core/ApplicationBase.h"
+
+// STL includes.
+#include <cstdint>
+
+namespace Strontium
+{
+  class Model;
+  class Mesh;
+
+  // Cooked models are a binary dump of everything Model::load pulls out of
+  // Assimp: the submesh vertices and indices, transforms, bounds, bones,
+  // scene nodes and animations. They're written the first time a model is
+  // imported and read back on later loads, so the importer only runs when the
+  // source file or the import flags change. The file is memory-mapped instead
+  // of read, but every array is still copied out into the model's vectors.
+  namespace ModelCache
+  {
+    // Bump this whenever the cooked layout or the import processing changes.
+    constexpr uint32_t cookedModelVersion = 5;
+
+    // Hash the contents of the source file together with the import flags.
+    // Returns false if the source file can't be read.
+    bool computeSourceKey(const std::string &filepath, uint importFlags,
+                          uint64_t &outKey);
+
+    // Where the cooked model for a source file and key lives.
+    std::string getCookedPath(const std::string &filepath, uint64_t sourceKey);
+
+    // Fill an empty model from its cooked file. Returns false if there is no
+    // cooked file for the key or it's stale or damaged, in which case the
+    // model may be partially filled and needs to be unloaded.
+    bool readCookedModel(Model &model, const std::string &filepath, uint64_t sourceKey);
+
+    // Cook a loaded model. The file is written next to its final location and
+    // renamed into place so readers never see a partial file.
+    bool writeCookedModel(Model &model, const std::string &filepath, uint64_t sourceKey);
+
+    // Read just the vertices, indices and levels of detail of one submesh back
+    // in, from the offset recorded when the model was cooked or read.
+    bool readCookedMesh(Mesh &mesh, const std::string &filepath, uint64_t sourceKey);
+  }
+}
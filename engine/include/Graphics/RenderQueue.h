@@ -0,0 +1,49 @@
+#pragma once
+
+// Macro include file.
+#include "StrontiumPCH.h"
+
+// Project includes.
+#include "Core/ApplicationBase.h"
+
+// STL includes.
+#include <cstdint>
+
+namespace Strontium
+{
+  // Sort keys for the render queues. Each draw item gets a 64-bit key which
+  // packs, from the most significant bits down:
+  //
+  //   shader (4) | texture set (12) | material (16) | mesh (16) | LOD (3) | depth (13)
+  //
+  // so sorting the keys groups draws by the state they need, and draws with
+  // the same state go front to back. The IDs are small per-frame indices,
+  // not pointers. IDs wider than their field wrap, which only costs some
+  // extra state changes.
+  namespace RenderQueue
+  {
+    constexpr uint shaderBits = 4;
+    constexpr uint textureSetBits = 12;
+    constexpr uint materialBits = 16;
+    constexpr uint meshBits = 16;
+    constexpr uint lodBits = 3;
+    constexpr uint depthBits = 13;
+
+    // A key and the index of the draw item it belongs to.
+    struct SortEntry
+    {
+      uint64_t key;
+      uint index;
+    };
+
+    // Pack a key. Depth is the distance to the camera over the far plane
+    // distance, and is clamped to [0, 1].
+    uint64_t makeKey(uint shader, uint textureSet, uint material, uint mesh,
+                     uint lod, float depth);
+
+    // Stable LSD radix sort on the keys, a byte at a time. Passes where every
+    // key has the same byte are skipped, so the unused high bits are free.
+    // The scratch vector is resized as needed and can be reused every frame.
+    void radixSort(std::vector<SortEntry> &entries, std::vector<SortEntry> &scratch);
+  }
+}
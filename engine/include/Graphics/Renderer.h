@@ -1,7 +1,6 @@
 // Include guard.
 #pragma once
 
-#define NUM_CASCADES 4
 #define MAX_NUM_BLOOM_MIPS 7
 
 // Macro include file.
@@ -15,6 +14,11 @@
 #include "Graphics/Shaders.h"
 #include "Graphics/FrameBuffer.h"
 #include "Graphics/GeometryBuffer.h"
+#include "Graphics/GeometryArena.h"
+#include "Graphics/RenderQueue.h"
+#include "Graphics/StateCache.h"
+#include "Graphics/Culling.h"
+#include "Graphics/UniformBlocks.h"
 
 #include "Graphics/EnvironmentMap.h"
 #include "Graphics/Meshes.h"
@@ -40,6 +44,41 @@ namespace Strontium
   // The 3D renderer!
   namespace Renderer3D
   {
+    // An indirect draw command and the material it's drawn with.
+    struct IndirectDraw
+    {
+      Material* material;
+      DrawElementsIndirectCommand command;
+      InstanceData instance;
+    };
+
+    // A submesh waiting to be drawn in the geometry pass, and its sort key.
+    // Static items with the same submesh, material and level of detail are
+    // grouped into instanced draws.
+    struct DrawItem
+    {
+      uint64_t key;
+      Mesh* submesh;
+      Material* material;
+      Animator* animation; // Only set for skinned submeshes.
+      uint lod;
+      InstanceData instance;
+    };
+
+    // A submesh gathered for culling, with the transform it's drawn with.
+    // The animation is only set for skinned submeshes, and the materials and
+    // mask are only set for the geometry pass.
+    struct CullItem
+    {
+      Mesh* submesh;
+      ModelMaterial* materials;
+      Animator* animation;
+      glm::mat4 transform;
+      glm::vec4 maskColourID;
+      bool isStatic;
+      bool selected;
+    };
+
     // The renderer storage.
     struct RendererStorage
     {
@@ -61,8 +100,7 @@ namespace Strontium
 
       // Uniform buffers.
       UniformBuffer camBuffer;
-      UniformBuffer transformBuffer;
-      UniformBuffer editorBuffer;
+      UniformRingBuffer drawDataBuffer; // Model and editor blocks, written per draw.
       UniformBuffer ambientPassBuffer;
       UniformBuffer directionalPassBuffer;
       UniformBuffer pointPassBuffer; // TEMP until tiled deferred is implemented.
@@ -96,10 +134,52 @@ namespace Strontium
       std::vector<std::tuple<Model*, ModelMaterial*, glm::mat4, uint, bool>> staticRenderQueue;
       std::vector<std::tuple<Model*, Animator*, ModelMaterial*, glm::mat4, uint, bool>> dynamicRenderQueue;
 
+      // Index ranges of the visible meshlets of the submesh being drawn.
+      std::vector<int> meshletCounts;
+      std::vector<const void*> meshletOffsets;
+
+      // Submeshes for the geometry pass, sorted by their keys before drawing.
+      std::vector<DrawItem> drawItems;
+      std::vector<RenderQueue::SortEntry> sortEntries;
+      std::vector<RenderQueue::SortEntry> sortScratch;
+
+      // Per-frame IDs packed into the sort keys.
+      std::unordered_map<const void*, uint> shaderSortIDs;
+      std::unordered_map<const void*, uint> materialSortIDs;
+      std::unordered_map<const void*, uint> meshSortIDs;
+      std::unordered_map<std::string, uint> textureSetIDs;
+      std::unordered_map<const void*, uint> materialTextureSets;
+
+      // Static geometry drawn from the geometry arena, and the material of
+      // each uploaded command.
+      std::vector<IndirectDraw> indirectDraws;
+      std::vector<DrawElementsIndirectCommand> indirectCommands;
+      std::vector<Material*> indirectMaterials;
+
+      // Per-instance data for both of the above. Grows as needed.
+      std::vector<InstanceData> instances;
+      Unique<ShaderStorageBuffer> instanceBuffer;
+
       // Items for the shadow pass.
       std::vector<std::pair<Model*, glm::mat4>> staticShadowQueue;
       std::vector<std::tuple<Model*, Animator*, glm::mat4>> dynamicShadowQueue;
 
+      // World bounds of every shadow caster, if the scene submitted them.
+      // Otherwise they're gathered from the shadow queues.
+      bool hasCasterBounds;
+      glm::vec3 casterMin;
+      glm::vec3 casterMax;
+
+      // Submeshes of the queues, their world space bounds and the visible
+      // lists for the camera and each cascade.
+      std::vector<CullItem> cameraCullItems;
+      std::vector<CullItem> shadowCullItems;
+      CullingBounds cameraBounds;
+      CullingBounds shadowBounds;
+      FrustumCuller cameraCuller;
+      FrustumCuller shadowCuller;
+      Frustum cascadeFrustums[NUM_CASCADES];
+
       glm::mat4 cascades[NUM_CASCADES];
       glm::vec4 cascadeSplits[NUM_CASCADES];
       bool hasCascades;
@@ -116,16 +196,13 @@ namespace Strontium
 
       RendererStorage()
         : blankVAO()
-        , camBuffer(3 * sizeof(glm::mat4) + 2 * sizeof(glm::vec4), BufferType::Dynamic)
-        , transformBuffer(sizeof(glm::mat4), BufferType::Dynamic)
-        , editorBuffer(sizeof(glm::vec4), BufferType::Dynamic)
+        , camBuffer(sizeof(CameraBlockData), BufferType::Dynamic)
+        , drawDataBuffer(1024 * 1024)
         , ambientPassBuffer(sizeof(glm::vec4), BufferType::Dynamic)
         , directionalPassBuffer(2 * sizeof(glm::vec4) + sizeof(glm::ivec4), BufferType::Dynamic)
         , pointPassBuffer(sizeof(PointLight), BufferType::Dynamic)
         , cascadeShadowPassBuffer(sizeof(glm::mat4), BufferType::Dynamic)
-        , cascadeShadowBuffer(NUM_CASCADES * sizeof(glm::mat4)
-                              + NUM_CASCADES * sizeof(glm::vec4) + 2 * sizeof(glm::vec4),
-                              BufferType::Dynamic)
+        , cascadeShadowBuffer(sizeof(CascadedShadowBlockData), BufferType::Dynamic)
         , postProcessSettings(2 * sizeof(glm::vec4) + sizeof(glm::ivec4), BufferType::Dynamic)
         , boneBuffer(MAX_BONES_PER_MODEL * sizeof(glm::mat4), BufferType::Dynamic)
         , lightShaftSettingsBuffer(2 * sizeof(glm::vec4), BufferType::Dynamic)
@@ -133,6 +210,8 @@ namespace Strontium
         , aoParamsBuffer(sizeof(glm::vec4), BufferType::Dynamic)
       {
         currentEnvironment = createUnique<EnvironmentMap>();
+        instanceBuffer = createUnique<ShaderStorageBuffer>(1024 * sizeof(InstanceData),
+                                                           BufferType::Dynamic);
       }
     };
 
@@ -145,6 +224,27 @@ namespace Strontium
       // Settings for rendering.
       bool isForward;
       bool frustumCull;
+      bool packedVertices;
+
+      // Largest simplification error allowed on screen when picking a mesh
+      // level of detail, in pixels. Zero always draws the full meshes.
+      float lodErrorThreshold;
+
+      // Cull the meshlets of full detail submeshes against the frustum, and
+      // optionally against their normal cones. Cone culling drops back faces,
+      // so it's only correct for single-sided geometry.
+      bool meshletCull;
+      bool meshletConeCull;
+
+      // Draw the static geometry from the shared geometry arena, with one
+      // multi-draw-indirect per material.
+      bool indirectDraws;
+
+      // Group repeated static submeshes into instanced draws.
+      bool instancing;
+
+      // Sort the geometry pass by shader, textures, material and depth.
+      bool sortRenderQueue;
 
       // Environment map settings.
       uint skyboxWidth;
@@ -192,6 +292,13 @@ namespace Strontium
         : currentFrame(0)
         , isForward(false)
         , frustumCull(false)
+        , packedVertices(false)
+        , lodErrorThreshold(1.0f)
+        , meshletCull(false)
+        , meshletConeCull(false)
+        , indirectDraws(false)
+        , instancing(true)
+        , sortRenderQueue(true)
         , skyboxWidth(512)
         , irradianceWidth(128)
         , prefilterWidth(512)
@@ -221,12 +328,22 @@ namespace Strontium
     struct RendererStats
     {
       uint drawCalls;
+      uint drawCallsSaved;
+      uint materialBindsSkipped;
       uint numVertices;
       uint numTriangles;
+      uint trianglesSaved;
+      uint meshletsCulled;
+      uint64_t vertexBytes;
+      uint64_t arenaUsedBytes;
+      uint64_t arenaCapacityBytes;
+      uint drawDataBytes;
+      uint drawDataFrameBytes;
       uint numDirLights;
       uint numPointLights;
       uint numSpotLights;
 
+      float cullFrametime;
       float geoFrametime;
       float shadowFrametime;
       float lightFrametime;
@@ -234,11 +351,21 @@ namespace Strontium
 
       RendererStats()
         : drawCalls(0)
+        , drawCallsSaved(0)
+        , materialBindsSkipped(0)
         , numVertices(0)
         , numTriangles(0)
+        , trianglesSaved(0)
+        , meshletsCulled(0)
+        , vertexBytes(0)
+        , arenaUsedBytes(0)
+        , arenaCapacityBytes(0)
+        , drawDataBytes(0)
+        , drawDataFrameBytes(0)
         , numDirLights(0)
         , numPointLights(0)
         , numSpotLights(0)
+        , cullFrametime(0.0f)
         , geoFrametime(0.0f)
         , shadowFrametime(0.0f)
         , lightFrametime(0.0f)
@@ -256,6 +383,9 @@ namespace Strontium
 
     // Draw the data given, forward rendering.
     void draw(VertexArray* data, Shader* program);
+    void drawRanges(VertexArray* data, Shader* program, const int* counts,
+                    const void* const* offsets, uint numRanges);
+    void drawInstanced(VertexArray* data, Shader* program, uint numInstances);
     void drawEnvironment();
 
     // Generic begin and end for the renderer.
@@ -271,5 +401,9 @@ namespace Strontium
     void submit(DirectionalLight light, const glm::mat4 &model);
     void submit(PointLight light, const glm::mat4 &model);
     void submit(SpotLight light, const glm::mat4 &model);
+
+    // World space bounds of everything submitted this frame, for scenes which
+    // already track them. Saves walking the queues to fit the cascades.
+    void submitSceneBounds(const glm::vec3 &min, const glm::vec3 &max);
   }
 }
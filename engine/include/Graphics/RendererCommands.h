@@ -59,6 +59,10 @@ namespace Strontium
     void setViewport(const glm::ivec2 topRight, const glm::ivec2 bottomLeft = glm::ivec2(0));
 
     void drawElements(PrimativeType primative, uint count, const void* indices = nullptr);
+    void multiDrawElements(PrimativeType primative, const int* counts,
+                           const void* const* indices, uint drawCount);
+    void drawElementsInstanced(PrimativeType primative, uint count, uint numInstances,
+                               const void* indices = nullptr);
     void drawArrays(PrimativeType primative, uint start, uint count);
     void cullType(FaceType face);
   };
@@ -18,7 +18,12 @@ namespace Strontium
     Unknown
   };
 
-  enum class AttribType { Vec4, Vec3, Vec2, IVec4, IVec3, IVec2 };
+  enum class AttribType
+  {
+    Vec4, Vec3, Vec2, IVec4, IVec3, IVec2, UVec4,
+    // Compact attributes for packed vertices.
+    Short2, Half2, Int2101010, UByte4, IUByte4
+  };
   enum class UniformType
   {
     Float = 0x1406, // GL_FLOAT
@@ -34,6 +39,27 @@ namespace Strontium
     Unknown
   };
 
+  // Location of an active uniform, resolved once by name. Invalid handles
+  // are ignored by the setters, like OpenGL does for location -1.
+  struct UniformHandle
+  {
+    int location;
+
+    UniformHandle(int location = -1)
+      : location(location)
+    { }
+
+    bool isValid() const { return location >= 0; }
+  };
+
+  // An active uniform found when the program was linked.
+  struct UniformInfo
+  {
+    int location;
+    int size;
+    UniformType type;
+  };
+
   enum class MemoryBarrierType
   {
     ShaderImageAccess = 0x00000020 // GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
@@ -66,7 +92,33 @@ namespace Strontium
 
     void launchCompute(uint globalX, uint globalY, uint globalZ);
 
-    // Setters for shader uniforms.
+    // Uniforms and uniform blocks are reflected when the program is linked.
+    // The link count changes every time the shader is rebuilt, so handles
+    // cached outside the shader know when to be resolved again.
+    UniformHandle getUniformHandle(const std::string &uniformName);
+    int getUniformBlockBinding(const std::string &blockName);
+    std::unordered_map<std::string, UniformInfo>& getUniforms() { return this->uniforms; }
+    std::unordered_map<std::string, int>& getUniformBlocks() { return this->uniformBlocks; }
+    uint getLinkCount() const { return this->linkCount; }
+
+    // Setters for shader uniforms by handle. These don't need the shader to
+    // be bound.
+    void addUniformMatrix(UniformHandle handle, const glm::mat4 &matrix,
+                          bool transpose);
+    void addUniformMatrix(UniformHandle handle, const glm::mat3 &matrix,
+                          bool transpose);
+    void addUniformMatrix(UniformHandle handle, const glm::mat2 &matrix,
+                          bool transpose);
+    void addUniformVector(UniformHandle handle, const glm::vec4 &vector);
+    void addUniformVector(UniformHandle handle, const glm::vec3 &vector);
+    void addUniformVector(UniformHandle handle, const glm::vec2 &vector);
+    void addUniformFloat(UniformHandle handle, float value);
+    void addUniformInt(UniformHandle handle, int value);
+    void addUniformUInt(UniformHandle handle, uint value);
+
+    void addUniformSampler(UniformHandle handle, uint texID);
+
+    // Setters for shader uniforms by name.
     void addUniformMatrix(const char* uniformName, const glm::mat4 &matrix,
                           bool transpose);
     void addUniformMatrix(const char* uniformName, const glm::mat3 &matrix,
@@ -83,11 +135,21 @@ namespace Strontium
     void addUniformSampler(const char* uniformName, uint texID);
 
   private:
+    static UniformType uniformTypeFromGL(uint glType);
+
     void loadFile(const std::string &filepath);
     uint compileStage(const ShaderStage &stage, const std::string &stageSource);
     void linkProgram(const std::vector<uint> &binaries);
+    void reflect();
 
     uint progID;
+    uint linkCount;
+
+    // Reflected uniforms and block bindings, and the units the samplers were
+    // last set to indexed by location (-1 if unknown).
+    std::unordered_map<std::string, UniformInfo> uniforms;
+    std::unordered_map<std::string, int> uniformBlocks;
+    std::vector<int> samplerUnits;
 
     std::unordered_map<ShaderStage, std::string> shaderSources;
     std::string shaderPath;
@@ -0,0 +1,69 @@
+#pragma once
+
+#define MAX_CACHED_TEXTURE_UNITS 32
+
+// Macro include file.
+#include "StrontiumPCH.h"
+
+// Project includes.
+#include "Core/ApplicationBase.h"
+
+namespace Strontium
+{
+  // The graphics API calls made by the state cache. The default backend calls
+  // straight into OpenGL. A backend which counts the calls can be swapped in
+  // to test the filtering without a graphics context.
+  class StateCacheBackend
+  {
+  public:
+    virtual ~StateCacheBackend() = default;
+
+    virtual void useProgram(uint programID) = 0;
+    virtual void bindVertexArray(uint arrayID) = 0;
+    virtual void activeTexture(uint unit) = 0;
+    virtual void bindTexture(uint target, uint textureID) = 0;
+  };
+
+  struct StateCacheStats
+  {
+    uint bindsIssued;
+    uint bindsSkipped;
+
+    StateCacheStats()
+      : bindsIssued(0)
+      , bindsSkipped(0)
+    { }
+  };
+
+  // Shadow copy of the bound program, vertex array, active texture unit and
+  // textures per unit, so binds of what's already bound never reach the
+  // driver. Every bind of these in the engine goes through here. Code which
+  // changes them behind the cache's back has to call invalidate(). Only
+  // safe to use on the thread with the graphics context.
+  namespace StateCache
+  {
+    // Swap the backend. Nullptr restores the OpenGL backend. The cached state
+    // is forgotten, since the new backend's state is unknown.
+    void setBackend(StateCacheBackend* backend);
+
+    void useProgram(uint programID);
+    void bindVertexArray(uint arrayID);
+    void activeTexture(uint unit);
+
+    // Bind to the active unit, or to the given unit. Binding to a unit the
+    // texture is already bound to doesn't change the active unit.
+    void bindTexture(uint target, uint textureID);
+    void bindTexture(uint unit, uint target, uint textureID);
+
+    // Deleted objects are unbound by the driver, and their names reused.
+    void forgetProgram(uint programID);
+    void forgetVertexArray(uint arrayID);
+    void forgetTexture(uint textureID);
+
+    // Forget everything.
+    void invalidate();
+
+    StateCacheStats& getStats();
+    void resetStats();
+  }
+}
@@ -0,0 +1,75 @@
+// Include guard.
+#pragma once
+
+#define NUM_CASCADES 4
+
+// Macro include file.
+#include "StrontiumPCH.h"
+
+// Project includes.
+#include "Core/ApplicationBase.h"
+#include "Graphics/Buffers.h"
+
+// STL includes.
+#include <cstddef>
+
+namespace Strontium
+{
+  // Kept out of Renderer.h so the layouts can be checked without the rest
+  // of the graphics code.
+  namespace Renderer3D
+  {
+    // Per-instance data for instanced and indirect draws. Matches the
+    // InstanceBlock of the instanced and indirect shaders.
+    struct InstanceData
+    {
+      glm::mat4 modelMatrix;
+      glm::vec4 maskColourID;
+    };
+
+    // CPU copies of uniform blocks, filled and uploaded in one call. The
+    // layouts are checked against the std140 rules below, so a block that
+    // drifts from its shader declaration fails to compile.
+    struct CameraBlockData
+    {
+      glm::mat4 viewMatrix;
+      glm::mat4 projMatrix;
+      glm::mat4 invViewProjMatrix;
+      glm::vec4 camPosition; // vec3 in the shader, padded to a vec4.
+      glm::vec4 nearFar; // Near plane (x), far plane (y). z and w are unused.
+    };
+
+    struct ModelBlockData
+    {
+      glm::mat4 modelMatrix;
+      glm::vec4 vertexFormat;
+    };
+
+    struct CascadedShadowBlockData
+    {
+      glm::mat4 lightVP[NUM_CASCADES];
+      glm::vec4 cascadeData[NUM_CASCADES];
+      glm::vec4 shadowParams[2];
+    };
+
+    static_assert(offsetof(CameraBlockData, projMatrix) == Std140::next(0, Std140::mat4Size));
+    static_assert(offsetof(CameraBlockData, invViewProjMatrix)
+                  == Std140::next(offsetof(CameraBlockData, projMatrix), Std140::mat4Size));
+    static_assert(offsetof(CameraBlockData, camPosition)
+                  == Std140::next(offsetof(CameraBlockData, invViewProjMatrix), Std140::mat4Size));
+    static_assert(offsetof(CameraBlockData, nearFar)
+                  == Std140::next(offsetof(CameraBlockData, camPosition), 3 * Std140::scalarSize));
+    static_assert(sizeof(CameraBlockData) == 3 * Std140::mat4Size + 2 * Std140::vec4Size);
+
+    static_assert(offsetof(ModelBlockData, vertexFormat) == Std140::next(0, Std140::mat4Size));
+    static_assert(sizeof(ModelBlockData) == Std140::mat4Size + Std140::vec4Size);
+
+    static_assert(offsetof(CascadedShadowBlockData, cascadeData)
+                  == Std140::next(0, NUM_CASCADES * Std140::mat4Size));
+    static_assert(offsetof(CascadedShadowBlockData, shadowParams)
+                  == Std140::next(offsetof(CascadedShadowBlockData, cascadeData),
+                                  NUM_CASCADES * Std140::vec4Size));
+    static_assert(sizeof(CascadedShadowBlockData)
+                  == NUM_CASCADES * (Std140::mat4Size + Std140::vec4Size) + 2 * Std140::vec4Size);
+  }
+}
@@ -5,6 +5,7 @@
 
 // Project includes.
 #include "Core/ApplicationBase.h"
+#include "Core/BVH.h"
 #include "Graphics/ShadingPrimatives.h"
 
 // Entity component system include.
@@ -13,6 +14,7 @@
 namespace Strontium
 {
   class Entity;
+  class Model;
 
   class Scene
   {
@@ -32,6 +34,10 @@ namespace Strontium
 
     Entity getPrimaryCameraEntity();
 
+    // World bounds of the renderables as of the last render, keyed by entity
+    // ID. For frustum, ray and sphere queries over the scene.
+    const BVH& getRenderableBVH() const { return this->renderableBVH; }
+
     entt::registry& getRegistry() { return this->sceneECS; }
     std::string& getSaveFilepath() { return this->saveFilepath; }
   protected:
@@ -39,7 +45,13 @@ namespace Strontium
 
     void updateAnimations(float dt);
 
+    // Keep the BVH in step with the renderables. Bounds which haven't changed
+    // since the last frame are skipped, so only moved renderables are refit.
+    void updateBounds(entt::entity entity, Model* model, const glm::mat4 &transform);
+    void commitBounds(uint numBounded);
+
     entt::registry sceneECS;
+    BVH renderableBVH;
 
     std::string saveFilepath;
 
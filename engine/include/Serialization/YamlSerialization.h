@@ -7,6 +7,7 @@
 #include "Core/ApplicationBase.h"
 #include "Assets/AssetManager.h"
 #include "Scenes/Scene.h"
+#include "Core/ThreadPool.h"
 
 namespace Strontium
 {
@@ -20,6 +21,8 @@ namespace Strontium
                            const std::string &filepath);
     void serializePrefab(Entity prefab, const std::string &filepath,
                          const std::string &name = "Untitled Prefab");
+    void serializeThreadPoolStats(const ThreadPoolStats &stats,
+                                  const std::string &filepath);
 
     bool deserializeScene(Shared<Scene> scene, const std::string &filepath);
     bool deserializeMaterial(const std::string &filepath, AssetHandle &handle, bool override = false);
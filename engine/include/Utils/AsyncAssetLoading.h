@@ -18,9 +18,57 @@ namespace Strontium
     void asyncLoadModel(const std::string &filepath, const std::string &name,
                         uint entityID, Scene* activeScene);
 
-    // Async load an image.
+    // Cancel every model load tied to a scene, including loads which have
+    // finished but haven't been attached to the scene yet. Imports which are
+    // already running bail out as soon as they can.
+    void cancelSceneLoads(Scene* scene);
+
+    // Caps on the texture upload work done on the main thread each frame.
+    // Uploads stop once either cap would be exceeded, but at least one texture
+    // is uploaded each frame so large textures still make progress.
+    struct UploadBudget
+    {
+      float maxMilliseconds;
+      uint64_t maxBytes;
+
+      UploadBudget(float maxMilliseconds = 4.0f, uint64_t maxBytes = 64 * 1024 * 1024);
+    };
+
+    // Decoded textures waiting on an upload.
+    struct PendingUploads
+    {
+      uint numTextures = 0;
+      uint64_t numBytes = 0;
+
+      // Time spent uploading in the last frame.
+      float lastFrameMilliseconds = 0.0f;
+    };
+
+    void setUploadBudget(const UploadBudget &budget);
+    UploadBudget getUploadBudget();
+    PendingUploads getPendingUploads();
+
+    // Where a requested texture is in the loading pipeline.
+    enum class TextureLoadState
+    {
+      None,    // Never requested.
+      Pending, // Waiting on a worker to decode it.
+      Loading, // Being decoded.
+      Ready,   // Uploaded and in the texture cache.
+      Failed   // Couldn't be opened or decoded.
+    };
+
+    // Async load an image. Always decodes the image again, unless it's
+    // already being loaded.
     void bulkGenerateTextures();
     void loadImageAsync(const std::string &filepath,
                         const Texture2DParams &params = Texture2DParams());
+
+    // Async load an image only if it isn't already loaded or being loaded.
+    // Requests are tracked by canonical path, so every material sharing a
+    // texture shares one decode.
+    void requestTexture(const std::string &filepath,
+                        const Texture2DParams &params = Texture2DParams());
+    TextureLoadState getTextureState(const std::string &filepath);
   };
 }
@@ -0,0 +1,45 @@
+#pragma once
+
+// Macro include file.
+#include "StrontiumPCH.h"
+
+// Project includes.
+#include "Core/ApplicationBase.h"
+
+// STL includes.
+#include <cstdint>
+
+namespace Strontium
+{
+  // A read-only view of a file mapped into memory. Pages are only read from
+  // disk as they're touched, so large files can be opened without copying
+  // them into a buffer first.
+  class MappedFile
+  {
+  public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile &operator=(const MappedFile&) = delete;
+
+    // Map the entire file. Returns false if the file couldn't be opened or
+    // is empty.
+    bool open(const std::string &filepath);
+    void close();
+
+    bool isOpen() const { return this->fileData != nullptr; }
+    const uint8_t* data() const { return this->fileData; }
+    std::size_t size() const { return this->fileSize; }
+  private:
+    const uint8_t* fileData;
+    std::size_t fileSize;
+
+#ifdef WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fileDescriptor;
+#endif
+  };
+}
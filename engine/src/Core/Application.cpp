@@ -4,6 +4,7 @@
 #include "Core/Events.h"
 #include "Core/Logs.h"
 #include "Utils/AsyncAssetLoading.h"
+#include "Serialization/YamlSerialization.h"
 
 namespace Strontium
 {
@@ -33,7 +34,7 @@ namespace Strontium
     this->appWindow = Window::getNewInstance(this->name);
 
     // Initialize the thread pool.
-    workerGroup = Unique<ThreadPool>(ThreadPool::getInstance(4));
+    workerGroup = Unique<ThreadPool>(ThreadPool::getInstance());
 
     // Init the shader cache.
     ShaderCache::init("./assets/shaders/shaderManifest.yaml");
@@ -63,6 +64,14 @@ namespace Strontium
 
   Application::~Application()
   {
+    // Stop the workers before anything they touch is torn down. Queued loads
+    // aren't worth finishing on the way out.
+    this->workerGroup->shutdown(ShutdownMode::Cancel);
+
+    // Dump the pool stats if asked to, used to track load throughput.
+    if (const char* statsPath = std::getenv("SR_THREAD_POOL_STATS"))
+      YAMLSerialization::serializeThreadPoolStats(this->workerGroup->getStats(), statsPath);
+
     // Detach each layer and delete it.
     for (auto layer : this->layerStack)
 		{
@@ -137,7 +146,7 @@ namespace Strontium
         this->appWindow->onUpdate();
 
       // Must be called at the end of every frame to create textures with loaded
-      // images.
+      // images. Texture uploads are spread over frames by the upload budget.
       AsyncLoading::bulkGenerateTextures();
       AsyncLoading::bulkGenerateMaterials();
     }
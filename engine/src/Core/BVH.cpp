@@ -0,0 +1,664 @@
+#include "Core/BVH.h"
+
+namespace Strontium
+{
+  namespace
+  {
+    constexpr uint invalidIndex = std::numeric_limits<uint>::max();
+
+    float
+    surfaceArea(const glm::vec3 &min, const glm::vec3 &max)
+    {
+      const float dx = max.x - min.x;
+      const float dy = max.y - min.y;
+      const float dz = max.z - min.z;
+      return 2.0f * (dx * dy + dy * dz + dz * dx);
+    }
+
+    bool
+    sameBounds(const glm::vec3 &minA, const glm::vec3 &maxA,
+               const glm::vec3 &minB, const glm::vec3 &maxB)
+    {
+      return minA.x == minB.x && minA.y == minB.y && minA.z == minB.z
+             && maxA.x == maxB.x && maxA.y == maxB.y && maxA.z == maxB.z;
+    }
+
+    // Squared distance from a point to the closest point in a box.
+    float
+    boxPointDistance2(const glm::vec3 &min, const glm::vec3 &max, const glm::vec3 &point)
+    {
+      float distance2 = 0.0f;
+      for (uint i = 0; i < 3; i++)
+      {
+        const float d = std::max(std::max(min[i] - point[i], 0.0f), point[i] - max[i]);
+        distance2 += d * d;
+      }
+      return distance2;
+    }
+
+    // Slab test. Returns the distance the ray enters the box at, or a
+    // negative number on a miss.
+    float
+    rayBoxDistance(const glm::vec3 &min, const glm::vec3 &max, const glm::vec3 &origin,
+                   const glm::vec3 &invDirection, float maxDistance)
+    {
+      float tNear = 0.0f;
+      float tFar = maxDistance;
+      for (uint i = 0; i < 3; i++)
+      {
+        const float t1 = (min[i] - origin[i]) * invDirection[i];
+        const float t2 = (max[i] - origin[i]) * invDirection[i];
+        tNear = std::max(tNear, std::min(t1, t2));
+        tFar = std::min(tFar, std::max(t1, t2));
+      }
+
+      return tNear <= tFar ? tNear : -1.0f;
+    }
+
+    // Frustum test of a box against the planes left in the mask. Planes the
+    // box is entirely in front of are cleared from the mask, since every box
+    // inside it passes them too.
+    bool
+    boxInFrustumPlanes(const Frustum &frustum, const glm::vec3 &min, const glm::vec3 &max,
+                       uint &planeMask)
+    {
+      const BoundingBox box = buildBoundingBox(min, max);
+      for (uint i = 0; i < 6; i++)
+      {
+        if (!(planeMask & (1u << i)))
+          continue;
+
+        auto& plane = frustum.sides[i];
+        const float r = box.extents.x * std::abs(plane.normal.x) +
+                        box.extents.y * std::abs(plane.normal.y) +
+                        box.extents.z * std::abs(plane.normal.z);
+        const float distance = signedPlaneDistance(plane, box.center);
+        if (!(-r <= distance))
+          return false;
+        if (distance - r >= 0.0f)
+          planeMask &= ~(1u << i);
+      }
+
+      return true;
+    }
+  }
+
+  BVH::BVH()
+    : structureDirty(false)
+    , refitsSinceCheck(0)
+    , rebuildThreshold(1.5f)
+    , buildCost(0.0f)
+  { }
+
+  void
+  BVH::insert(uint id, const glm::vec3 &min, const glm::vec3 &max)
+  {
+    auto loc = this->objectLookup.find(id);
+    if (loc == this->objectLookup.end())
+    {
+      this->objectLookup.emplace(id, static_cast<uint>(this->objects.size()));
+      this->objects.push_back({ min, max, invalidIndex, false });
+      this->objectIDs.push_back(id);
+      this->structureDirty = true;
+      return;
+    }
+
+    auto& object = this->objects[loc->second];
+    if (sameBounds(object.min, object.max, min, max))
+      return;
+
+    object.min = min;
+    object.max = max;
+    if (!object.dirty && !this->structureDirty)
+    {
+      object.dirty = true;
+      this->dirtyObjects.push_back(loc->second);
+    }
+  }
+
+  void
+  BVH::remove(uint id)
+  {
+    auto loc = this->objectLookup.find(id);
+    if (loc == this->objectLookup.end())
+      return;
+
+    // Swap the last object into the removed one's place.
+    const uint index = loc->second;
+    const uint last = static_cast<uint>(this->objects.size()) - 1;
+    if (index != last)
+    {
+      this->objects[index] = this->objects[last];
+      this->objectIDs[index] = this->objectIDs[last];
+      this->objectLookup[this->objectIDs[index]] = index;
+    }
+    this->objects.pop_back();
+    this->objectIDs.pop_back();
+    this->objectLookup.erase(id);
+
+    this->structureDirty = true;
+  }
+
+  bool
+  BVH::contains(uint id) const
+  {
+    return this->objectLookup.find(id) != this->objectLookup.end();
+  }
+
+  void
+  BVH::clear()
+  {
+    this->nodes.clear();
+    this->objects.clear();
+    this->objectIDs.clear();
+    this->objectIndices.clear();
+    this->objectLookup.clear();
+    this->dirtyObjects.clear();
+    this->structureDirty = false;
+    this->refitsSinceCheck = 0;
+    this->buildCost = 0.0f;
+  }
+
+  bool
+  BVH::commit()
+  {
+    if (this->structureDirty)
+    {
+      this->build();
+      return true;
+    }
+
+    if (this->dirtyObjects.empty())
+      return false;
+
+    // Walking up from each moved box is cheaper until enough of them have
+    // moved that most of the nodes would be touched anyway.
+    const uint numDirty = static_cast<uint>(this->dirtyObjects.size());
+    if (numDirty * 8 > this->objects.size())
+      this->refit();
+    else
+    {
+      for (uint objectIndex : this->dirtyObjects)
+      {
+        this->refitPath(objectIndex);
+        this->objects[objectIndex].dirty = false;
+      }
+      this->dirtyObjects.clear();
+    }
+
+    this->refitsSinceCheck += numDirty;
+    if (this->refitsSinceCheck * 8 > this->objects.size())
+    {
+      this->refitsSinceCheck = 0;
+      if (this->getCost() > this->rebuildThreshold * this->buildCost)
+      {
+        this->build();
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  void
+  BVH::build()
+  {
+    this->nodes.clear();
+    this->dirtyObjects.clear();
+    this->structureDirty = false;
+    this->refitsSinceCheck = 0;
+    this->buildCost = 0.0f;
+
+    const uint numObjects = static_cast<uint>(this->objects.size());
+    if (numObjects == 0)
+    {
+      this->objectIndices.clear();
+      return;
+    }
+
+    this->objectIndices.resize(numObjects);
+    this->centroids.resize(numObjects);
+    for (uint i = 0; i < numObjects; i++)
+    {
+      this->objectIndices[i] = i;
+      this->centroids[i] = (this->objects[i].min + this->objects[i].max) * 0.5f;
+      this->objects[i].dirty = false;
+    }
+
+    // Every split adds two nodes and a leaf holds at least one box.
+    this->nodes.reserve(2 * numObjects - 1);
+    this->nodes.push_back({ glm::vec3(0.0f), 0, glm::vec3(0.0f), numObjects, invalidIndex });
+    this->refitLeaf(0);
+
+    this->buildStack.clear();
+    this->buildStack.push_back(0);
+    while (!this->buildStack.empty())
+    {
+      uint nodeIndex = this->buildStack.back();
+      this->buildStack.pop_back();
+      this->splitNode(nodeIndex);
+    }
+
+    this->buildCost = this->getCost();
+  }
+
+  // Split a node along the best binned SAH plane and queue the children, or
+  // leave it as a leaf if that's cheaper.
+  void
+  BVH::splitNode(uint nodeIndex)
+  {
+    const uint first = this->nodes[nodeIndex].firstIndex;
+    const uint count = this->nodes[nodeIndex].count;
+
+    auto makeLeaf = [this, nodeIndex, first, count]()
+    {
+      for (uint i = first; i < first + count; i++)
+        this->objects[this->objectIndices[i]].leaf = nodeIndex;
+    };
+
+    if (count <= 1)
+    {
+      makeLeaf();
+      return;
+    }
+
+    glm::vec3 centroidMin(std::numeric_limits<float>::max());
+    glm::vec3 centroidMax(-std::numeric_limits<float>::max());
+    for (uint i = first; i < first + count; i++)
+    {
+      centroidMin = glm::min(centroidMin, this->centroids[this->objectIndices[i]]);
+      centroidMax = glm::max(centroidMax, this->centroids[this->objectIndices[i]]);
+    }
+
+    // Costs are relative to the parent's area, with a traversal step costing
+    // as much as a box test.
+    const float parentArea = surfaceArea(this->nodes[nodeIndex].min, this->nodes[nodeIndex].max);
+    float bestCost = std::numeric_limits<float>::max();
+    uint bestAxis = invalidIndex;
+    uint bestSplit = 0;
+
+    // Small nodes don't need more bins than boxes, and sweeping the empty
+    // ones would be most of the build.
+    const uint numBins = std::min(count, static_cast<uint>(BVH_NUM_BINS));
+
+    Bin bins[BVH_NUM_BINS];
+    float rightAreas[BVH_NUM_BINS];
+    uint rightCounts[BVH_NUM_BINS];
+    for (uint axis = 0; axis < 3; axis++)
+    {
+      const float extent = centroidMax[axis] - centroidMin[axis];
+      if (!(extent > 0.0f))
+        continue;
+
+      for (uint b = 0; b < numBins; b++)
+        bins[b] = { glm::vec3(std::numeric_limits<float>::max()),
+                    glm::vec3(-std::numeric_limits<float>::max()), 0 };
+
+      const float scale = static_cast<float>(numBins) / extent;
+      for (uint i = first; i < first + count; i++)
+      {
+        const uint objectIndex = this->objectIndices[i];
+        uint b = static_cast<uint>((this->centroids[objectIndex][axis] - centroidMin[axis]) * scale);
+        b = std::min(b, numBins - 1);
+
+        bins[b].min = glm::min(bins[b].min, this->objects[objectIndex].min);
+        bins[b].max = glm::max(bins[b].max, this->objects[objectIndex].max);
+        bins[b].count++;
+      }
+
+      // Sweep from the right to get the area and count right of each plane,
+      // then from the left to cost each plane.
+      glm::vec3 sweepMin(std::numeric_limits<float>::max());
+      glm::vec3 sweepMax(-std::numeric_limits<float>::max());
+      uint sweepCount = 0;
+      for (uint b = numBins - 1; b > 0; b--)
+      {
+        sweepMin = glm::min(sweepMin, bins[b].min);
+        sweepMax = glm::max(sweepMax, bins[b].max);
+        sweepCount += bins[b].count;
+        rightAreas[b] = sweepCount > 0 ? surfaceArea(sweepMin, sweepMax) : 0.0f;
+        rightCounts[b] = sweepCount;
+      }
+
+      sweepMin = glm::vec3(std::numeric_limits<float>::max());
+      sweepMax = glm::vec3(-std::numeric_limits<float>::max());
+      sweepCount = 0;
+      for (uint b = 0; b < numBins - 1; b++)
+      {
+        sweepMin = glm::min(sweepMin, bins[b].min);
+        sweepMax = glm::max(sweepMax, bins[b].max);
+        sweepCount += bins[b].count;
+        if (sweepCount == 0 || rightCounts[b + 1] == 0)
+          continue;
+
+        const float cost = surfaceArea(sweepMin, sweepMax) * sweepCount
+                           + rightAreas[b + 1] * rightCounts[b + 1];
+        if (cost < bestCost)
+        {
+          bestCost = cost;
+          bestAxis = axis;
+          bestSplit = b;
+        }
+      }
+    }
+
+    if (bestAxis != invalidIndex)
+      bestCost = 1.0f + (parentArea > 0.0f ? bestCost / parentArea : static_cast<float>(count));
+    if (count <= BVH_MAX_LEAF_SIZE && (bestAxis == invalidIndex || bestCost >= static_cast<float>(count)))
+    {
+      makeLeaf();
+      return;
+    }
+
+    // Partition the node's range about the split plane. Boxes with the same
+    // centroid can't be split by any plane, so they're halved instead.
+    uint numLeft = count / 2;
+    if (bestAxis != invalidIndex)
+    {
+      const float extent = centroidMax[bestAxis] - centroidMin[bestAxis];
+      const float scale = static_cast<float>(numBins) / extent;
+      const glm::vec3 splitMin = centroidMin;
+      auto begin = this->objectIndices.begin() + first;
+      auto middle = std::partition(begin, begin + count, [&](uint objectIndex)
+      {
+        uint b = static_cast<uint>((this->centroids[objectIndex][bestAxis] - splitMin[bestAxis]) * scale);
+        return std::min(b, numBins - 1) <= bestSplit;
+      });
+      numLeft = static_cast<uint>(middle - begin);
+      if (numLeft == 0 || numLeft == count)
+        numLeft = count / 2;
+    }
+
+    const uint leftIndex = static_cast<uint>(this->nodes.size());
+    this->nodes.push_back({ glm::vec3(0.0f), first, glm::vec3(0.0f), numLeft, nodeIndex });
+    this->nodes.push_back({ glm::vec3(0.0f), first + numLeft, glm::vec3(0.0f),
+                            count - numLeft, nodeIndex });
+    this->refitLeaf(leftIndex);
+    this->refitLeaf(leftIndex + 1);
+
+    this->nodes[nodeIndex].firstIndex = leftIndex;
+    this->nodes[nodeIndex].count = 0;
+
+    this->buildStack.push_back(leftIndex + 1);
+    this->buildStack.push_back(leftIndex);
+  }
+
+  void
+  BVH::refit()
+  {
+    // Children are always after their parents, so walking backwards visits
+    // them first.
+    for (uint i = static_cast<uint>(this->nodes.size()); i-- > 0;)
+    {
+      auto& node = this->nodes[i];
+      if (node.count > 0)
+        this->refitLeaf(i);
+      else
+      {
+        node.min = glm::min(this->nodes[node.firstIndex].min, this->nodes[node.firstIndex + 1].min);
+        node.max = glm::max(this->nodes[node.firstIndex].max, this->nodes[node.firstIndex + 1].max);
+      }
+    }
+
+    for (uint objectIndex : this->dirtyObjects)
+      this->objects[objectIndex].dirty = false;
+    this->dirtyObjects.clear();
+  }
+
+  void
+  BVH::refitLeaf(uint nodeIndex)
+  {
+    auto& node = this->nodes[nodeIndex];
+    node.min = glm::vec3(std::numeric_limits<float>::max());
+    node.max = glm::vec3(-std::numeric_limits<float>::max());
+    for (uint i = node.firstIndex; i < node.firstIndex + node.count; i++)
+    {
+      node.min = glm::min(node.min, this->objects[this->objectIndices[i]].min);
+      node.max = glm::max(node.max, this->objects[this->objectIndices[i]].max);
+    }
+  }
+
+  // Refit the nodes from a box's leaf up, stopping at the first one whose
+  // bounds don't change.
+  void
+  BVH::refitPath(uint objectIndex)
+  {
+    uint nodeIndex = this->objects[objectIndex].leaf;
+    glm::vec3 oldMin = this->nodes[nodeIndex].min;
+    glm::vec3 oldMax = this->nodes[nodeIndex].max;
+    this->refitLeaf(nodeIndex);
+
+    while (!sameBounds(oldMin, oldMax, this->nodes[nodeIndex].min, this->nodes[nodeIndex].max))
+    {
+      nodeIndex = this->nodes[nodeIndex].parent;
+      if (nodeIndex == invalidIndex)
+        break;
+
+      auto& node = this->nodes[nodeIndex];
+      oldMin = node.min;
+      oldMax = node.max;
+      node.min = glm::min(this->nodes[node.firstIndex].min, this->nodes[node.firstIndex + 1].min);
+      node.max = glm::max(this->nodes[node.firstIndex].max, this->nodes[node.firstIndex + 1].max);
+    }
+  }
+
+  float
+  BVH::getCost() const
+  {
+    if (this->nodes.empty())
+      return 0.0f;
+
+    const float rootArea = surfaceArea(this->nodes[0].min, this->nodes[0].max);
+    if (!(rootArea > 0.0f))
+      return 0.0f;
+
+    float cost = 0.0f;
+    for (auto& node : this->nodes)
+    {
+      const float weight = node.count > 0 ? static_cast<float>(node.count) : 1.0f;
+      cost += weight * surfaceArea(node.min, node.max);
+    }
+
+    return cost / rootArea;
+  }
+
+  void
+  BVH::queryFrustum(const Frustum &frustum, std::vector<uint> &outIDs) const
+  {
+    assert(("BVH queried with uncommitted adds or removes.", !this->structureDirty));
+    if (this->nodes.empty())
+      return;
+
+    // Each entry is a node and the planes it still has to be tested against.
+    std::vector<std::pair<uint, uint>> stack;
+    stack.emplace_back(0, 0x3F);
+    while (!stack.empty())
+    {
+      auto [nodeIndex, planeMask] = stack.back();
+      stack.pop_back();
+
+      auto& node = this->nodes[nodeIndex];
+      if (planeMask && !boxInFrustumPlanes(frustum, node.min, node.max, planeMask))
+        continue;
+
+      if (node.count == 0)
+      {
+        stack.emplace_back(node.firstIndex + 1, planeMask);
+        stack.emplace_back(node.firstIndex, planeMask);
+        continue;
+      }
+
+      for (uint i = node.firstIndex; i < node.firstIndex + node.count; i++)
+      {
+        const uint objectIndex = this->objectIndices[i];
+        uint objectMask = planeMask;
+        auto& object = this->objects[objectIndex];
+        if (!objectMask || boxInFrustumPlanes(frustum, object.min, object.max, objectMask))
+          outIDs.push_back(this->objectIDs[objectIndex]);
+      }
+    }
+  }
+
+  void
+  BVH::querySphere(const glm::vec3 &center, float radius, std::vector<uint> &outIDs) const
+  {
+    assert(("BVH queried with uncommitted adds or removes.", !this->structureDirty));
+    if (this->nodes.empty())
+      return;
+
+    const float radius2 = radius * radius;
+    std::vector<uint> stack;
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+      auto& node = this->nodes[stack.back()];
+      stack.pop_back();
+
+      if (boxPointDistance2(node.min, node.max, center) > radius2)
+        continue;
+
+      if (node.count == 0)
+      {
+        stack.push_back(node.firstIndex + 1);
+        stack.push_back(node.firstIndex);
+        continue;
+      }
+
+      for (uint i = node.firstIndex; i < node.firstIndex + node.count; i++)
+      {
+        const uint objectIndex = this->objectIndices[i];
+        auto& object = this->objects[objectIndex];
+        if (boxPointDistance2(object.min, object.max, center) <= radius2)
+          outIDs.push_back(this->objectIDs[objectIndex]);
+      }
+    }
+  }
+
+  void
+  BVH::queryRay(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance,
+                std::vector<BVHRayHit> &outHits) const
+  {
+    assert(("BVH queried with uncommitted adds or removes.", !this->structureDirty));
+    if (this->nodes.empty())
+      return;
+
+    const glm::vec3 invDirection = 1.0f / direction;
+    const uint firstHit = static_cast<uint>(outHits.size());
+
+    std::vector<uint> stack;
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+      auto& node = this->nodes[stack.back()];
+      stack.pop_back();
+
+      if (rayBoxDistance(node.min, node.max, origin, invDirection, maxDistance) < 0.0f)
+        continue;
+
+      if (node.count == 0)
+      {
+        stack.push_back(node.firstIndex + 1);
+        stack.push_back(node.firstIndex);
+        continue;
+      }
+
+      for (uint i = node.firstIndex; i < node.firstIndex + node.count; i++)
+      {
+        const uint objectIndex = this->objectIndices[i];
+        auto& object = this->objects[objectIndex];
+        float distance = rayBoxDistance(object.min, object.max, origin, invDirection, maxDistance);
+        if (distance >= 0.0f)
+          outHits.push_back({ this->objectIDs[objectIndex], distance });
+      }
+    }
+
+    std::sort(outHits.begin() + firstHit, outHits.end(), [](const BVHRayHit &a, const BVHRayHit &b)
+    {
+      return a.distance < b.distance;
+    });
+  }
+
+  bool
+  BVH::raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance,
+               BVHRayHit &outHit) const
+  {
+    assert(("BVH queried with uncommitted adds or removes.", !this->structureDirty));
+    if (this->nodes.empty())
+      return false;
+
+    const glm::vec3 invDirection = 1.0f / direction;
+    float closest = maxDistance;
+    bool hit = false;
+
+    // Visit the nearer child first, so the closest hit so far can prune the
+    // farther one.
+    std::vector<std::pair<uint, float>> stack;
+    float rootDistance = rayBoxDistance(this->nodes[0].min, this->nodes[0].max, origin,
+                                        invDirection, closest);
+    if (rootDistance >= 0.0f)
+      stack.emplace_back(0, rootDistance);
+    while (!stack.empty())
+    {
+      auto [nodeIndex, nodeDistance] = stack.back();
+      stack.pop_back();
+      if (nodeDistance > closest)
+        continue;
+
+      auto& node = this->nodes[nodeIndex];
+      if (node.count == 0)
+      {
+        const uint left = node.firstIndex;
+        const uint right = node.firstIndex + 1;
+        float leftDistance = rayBoxDistance(this->nodes[left].min, this->nodes[left].max,
+                                            origin, invDirection, closest);
+        float rightDistance = rayBoxDistance(this->nodes[right].min, this->nodes[right].max,
+                                             origin, invDirection, closest);
+
+        if (leftDistance >= 0.0f && rightDistance >= 0.0f)
+        {
+          if (leftDistance <= rightDistance)
+          {
+            stack.emplace_back(right, rightDistance);
+            stack.emplace_back(left, leftDistance);
+          }
+          else
+          {
+            stack.emplace_back(left, leftDistance);
+            stack.emplace_back(right, rightDistance);
+          }
+        }
+        else if (leftDistance >= 0.0f)
+          stack.emplace_back(left, leftDistance);
+        else if (rightDistance >= 0.0f)
+          stack.emplace_back(right, rightDistance);
+        continue;
+      }
+
+      for (uint i = node.firstIndex; i < node.firstIndex + node.count; i++)
+      {
+        const uint objectIndex = this->objectIndices[i];
+        auto& object = this->objects[objectIndex];
+        float distance = rayBoxDistance(object.min, object.max, origin, invDirection, closest);
+        if (distance >= 0.0f && (!hit || distance < outHit.distance))
+        {
+          outHit = { this->objectIDs[objectIndex], distance };
+          closest = distance;
+          hit = true;
+        }
+      }
+    }
+
+    return hit;
+  }
+
+  bool
+  BVH::getBounds(glm::vec3 &outMin, glm::vec3 &outMax) const
+  {
+    if (this->nodes.empty())
+      return false;
+
+    outMin = this->nodes[0].min;
+    outMax = this->nodes[0].max;
+    return true;
+  }
+}
@@ -1,5 +1,10 @@
 #include "Core/Math.h"
 
+// SIMD includes.
+#if defined(SR_FRUSTUM_SIMD_AVX2) || defined(SR_FRUSTUM_SIMD_SSE2)
+  #include <immintrin.h>
+#endif
+
 namespace Strontium
 {
   BoundingBox
@@ -271,4 +276,128 @@ namespace Strontium
 
     return inFrustum;
   }
+
+  FrustumPlanes
+  packFrustumPlanes(const Frustum &frustum)
+  {
+    FrustumPlanes planes;
+    for (uint i = 0; i < 6; i++)
+    {
+      const Plane &side = frustum.sides[i];
+      planes.normalX[i] = side.normal.x;
+      planes.normalY[i] = side.normal.y;
+      planes.normalZ[i] = side.normal.z;
+      planes.absNormalX[i] = std::abs(side.normal.x);
+      planes.absNormalY[i] = std::abs(side.normal.y);
+      planes.absNormalZ[i] = std::abs(side.normal.z);
+      planes.d[i] = side.d;
+    }
+
+    return planes;
+  }
+
+  // Same operations in the same order as boundingBoxOnPlane and
+  // signedPlaneDistance, so the results match bit for bit. Contracting these
+  // into fused multiply-adds would break that.
+  void
+  boundingBoxesInFrustumScalar(const FrustumPlanes &planes, const BoundingBoxArrays &boxes,
+                               uint start, uint end, uint8_t bit, uint8_t* masks)
+  {
+    for (uint i = start; i < end; i++)
+    {
+      bool inFrustum = true;
+      for (uint p = 0; p < 6; p++)
+      {
+        const float r = boxes.extentX[i] * planes.absNormalX[p] +
+                        boxes.extentY[i] * planes.absNormalY[p] +
+                        boxes.extentZ[i] * planes.absNormalZ[p];
+        const float distance = planes.normalX[p] * boxes.centerX[i]
+                               + planes.normalY[p] * boxes.centerY[i]
+                               + planes.normalZ[p] * boxes.centerZ[i] - planes.d[p];
+        inFrustum = inFrustum && -r <= distance;
+      }
+
+      if (inFrustum)
+        masks[i] |= bit;
+    }
+  }
+
+  void
+  boundingBoxesInFrustum(const FrustumPlanes &planes, const BoundingBoxArrays &boxes,
+                         uint start, uint end, uint8_t bit, uint8_t* masks)
+  {
+    uint i = start;
+
+#if defined(SR_FRUSTUM_SIMD_AVX2)
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    for (; i + 8 <= end; i += 8)
+    {
+      const __m256 centerX = _mm256_loadu_ps(boxes.centerX + i);
+      const __m256 centerY = _mm256_loadu_ps(boxes.centerY + i);
+      const __m256 centerZ = _mm256_loadu_ps(boxes.centerZ + i);
+      const __m256 extentX = _mm256_loadu_ps(boxes.extentX + i);
+      const __m256 extentY = _mm256_loadu_ps(boxes.extentY + i);
+      const __m256 extentZ = _mm256_loadu_ps(boxes.extentZ + i);
+
+      __m256 inFrustum = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+      for (uint p = 0; p < 6; p++)
+      {
+        __m256 r = _mm256_add_ps(_mm256_mul_ps(extentX, _mm256_set1_ps(planes.absNormalX[p])),
+                                 _mm256_mul_ps(extentY, _mm256_set1_ps(planes.absNormalY[p])));
+        r = _mm256_add_ps(r, _mm256_mul_ps(extentZ, _mm256_set1_ps(planes.absNormalZ[p])));
+
+        __m256 distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.normalX[p]), centerX),
+                                        _mm256_mul_ps(_mm256_set1_ps(planes.normalY[p]), centerY));
+        distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(planes.normalZ[p]), centerZ));
+        distance = _mm256_sub_ps(distance, _mm256_set1_ps(planes.d[p]));
+
+        const __m256 negR = _mm256_xor_ps(r, signBit);
+        inFrustum = _mm256_and_ps(inFrustum, _mm256_cmp_ps(negR, distance, _CMP_LE_OQ));
+      }
+
+      int visible = _mm256_movemask_ps(inFrustum);
+      for (uint lane = 0; visible != 0; lane++, visible >>= 1)
+      {
+        if (visible & 1)
+          masks[i + lane] |= bit;
+      }
+    }
+#elif defined(SR_FRUSTUM_SIMD_SSE2)
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    for (; i + 4 <= end; i += 4)
+    {
+      const __m128 centerX = _mm_loadu_ps(boxes.centerX + i);
+      const __m128 centerY = _mm_loadu_ps(boxes.centerY + i);
+      const __m128 centerZ = _mm_loadu_ps(boxes.centerZ + i);
+      const __m128 extentX = _mm_loadu_ps(boxes.extentX + i);
+      const __m128 extentY = _mm_loadu_ps(boxes.extentY + i);
+      const __m128 extentZ = _mm_loadu_ps(boxes.extentZ + i);
+
+      __m128 inFrustum = _mm_castsi128_ps(_mm_set1_epi32(-1));
+      for (uint p = 0; p < 6; p++)
+      {
+        __m128 r = _mm_add_ps(_mm_mul_ps(extentX, _mm_set1_ps(planes.absNormalX[p])),
+                              _mm_mul_ps(extentY, _mm_set1_ps(planes.absNormalY[p])));
+        r = _mm_add_ps(r, _mm_mul_ps(extentZ, _mm_set1_ps(planes.absNormalZ[p])));
+
+        __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.normalX[p]), centerX),
+                                     _mm_mul_ps(_mm_set1_ps(planes.normalY[p]), centerY));
+        distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.normalZ[p]), centerZ));
+        distance = _mm_sub_ps(distance, _mm_set1_ps(planes.d[p]));
+
+        const __m128 negR = _mm_xor_ps(r, signBit);
+        inFrustum = _mm_and_ps(inFrustum, _mm_cmple_ps(negR, distance));
+      }
+
+      int visible = _mm_movemask_ps(inFrustum);
+      for (uint lane = 0; visible != 0; lane++, visible >>= 1)
+      {
+        if (visible & 1)
+          masks[i + lane] |= bit;
+      }
+    }
+#endif
+
+    boundingBoxesInFrustumScalar(planes, boxes, i, end, bit, masks);
+  }
 }
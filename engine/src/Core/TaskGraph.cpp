@@ -0,0 +1,121 @@
+#include "Core/TaskGraph.h"
+
+namespace Strontium
+{
+  TaskGraph::TaskGraph()
+    : state(createShared<GraphState>())
+  { }
+
+  TaskHandle
+  TaskGraph::addTask(const std::function<void()> &task,
+                     const std::vector<TaskHandle> &parents)
+  {
+    TaskHandle handle = static_cast<TaskHandle>(this->state->tasks.size());
+
+    uint numParents = 0;
+    for (auto parent : parents)
+    {
+      assert(("Parent tasks must be added before their children.", parent < handle));
+      if (parent >= handle)
+        continue;
+
+      this->state->tasks[parent]->children.push_back(handle);
+      numParents++;
+    }
+
+    this->state->tasks.emplace_back(createUnique<Task>(task, numParents));
+
+    return handle;
+  }
+
+  void
+  TaskGraph::execute(ThreadPool* pool)
+  {
+    auto& tasks = this->state->tasks;
+    if (tasks.empty())
+      return;
+
+    // Reset the dependency counters and collect the root tasks. Helpers left
+    // over from a previous run may still be peeking at the ready list.
+    uint numRoots = 0;
+    {
+      std::lock_guard<std::mutex> readyLock(this->state->readyMutex);
+      this->state->readyTasks.clear();
+      for (TaskHandle i = 0; i < tasks.size(); i++)
+      {
+        tasks[i]->remainingParents.store(tasks[i]->numParents);
+        if (tasks[i]->numParents == 0)
+          this->state->readyTasks.push_back(i);
+      }
+      numRoots = static_cast<uint>(this->state->readyTasks.size());
+    }
+    this->state->remainingTasks.store(static_cast<uint>(tasks.size()));
+
+    // Wake up helpers for the roots, the calling thread takes one of them.
+    uint numHelpers = std::min(numRoots - 1, pool->getNumWorkers());
+    Shared<GraphState> graphState = this->state;
+    for (uint i = 0; i < numHelpers; i++)
+      pool->pushDetached([graphState, pool]() { drainReadyTasks(graphState, pool, false); });
+
+    drainReadyTasks(this->state, pool, true);
+  }
+
+  void
+  TaskGraph::clear()
+  {
+    assert(("Can't clear a graph while it is executing.", this->state->remainingTasks.load() == 0));
+    this->state->tasks.clear();
+    this->state->readyTasks.clear();
+  }
+
+  void
+  TaskGraph::drainReadyTasks(const Shared<GraphState> &state, ThreadPool* pool,
+                             bool isCaller)
+  {
+    while (state->remainingTasks.load() > 0)
+    {
+      TaskHandle current;
+      {
+        std::lock_guard<std::mutex> readyLock(state->readyMutex);
+        if (state->readyTasks.empty())
+        {
+          if (!isCaller)
+            return;
+
+          current = std::numeric_limits<TaskHandle>::max();
+        }
+        else
+        {
+          current = state->readyTasks.back();
+          state->readyTasks.pop_back();
+        }
+      }
+
+      // Nothing ready yet, wait on the tasks which are still running.
+      if (current == std::numeric_limits<TaskHandle>::max())
+      {
+        std::this_thread::yield();
+        continue;
+      }
+
+      auto& task = *state->tasks[current];
+      task.function();
+
+      // Release the children. If more than one became ready grab extra help.
+      uint numReleased = 0;
+      for (auto child : task.children)
+      {
+        if (state->tasks[child]->remainingParents.fetch_sub(1) == 1)
+        {
+          std::lock_guard<std::mutex> readyLock(state->readyMutex);
+          state->readyTasks.push_back(child);
+          numReleased++;
+        }
+      }
+      for (uint i = 1; i < numReleased; i++)
+        pool->pushDetached([state, pool]() { drainReadyTasks(state, pool, false); });
+
+      state->remainingTasks.fetch_sub(1, std::memory_order_acq_rel);
+    }
+  }
+}
@@ -1,48 +1,183 @@
 #include "Core/ThreadPool.h"
 
+// Project includes.
+#include "Core/Logs.h"
+
+// STL includes.
+#include <cstdlib>
+
 namespace Strontium
 {
+  //----------------------------------------------------------------------------
+  // Pool sizing.
+  //----------------------------------------------------------------------------
+  ThreadPoolSettings::ThreadPoolSettings()
+  {
+    uint numThreads = std::thread::hardware_concurrency();
+    numThreads = numThreads == 0 ? 4 : numThreads;
+
+    // Leave a hardware thread for the main thread. A quarter of the workers
+    // handle IO, there's not much point in more than a few.
+    uint numWorkers = std::max(numThreads - 1, 2u);
+    this->numIOWorkers = std::clamp(numWorkers / 4, 1u, 4u);
+    this->numCPUWorkers = std::max(numWorkers - this->numIOWorkers, 1u);
+  }
+
+  // Read a worker count from an environment variable. Returns false if it
+  // isn't set or isn't a sensible number.
+  static bool
+  readWorkerCount(const char* variable, uint &outCount)
+  {
+    const char* value = std::getenv(variable);
+    if (value == nullptr)
+      return false;
+
+    char* end = nullptr;
+    unsigned long count = std::strtoul(value, &end, 10);
+    if (end == value || *end != '\0' || count == 0 || count > 256)
+    {
+      Logger::getInstance()->logMessage(LogMessage("Ignoring invalid value for "
+        + std::string(variable) + ": " + value + ".", true, true));
+      return false;
+    }
+
+    outCount = static_cast<uint>(count);
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  // Job groups.
+  //----------------------------------------------------------------------------
+  void
+  JobGroup::wait() const
+  {
+    while (this->numPending.load() > 0)
+      std::this_thread::yield();
+  }
+
+  //----------------------------------------------------------------------------
+  // Pool stats.
+  //----------------------------------------------------------------------------
+  static int64_t
+  getTimeNanoseconds()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  ThreadPool::AtomicHistogram::AtomicHistogram()
+  {
+    for (auto& bucket : this->buckets)
+      bucket.store(0);
+  }
+
+  void
+  ThreadPool::AtomicHistogram::addSample(uint64_t nanoseconds)
+  {
+    uint bucket = 0;
+    for (uint64_t microseconds = nanoseconds / 1000;
+         microseconds > 0 && bucket < JobTimeHistogram::numBuckets - 1;
+         microseconds >>= 1)
+      bucket++;
+
+    this->buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    this->numSamples.fetch_add(1, std::memory_order_relaxed);
+    this->totalNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+    uint64_t currentMax = this->maxNanoseconds.load(std::memory_order_relaxed);
+    while (nanoseconds > currentMax
+           && !this->maxNanoseconds.compare_exchange_weak(currentMax, nanoseconds,
+                                                          std::memory_order_relaxed));
+  }
+
+  void
+  ThreadPool::AtomicHistogram::accumulate(JobTimeHistogram &outHistogram) const
+  {
+    for (uint i = 0; i < JobTimeHistogram::numBuckets; i++)
+      outHistogram.buckets[i] += this->buckets[i].load(std::memory_order_relaxed);
+
+    outHistogram.numSamples += this->numSamples.load(std::memory_order_relaxed);
+    outHistogram.totalMicroseconds += this->totalNanoseconds.load(std::memory_order_relaxed) / 1000.0;
+    outHistogram.maxMicroseconds = std::max(outHistogram.maxMicroseconds,
+      this->maxNanoseconds.load(std::memory_order_relaxed) / 1000.0);
+  }
+
+  void
+  ThreadPool::AtomicHistogram::reset()
+  {
+    for (auto& bucket : this->buckets)
+      bucket.store(0, std::memory_order_relaxed);
+    this->numSamples.store(0, std::memory_order_relaxed);
+    this->totalNanoseconds.store(0, std::memory_order_relaxed);
+    this->maxNanoseconds.store(0, std::memory_order_relaxed);
+  }
+
   //----------------------------------------------------------------------------
   // Singleton thread pool.
   //----------------------------------------------------------------------------
   ThreadPool* ThreadPool::instance = nullptr;
 
-  ThreadPool::ThreadPool(unsigned int numThreads)
+  // The pool and worker index of the calling thread. Lets jobs which push more
+  // jobs feed their own deque instead of a random one.
+  static thread_local ThreadPool* currentPool = nullptr;
+  static thread_local uint currentWorker = 0;
+
+  ThreadPool::ThreadPool(const ThreadPoolSettings &settings)
+    : isActive(true)
+    , cancelQueued(false)
+    , hasShutdown(false)
   {
-    this->isActive.store(true);
+    auto& cpuLane = this->getLane(JobLane::CPU);
+    cpuLane.firstQueue = 0;
+    cpuLane.numQueues = std::max(settings.numCPUWorkers, 1u);
 
-    auto workerFunction = [](ThreadPool* parentPool)
-    {
-      while (true)
-      {
-        std::unique_lock<std::mutex> taskLock(parentPool->taskMutex);
-        parentPool->signal.wait(taskLock, [parentPool]()
-        {
-          return !parentPool->tasks.empty() || !parentPool->isActive.load(std::memory_order_relaxed);
-        });
+    auto& ioLane = this->getLane(JobLane::IO);
+    ioLane.firstQueue = cpuLane.numQueues;
+    ioLane.numQueues = std::max(settings.numIOWorkers, 1u);
 
-        if (!parentPool->isActive.load(std::memory_order_relaxed))
-          break;
+    const uint numThreads = cpuLane.numQueues + ioLane.numQueues;
 
-        (*parentPool->tasks.front()).execute();
-        parentPool->tasks.pop();
-      }
-    };
+    this->counters.reserve(numThreads + 1);
+    for (uint i = 0; i < numThreads + 1; i++)
+      this->counters.emplace_back(createUnique<WorkerCounters>());
+    this->statsStartTime.store(getTimeNanoseconds());
+
+    this->queues.reserve(numThreads);
+    for (uint i = 0; i < numThreads; i++)
+      this->queues.emplace_back(createUnique<WorkerQueue>());
 
     this->workers.reserve(numThreads);
+    for (uint i = 0; i < numThreads; i++)
+      this->workers.emplace_back(&ThreadPool::workerLoop, this, i);
 
-    for (unsigned int i = 0; i < numThreads; i++)
-    {
-      this->workers.emplace_back(workerFunction, this);
-      this->workers.back().detach();
-    }
+    Logger::getInstance()->logMessage(LogMessage("Started the thread pool with "
+      + std::to_string(cpuLane.numQueues) + " CPU worker(s) and "
+      + std::to_string(ioLane.numQueues) + " IO worker(s).", true, true));
   }
 
   ThreadPool::~ThreadPool()
   {
-    this->isActive.store(false, std::memory_order_relaxed);
+    this->shutdown(ShutdownMode::Drain);
+
+    if (instance == this)
+      instance = nullptr;
+  }
+
+  void
+  ThreadPool::shutdown(ShutdownMode mode)
+  {
+    assert(("Can't shut down the pool from one of its own workers.", !this->isWorkerThread()));
+    if (this->isWorkerThread() || this->hasShutdown.load())
+      return;
 
-    this->signal.notify_all();
+    this->cancelQueued.store(mode == ShutdownMode::Cancel);
+    this->isActive.store(false);
+
+    {
+      std::lock_guard<std::mutex> sleepLock(this->sleepMutex);
+      for (auto& lane : this->lanes)
+        lane.signal.notify_all();
+    }
 
     for (auto& worker : this->workers)
     {
@@ -50,18 +185,361 @@ namespace Strontium
         worker.join();
     }
 
-    std::unique_lock<std::mutex> taskLock(this->taskMutex);
+    // Jobs pushed by the last running jobs can be left behind after the
+    // workers exit. Finish them here, or throw them away when cancelling.
+    uint numCancelled = 0;
+    if (mode == ShutdownMode::Drain)
+    {
+      while (this->tryRunPendingJob());
+    }
+    else
+    {
+      for (auto& queue : this->queues)
+      {
+        std::deque<Job> cancelledJobs;
+        {
+          std::lock_guard<std::mutex> queueLock(queue->queueMutex);
+          cancelledJobs.swap(queue->jobs);
+        }
+        numCancelled += static_cast<uint>(cancelledJobs.size());
+      }
+
+      for (auto& lane : this->lanes)
+        lane.pendingJobs.store(0);
+      this->counters.back()->numCancelled.fetch_add(numCancelled);
+    }
+
+    this->hasShutdown.store(true);
+
+    if (numCancelled > 0)
+    {
+      Logger::getInstance()->logMessage(LogMessage("Thread pool shut down, cancelled "
+        + std::to_string(numCancelled) + " queued job(s).", true, true));
+    }
   }
 
   ThreadPool*
-  ThreadPool::getInstance(unsigned int numThreads)
+  ThreadPool::getInstance()
   {
     if (instance == nullptr)
     {
-      instance = new ThreadPool(numThreads);
+      ThreadPoolSettings poolSettings;
+      readWorkerCount("SR_CPU_WORKERS", poolSettings.numCPUWorkers);
+      readWorkerCount("SR_IO_WORKERS", poolSettings.numIOWorkers);
+
+      instance = new ThreadPool(poolSettings);
       return instance;
     }
     else
       return instance;
   }
+
+  bool
+  ThreadPool::isWorkerThread() const
+  {
+    return currentPool == this;
+  }
+
+  JobLane
+  ThreadPool::getWorkerLane(uint workerIndex) const
+  {
+    const auto& ioLane = this->lanes[static_cast<uint>(JobLane::IO)];
+    return workerIndex >= ioLane.firstQueue ? JobLane::IO : JobLane::CPU;
+  }
+
+  bool
+  ThreadPool::hasPendingJobs(JobLane workerLane) const
+  {
+    // CPU workers can pick up IO jobs, but not the other way around.
+    bool hasIOJobs = this->lanes[static_cast<uint>(JobLane::IO)].pendingJobs.load() > 0;
+    if (workerLane == JobLane::IO)
+      return hasIOJobs;
+
+    return hasIOJobs || this->lanes[static_cast<uint>(JobLane::CPU)].pendingJobs.load() > 0;
+  }
+
+  void
+  ThreadPool::enqueue(Job &&job, JobLane lane)
+  {
+    // Nobody is left to run the job, destroying it breaks its promise.
+    if (this->hasShutdown.load())
+    {
+      this->counters.back()->numCancelled.fetch_add(1);
+      Logger::getInstance()->logMessage(LogMessage("Dropped a job pushed after "
+        "the thread pool shut down.", true, true));
+      return;
+    }
+
+    auto& jobLane = this->getLane(lane);
+    jobLane.numSubmitted.fetch_add(1, std::memory_order_relaxed);
+    job.getQueuedTime() = std::chrono::steady_clock::now();
+
+    // Workers push to their own deque if it's in the right lane, everyone else
+    // round-robins over the lane's workers.
+    uint queueIndex;
+    if (this->isWorkerThread() && this->getWorkerLane(currentWorker) == lane)
+      queueIndex = currentWorker;
+    else
+    {
+      queueIndex = jobLane.firstQueue + jobLane.nextQueue.fetch_add(1, std::memory_order_relaxed)
+                   % jobLane.numQueues;
+    }
+
+    // Count the job before it becomes visible so it can't be popped early.
+    jobLane.pendingJobs.fetch_add(1);
+    {
+      std::lock_guard<std::mutex> queueLock(this->queues[queueIndex]->queueMutex);
+      this->queues[queueIndex]->jobs.emplace_back(std::move(job));
+    }
+
+    // Only touch the sleep mutex if someone is actually asleep. IO jobs fall
+    // back to waking a CPU worker if all the IO workers are busy.
+    auto& cpuLane = this->getLane(JobLane::CPU);
+    if (jobLane.numSleeping.load() > 0)
+    {
+      std::lock_guard<std::mutex> sleepLock(this->sleepMutex);
+      jobLane.signal.notify_one();
+    }
+    else if (lane == JobLane::IO && cpuLane.numSleeping.load() > 0)
+    {
+      std::lock_guard<std::mutex> sleepLock(this->sleepMutex);
+      cpuLane.signal.notify_one();
+    }
+  }
+
+  bool
+  ThreadPool::popJob(uint workerIndex, Job &outJob)
+  {
+    auto& queue = *this->queues[workerIndex];
+
+    std::lock_guard<std::mutex> queueLock(queue.queueMutex);
+    if (queue.jobs.empty())
+      return false;
+
+    outJob = std::move(queue.jobs.back());
+    queue.jobs.pop_back();
+    return true;
+  }
+
+  bool
+  ThreadPool::stealJob(uint thiefIndex, JobLane lane, Job &outJob)
+  {
+    const auto& jobLane = this->getLane(lane);
+    for (uint i = 1; i <= jobLane.numQueues; i++)
+    {
+      auto& victim = *this->queues[jobLane.firstQueue + (thiefIndex + i) % jobLane.numQueues];
+
+      // Don't wait on a busy victim, just move on to the next one.
+      std::unique_lock<std::mutex> queueLock(victim.queueMutex, std::try_to_lock);
+      if (!queueLock.owns_lock() || victim.jobs.empty())
+        continue;
+
+      outJob = std::move(victim.jobs.front());
+      victim.jobs.pop_front();
+      return true;
+    }
+
+    return false;
+  }
+
+  bool
+  ThreadPool::tryRunPendingJob()
+  {
+    uint startIndex = this->isWorkerThread() ? currentWorker : 0;
+
+    Job job;
+    if (this->isWorkerThread() && this->popJob(startIndex, job))
+    {
+      this->getLane(this->getWorkerLane(startIndex)).pendingJobs.fetch_sub(1);
+      this->runJob(job, this->getCounters());
+      return true;
+    }
+
+    for (auto lane : { JobLane::CPU, JobLane::IO })
+    {
+      auto& jobLane = this->getLane(lane);
+      if (jobLane.pendingJobs.load() == 0 || !this->stealJob(startIndex, lane, job))
+        continue;
+
+      jobLane.pendingJobs.fetch_sub(1);
+      this->runJob(job, this->getCounters());
+      return true;
+    }
+
+    return false;
+  }
+
+  ThreadPool::WorkerCounters&
+  ThreadPool::getCounters()
+  {
+    return this->isWorkerThread() ? *this->counters[currentWorker] : *this->counters.back();
+  }
+
+  void
+  ThreadPool::runJob(Job &job, WorkerCounters &counters)
+  {
+    auto startTime = std::chrono::steady_clock::now();
+    counters.numRunning.fetch_add(1, std::memory_order_relaxed);
+
+    bool ran = job();
+
+    auto endTime = std::chrono::steady_clock::now();
+    counters.numRunning.fetch_sub(1, std::memory_order_relaxed);
+
+    uint64_t waitNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      startTime - job.getQueuedTime()).count();
+    uint64_t execNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      endTime - startTime).count();
+    counters.busyNanoseconds.fetch_add(execNanoseconds, std::memory_order_relaxed);
+
+    if (!ran)
+    {
+      counters.numCancelled.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    counters.numCompleted.fetch_add(1, std::memory_order_relaxed);
+    counters.waitTimes.addSample(waitNanoseconds);
+    counters.execTimes.addSample(execNanoseconds);
+
+    if (!job.getLabel().empty())
+    {
+      std::lock_guard<std::mutex> labelLock(counters.labelMutex);
+      auto& labelStats = counters.labels[job.getLabel()];
+      labelStats.numCompleted++;
+      labelStats.totalWaitMicroseconds += waitNanoseconds / 1000.0;
+      labelStats.totalExecMicroseconds += execNanoseconds / 1000.0;
+    }
+  }
+
+  ThreadPoolStats
+  ThreadPool::getStats() const
+  {
+    ThreadPoolStats stats;
+
+    int64_t elapsedNanoseconds = std::max<int64_t>(getTimeNanoseconds()
+                                                   - this->statsStartTime.load(), 1);
+    stats.elapsedSeconds = elapsedNanoseconds / 1e9;
+
+    stats.numQueuedCPU = this->lanes[static_cast<uint>(JobLane::CPU)].pendingJobs.load();
+    stats.numQueuedIO = this->lanes[static_cast<uint>(JobLane::IO)].pendingJobs.load();
+    stats.numQueued = stats.numQueuedCPU + stats.numQueuedIO;
+    for (auto& lane : this->lanes)
+      stats.numSubmitted += lane.numSubmitted.load(std::memory_order_relaxed);
+
+    for (uint i = 0; i < this->counters.size(); i++)
+    {
+      auto& counters = *this->counters[i];
+
+      uint64_t numCompleted = counters.numCompleted.load(std::memory_order_relaxed);
+      stats.numRunning += counters.numRunning.load(std::memory_order_relaxed);
+      stats.numCompleted += numCompleted;
+      stats.numCancelled += counters.numCancelled.load(std::memory_order_relaxed);
+
+      counters.waitTimes.accumulate(stats.waitTimes);
+      counters.execTimes.accumulate(stats.execTimes);
+
+      {
+        std::lock_guard<std::mutex> labelLock(counters.labelMutex);
+        for (auto& [label, labelStats] : counters.labels)
+        {
+          auto& totalStats = stats.labels[label];
+          totalStats.numCompleted += labelStats.numCompleted;
+          totalStats.totalWaitMicroseconds += labelStats.totalWaitMicroseconds;
+          totalStats.totalExecMicroseconds += labelStats.totalExecMicroseconds;
+        }
+      }
+
+      // The last set of counters isn't a worker.
+      if (i < this->workers.size())
+      {
+        ThreadPoolWorkerStats workerStats;
+        workerStats.lane = this->getWorkerLane(i);
+        workerStats.numCompleted = numCompleted;
+        workerStats.utilisation = std::min(static_cast<double>(counters.busyNanoseconds.load(
+          std::memory_order_relaxed)) / elapsedNanoseconds, 1.0);
+        stats.workers.push_back(workerStats);
+      }
+    }
+
+    return stats;
+  }
+
+  void
+  ThreadPool::resetStats()
+  {
+    for (auto& lane : this->lanes)
+      lane.numSubmitted.store(0, std::memory_order_relaxed);
+
+    for (auto& counters : this->counters)
+    {
+      counters->numCompleted.store(0, std::memory_order_relaxed);
+      counters->numCancelled.store(0, std::memory_order_relaxed);
+      counters->busyNanoseconds.store(0, std::memory_order_relaxed);
+      counters->waitTimes.reset();
+      counters->execTimes.reset();
+
+      std::lock_guard<std::mutex> labelLock(counters->labelMutex);
+      counters->labels.clear();
+    }
+
+    this->statsStartTime.store(getTimeNanoseconds());
+  }
+
+  void
+  ThreadPool::workerLoop(uint workerIndex)
+  {
+    currentPool = this;
+    currentWorker = workerIndex;
+
+    const JobLane workerLane = this->getWorkerLane(workerIndex);
+    auto& ownLane = this->getLane(workerLane);
+    auto& ioLane = this->getLane(JobLane::IO);
+    auto& workerCounters = *this->counters[workerIndex];
+
+    while (true)
+    {
+      // When cancelling, stop as soon as the current job is done.
+      if (!this->isActive.load() && this->cancelQueued.load())
+        break;
+
+      Job job;
+      if (this->popJob(workerIndex, job) || this->stealJob(workerIndex, workerLane, job))
+      {
+        ownLane.pendingJobs.fetch_sub(1);
+        this->runJob(job, workerCounters);
+        continue;
+      }
+
+      // Idle CPU workers help drain the IO lane.
+      if (workerLane == JobLane::CPU && ioLane.pendingJobs.load() > 0
+          && this->stealJob(workerIndex, JobLane::IO, job))
+      {
+        ioLane.pendingJobs.fetch_sub(1);
+        this->runJob(job, workerCounters);
+        continue;
+      }
+
+      // A job was counted but is being moved between deques, try again.
+      if (this->hasPendingJobs(workerLane))
+      {
+        std::this_thread::yield();
+        continue;
+      }
+
+      // Shutting down and the queues are drained.
+      if (!this->isActive.load())
+        break;
+
+      std::unique_lock<std::mutex> sleepLock(this->sleepMutex);
+      ownLane.numSleeping.fetch_add(1);
+      ownLane.signal.wait(sleepLock, [this, workerLane]()
+      {
+        return this->hasPendingJobs(workerLane) || !this->isActive.load();
+      });
+      ownLane.numSleeping.fetch_sub(1);
+    }
+
+    currentPool = nullptr;
+  }
 }
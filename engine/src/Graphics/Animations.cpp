@@ -24,6 +24,14 @@ namespace Strontium
     : parentModel(parentModel)
   { }
 
+  Animation::Animation(const std::string &name, float duration, float ticksPerSecond,
+                       Model* parentModel)
+    : parentModel(parentModel)
+    , name(name)
+    , duration(duration)
+    , ticksPerSecond(ticksPerSecond)
+  { }
+
   Animation::~Animation()
   {
 
@@ -101,7 +109,7 @@ namespace Strontium
 
     if (this->animationNodes.find(nodeName) != this->animationNodes.end())
     {
-      auto& aniNode = this->animationNodes[nodeName];
+      auto& aniNode = this->animationNodes.at(nodeName);
       glm::mat4 translation = this->interpolateTranslation(aniTime, aniNode);
       glm::mat4 rotation = this->interpolateRotation(aniTime, aniNode);
       glm::mat4 scale = this->interpolateScale(aniTime, aniNode);
@@ -115,7 +123,7 @@ namespace Strontium
 
     auto& sceneNodes = this->parentModel->getSceneNodes();
     for (auto& childNodeName : node.childNames)
-      this->readUnSkinnedNodeHierarchy(aniTime, sceneNodes[childNodeName], globalTransform, outBones);
+      this->readUnSkinnedNodeHierarchy(aniTime, sceneNodes.at(childNodeName), globalTransform, outBones);
   }
 
   void
@@ -128,7 +136,7 @@ namespace Strontium
 
     if (this->animationNodes.find(nodeName) != this->animationNodes.end())
     {
-      auto& aniNode = this->animationNodes[nodeName];
+      auto& aniNode = this->animationNodes.at(nodeName);
       glm::mat4 translation = this->interpolateTranslation(aniTime, aniNode);
       glm::mat4 rotation = this->interpolateRotation(aniTime, aniNode);
       glm::mat4 scale = this->interpolateScale(aniTime, aniNode);
@@ -142,14 +150,14 @@ namespace Strontium
     if (boneMap.find(nodeName) != boneMap.end())
     {
       auto& modelBones = this->parentModel->getBones();
-      unsigned int index = boneMap[nodeName];
+      unsigned int index = boneMap.at(nodeName);
       auto boneOffset = this->parentModel->getBones()[index].offsetMatrix;
       outBones[index] = this->parentModel->getGlobalInverseTransform() * globalTransform * boneOffset;
     }
 
     auto& sceneNodes = this->parentModel->getSceneNodes();
     for (auto& childNodeName : node.childNames)
-      this->readSkinnedNodeHierarchy(aniTime, sceneNodes[childNodeName], globalTransform, outBones);
+      this->readSkinnedNodeHierarchy(aniTime, sceneNodes.at(childNodeName), globalTransform, outBones);
   }
 
   glm::mat4
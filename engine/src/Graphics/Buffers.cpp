@@ -297,4 +297,160 @@ namespace Strontium
 
     this->filled = true;
   }
+
+  //----------------------------------------------------------------------------
+  // Uniform ring buffer here.
+  //----------------------------------------------------------------------------
+  UniformRingBuffer::UniformRingBuffer(uint frameSize, uint numFrames)
+    : bufferID(0)
+    , mappedData(nullptr)
+    , frameSize(frameSize)
+    , alignment(1)
+    , head(0)
+    , numFrames(numFrames)
+    , currentFrame(0)
+    , fences(numFrames, nullptr)
+  {
+    int offsetAlignment = 1;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+    this->alignment = static_cast<uint>(std::max(offsetAlignment, 1));
+
+    this->allocateStorage();
+  }
+
+  UniformRingBuffer::~UniformRingBuffer()
+  {
+    this->releaseStorage();
+  }
+
+  // Immutable storage mapped once for the lifetime of the buffer. The mapping
+  // is coherent, so writes are visible to the GPU without a flush.
+  void
+  UniformRingBuffer::allocateStorage()
+  {
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLsizeiptr totalSize = static_cast<GLsizeiptr>(this->frameSize) * this->numFrames;
+
+    glGenBuffers(1, &this->bufferID);
+    glBindBuffer(GL_UNIFORM_BUFFER, this->bufferID);
+    glBufferStorage(GL_UNIFORM_BUFFER, totalSize, nullptr, flags);
+    this->mappedData = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0,
+                                                                    totalSize, flags));
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  }
+
+  void
+  UniformRingBuffer::releaseStorage()
+  {
+    for (auto& fence : this->fences)
+    {
+      if (fence)
+        glDeleteSync(static_cast<GLsync>(fence));
+      fence = nullptr;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, this->bufferID);
+    glUnmapBuffer(GL_UNIFORM_BUFFER);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glDeleteBuffers(1, &this->bufferID);
+
+    this->mappedData = nullptr;
+  }
+
+  void
+  UniformRingBuffer::beginFrame()
+  {
+    this->currentFrame = (this->currentFrame + 1) % this->numFrames;
+    this->head = 0;
+    this->frameBindings.clear();
+
+    auto& fence = this->fences[this->currentFrame];
+    if (!fence)
+      return;
+
+    // Flush on the first wait so the fence is guaranteed to signal.
+    GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while (true)
+    {
+      GLenum result = glClientWaitSync(static_cast<GLsync>(fence), waitFlags, 1000000);
+      if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED
+          || result == GL_WAIT_FAILED)
+        break;
+
+      waitFlags = 0;
+    }
+
+    glDeleteSync(static_cast<GLsync>(fence));
+    fence = nullptr;
+  }
+
+  void
+  UniformRingBuffer::endFrame()
+  {
+    auto& fence = this->fences[this->currentFrame];
+    if (fence)
+      glDeleteSync(static_cast<GLsync>(fence));
+
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+
+  void
+  UniformRingBuffer::bindData(uint bindPoint, const void* data, uint dataSize)
+  {
+    uint offset = (this->head + this->alignment - 1) / this->alignment * this->alignment;
+
+    if (offset + dataSize > this->frameSize)
+      this->grow(offset + dataSize);
+
+    uint start = this->currentFrame * this->frameSize + offset;
+    std::memcpy(this->mappedData + start, data, dataSize);
+    glBindBufferRange(GL_UNIFORM_BUFFER, bindPoint, this->bufferID, start, dataSize);
+
+    this->frameBindings[bindPoint] = std::make_pair(offset, dataSize);
+    this->head = offset + dataSize;
+  }
+
+  // Out of room, replace the buffer with a larger one. Draws already issued
+  // keep the old buffer alive until they finish, and the new buffer has
+  // nothing in flight so none of its regions need waiting on. Blocks bound
+  // earlier this frame would be left pointing at the deleted buffer, so the
+  // frame so far is copied to the new one on the GPU and they're rebound.
+  void
+  UniformRingBuffer::grow(uint minFrameSize)
+  {
+    uint oldBufferID = this->bufferID;
+    uint oldStart = this->currentFrame * this->frameSize;
+
+    for (auto& fence : this->fences)
+    {
+      if (fence)
+        glDeleteSync(static_cast<GLsync>(fence));
+      fence = nullptr;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, oldBufferID);
+    glUnmapBuffer(GL_UNIFORM_BUFFER);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    this->frameSize = std::max(this->frameSize, minFrameSize) * 2;
+    this->allocateStorage();
+    uint newStart = this->currentFrame * this->frameSize;
+
+    if (this->head > 0)
+    {
+      glBindBuffer(GL_COPY_READ_BUFFER, oldBufferID);
+      glBindBuffer(GL_COPY_WRITE_BUFFER, this->bufferID);
+      glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, oldStart, newStart,
+                          this->head);
+      glBindBuffer(GL_COPY_READ_BUFFER, 0);
+      glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &oldBufferID);
+
+    for (auto& [bindPoint, range] : this->frameBindings)
+    {
+      glBindBufferRange(GL_UNIFORM_BUFFER, bindPoint, this->bufferID,
+                        newStart + range.first, range.second);
+    }
+  }
 }
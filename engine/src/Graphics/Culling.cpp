@@ -0,0 +1,120 @@
+#include "Graphics/Culling.h"
+
+namespace Strontium
+{
+  void
+  CullingBounds::resize(uint numBounds)
+  {
+    this->centerX.resize(numBounds);
+    this->centerY.resize(numBounds);
+    this->centerZ.resize(numBounds);
+    this->extentX.resize(numBounds);
+    this->extentY.resize(numBounds);
+    this->extentZ.resize(numBounds);
+  }
+
+  void
+  CullingBounds::set(uint index, const BoundingBox &box)
+  {
+    this->centerX[index] = box.center.x;
+    this->centerY[index] = box.center.y;
+    this->centerZ[index] = box.center.z;
+    this->extentX[index] = box.extents.x;
+    this->extentY[index] = box.extents.y;
+    this->extentZ[index] = box.extents.z;
+  }
+
+  void
+  FrustumCuller::cull(const CullingBounds &bounds, const Frustum* frustums, uint numFrustums,
+                      ThreadPool* pool, uint grainSize)
+  {
+    assert(("Too many frustums to cull against.", numFrustums <= MAX_CULLING_FRUSTUMS));
+
+    const uint numBounds = bounds.size();
+    grainSize = grainSize == 0 ? 1 : grainSize;
+    const uint numChunks = (numBounds + grainSize - 1) / grainSize;
+
+    this->numFrustums = numFrustums;
+    this->masks.assign(numBounds, 0);
+    this->chunkOffsets.assign(numChunks * numFrustums, 0);
+
+    FrustumPlanes planes[MAX_CULLING_FRUSTUMS];
+    for (uint f = 0; f < numFrustums; f++)
+      planes[f] = packFrustumPlanes(frustums[f]);
+    const BoundingBoxArrays boxes = bounds.getArrays();
+
+    auto forEachChunk = [&](auto &&func)
+    {
+      if (pool)
+        pool->parallelFor(0, numChunks, 1, func);
+      else
+      {
+        for (uint chunk = 0; chunk < numChunks; chunk++)
+          func(chunk);
+      }
+    };
+
+    // Test the boxes and count the visible ones per chunk.
+    forEachChunk([&](uint chunk)
+    {
+      const uint start = chunk * grainSize;
+      const uint end = std::min(start + grainSize, numBounds);
+      for (uint f = 0; f < numFrustums; f++)
+      {
+        boundingBoxesInFrustum(planes[f], boxes, start, end, static_cast<uint8_t>(1u << f),
+                               this->masks.data());
+      }
+
+      for (uint f = 0; f < numFrustums; f++)
+      {
+        uint count = 0;
+        for (uint i = start; i < end; i++)
+          count += (this->masks[i] >> f) & 1u;
+        this->chunkOffsets[chunk * numFrustums + f] = count;
+      }
+    });
+
+    // Turn the counts into offsets, so the chunks can write their indices
+    // without synchronizing and the lists come out in order.
+    for (uint f = 0; f < numFrustums; f++)
+    {
+      uint total = 0;
+      for (uint chunk = 0; chunk < numChunks; chunk++)
+      {
+        uint count = this->chunkOffsets[chunk * numFrustums + f];
+        this->chunkOffsets[chunk * numFrustums + f] = total;
+        total += count;
+      }
+      this->visible[f].resize(total);
+    }
+
+    forEachChunk([&](uint chunk)
+    {
+      const uint start = chunk * grainSize;
+      const uint end = std::min(start + grainSize, numBounds);
+      for (uint f = 0; f < numFrustums; f++)
+      {
+        uint* out = this->visible[f].data() + this->chunkOffsets[chunk * numFrustums + f];
+        for (uint i = start; i < end; i++)
+        {
+          if ((this->masks[i] >> f) & 1u)
+            *out++ = i;
+        }
+      }
+    });
+  }
+
+  void
+  FrustumCuller::setAllVisible(uint numBounds, uint numFrustums)
+  {
+    assert(("Too many frustums to cull against.", numFrustums <= MAX_CULLING_FRUSTUMS));
+
+    this->numFrustums = numFrustums;
+    for (uint f = 0; f < numFrustums; f++)
+    {
+      this->visible[f].resize(numBounds);
+      for (uint i = 0; i < numBounds; i++)
+        this->visible[f][i] = i;
+    }
+  }
+}
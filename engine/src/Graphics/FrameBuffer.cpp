@@ -2,6 +2,7 @@
 
 // Project includes.
 #include "Core/Logs.h"
+#include "Graphics/StateCache.h"
 
 // OpenGL includes.
 #include "glad/glad.h"
@@ -36,8 +37,13 @@ namespace Strontium
   {
     // Delete the texture attachments.
     for (auto& attachments : this->textureAttachments)
+    {
       if (attachments.second.ownedByFBO)
+      {
+        StateCache::forgetTexture(attachments.second.attachmentID);
         glDeleteTextures(1, &attachments.second.attachmentID);
+      }
+    }
     this->textureAttachments.clear();
 
     // Actual buffer delete.
@@ -65,7 +71,10 @@ namespace Strontium
     if (targetLoc != this->textureAttachments.end())
     {
       if (targetLoc->second.ownedByFBO)
+      {
+        StateCache::forgetTexture(targetLoc->second.attachmentID);
         glDeleteTextures(1, &targetLoc->second.attachmentID);
+      }
       this->textureAttachments.erase(targetLoc);
     }
 
@@ -76,7 +85,7 @@ namespace Strontium
     {
       // Generate a 2D texture if it is supposed to be owned by an FBO.
       glGenTextures(1, &ownedAttachment.attachmentID);
-      glBindTexture(GL_TEXTURE_2D, ownedAttachment.attachmentID);
+      StateCache::bindTexture(GL_TEXTURE_2D, ownedAttachment.attachmentID);
 
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
                       static_cast<GLenum>(params.sWrap));
@@ -90,7 +99,7 @@ namespace Strontium
       glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLenum>(ownedAttachment.internal),
           this->width, this->height, 0, static_cast<GLenum>(ownedAttachment.format),
           static_cast<GLenum>(ownedAttachment.dataType), nullptr);
-      glBindTexture(GL_TEXTURE_2D, 0);
+      StateCache::bindTexture(GL_TEXTURE_2D, 0);
     }
 
     glBindFramebuffer(GL_FRAMEBUFFER, this->bufferID);
@@ -245,12 +254,12 @@ namespace Strontium
         }
         default:
         {
-          glBindTexture(static_cast<GLenum>(ownedAttachment.type), ownedAttachment.attachmentID);
+          StateCache::bindTexture(static_cast<GLenum>(ownedAttachment.type), ownedAttachment.attachmentID);
           glTexImage2D(static_cast<GLenum>(ownedAttachment.type), 0, 
                        static_cast<GLenum>(ownedAttachment.internal), this->width, this->height, 
                        0, static_cast<GLenum>(ownedAttachment.format),
                        static_cast<GLenum>(ownedAttachment.dataType), nullptr);
-          glBindTexture(static_cast<GLenum>(ownedAttachment.type), 0);
+          StateCache::bindTexture(static_cast<GLenum>(ownedAttachment.type), 0);
         }
       }
     }
@@ -275,15 +284,14 @@ namespace Strontium
   FrameBuffer::bindTextureID(const FBOTargetParam &attachment)
   {
     auto& ownedAttachment = this->textureAttachments.at(attachment);
-    glBindTexture(static_cast<GLenum>(ownedAttachment.type), ownedAttachment.attachmentID);
+    StateCache::bindTexture(static_cast<GLenum>(ownedAttachment.type), ownedAttachment.attachmentID);
   }
 
   void
   FrameBuffer::bindTextureID(const FBOTargetParam &attachment, uint bindPoint)
   {
     auto& ownedAttachment = this->textureAttachments.at(attachment);
-    glActiveTexture(GL_TEXTURE0 + bindPoint);
-    glBindTexture(static_cast<GLenum>(ownedAttachment.type), ownedAttachment.attachmentID);
+    StateCache::bindTexture(bindPoint, static_cast<GLenum>(ownedAttachment.type), ownedAttachment.attachmentID);
   }
 
   void 
@@ -0,0 +1,365 @@
+#include "Graphics/GeometryArena.h"
+
+// Project includes.
+#include "Graphics/Meshes.h"
+#include "Graphics/StateCache.h"
+
+// OpenGL includes.
+#include "glad/glad.h"
+
+namespace Strontium
+{
+  // Starting sizes, about 6 MB of vertices and 1 MB of indices.
+  constexpr uint initialArenaVertices = 1 << 16;
+  constexpr uint initialArenaIndices = 1 << 18;
+  constexpr uint initialArenaCommands = 1 << 10;
+
+  //----------------------------------------------------------------------------
+  // Range allocator here.
+  //----------------------------------------------------------------------------
+  RangeAllocator::RangeAllocator()
+    : capacity(0)
+    , used(0)
+  { }
+
+  bool
+  RangeAllocator::allocate(uint size, uint &outOffset)
+  {
+    if (size == 0)
+    {
+      outOffset = 0;
+      return true;
+    }
+
+    for (auto it = this->freeRanges.begin(); it != this->freeRanges.end(); ++it)
+    {
+      auto [offset, rangeSize] = *it;
+      if (rangeSize < size)
+        continue;
+
+      this->freeRanges.erase(it);
+      if (rangeSize > size)
+        this->freeRanges.emplace(offset + size, rangeSize - size);
+
+      this->used += size;
+      outOffset = offset;
+      return true;
+    }
+
+    return false;
+  }
+
+  void
+  RangeAllocator::free(uint offset, uint size)
+  {
+    if (size == 0)
+      return;
+
+    this->used -= size;
+
+    // Merge with the free ranges on either side.
+    auto next = this->freeRanges.lower_bound(offset);
+    if (next != this->freeRanges.end() && offset + size == next->first)
+    {
+      size += next->second;
+      next = this->freeRanges.erase(next);
+    }
+
+    if (next != this->freeRanges.begin())
+    {
+      auto previous = std::prev(next);
+      if (previous->first + previous->second == offset)
+      {
+        previous->second += size;
+        return;
+      }
+    }
+
+    this->freeRanges.emplace(offset, size);
+  }
+
+  void
+  RangeAllocator::grow(uint newCapacity)
+  {
+    if (newCapacity <= this->capacity)
+      return;
+
+    uint oldCapacity = this->capacity;
+    this->capacity = newCapacity;
+
+    // The new space is a free range like any other.
+    this->used += newCapacity - oldCapacity;
+    this->free(oldCapacity, newCapacity - oldCapacity);
+  }
+
+  //----------------------------------------------------------------------------
+  // Geometry arena here.
+  //----------------------------------------------------------------------------
+  GeometryArena*
+  GeometryArena::getInstance()
+  {
+    static GeometryArena* instance = new GeometryArena();
+    return instance;
+  }
+
+  GeometryArena::GeometryArena()
+    : arrayID(0)
+    , vertexBufferID(0)
+    , indexBufferID(0)
+    , commandBufferID(0)
+    , drawIDBufferID(0)
+    , commandCapacity(initialArenaCommands)
+    , drawIDCapacity(initialArenaCommands)
+  {
+    glGenVertexArrays(1, &this->arrayID);
+    StateCache::bindVertexArray(this->arrayID);
+
+    glGenBuffers(1, &this->vertexBufferID);
+    glBindBuffer(GL_ARRAY_BUFFER, this->vertexBufferID);
+    glBufferData(GL_ARRAY_BUFFER, initialArenaVertices * sizeof(Vertex), nullptr, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &this->indexBufferID);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->indexBufferID);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, initialArenaIndices * sizeof(uint), nullptr, GL_STATIC_DRAW);
+
+    // Draw IDs are just 0, 1, 2, ... offset by each command's baseInstance.
+    std::vector<uint> drawIDs(this->drawIDCapacity);
+    for (uint i = 0; i < this->drawIDCapacity; i++)
+      drawIDs[i] = i;
+    glGenBuffers(1, &this->drawIDBufferID);
+    glBindBuffer(GL_ARRAY_BUFFER, this->drawIDBufferID);
+    glBufferData(GL_ARRAY_BUFFER, drawIDs.size() * sizeof(uint), drawIDs.data(), GL_STATIC_DRAW);
+
+    glGenBuffers(1, &this->commandBufferID);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, this->commandBufferID);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, this->commandCapacity * sizeof(DrawElementsIndirectCommand),
+                 nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    // Same attributes as the full format mesh vertex arrays.
+    glBindBuffer(GL_ARRAY_BUFFER, this->vertexBufferID);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, position));
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, normal));
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, uv));
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, tangent));
+    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, bitangent));
+    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, boneWeights));
+    glVertexAttribIPointer(6, 4, GL_UNSIGNED_INT, sizeof(Vertex), (void*) offsetof(Vertex, boneIDs));
+    for (uint i = 0; i < 7; i++)
+      glEnableVertexAttribArray(i);
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->drawIDBufferID);
+    glVertexAttribIPointer(7, 1, GL_UNSIGNED_INT, sizeof(uint), nullptr);
+    glVertexAttribDivisor(7, 1);
+    glEnableVertexAttribArray(7);
+
+    StateCache::bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    this->vertexRanges.grow(initialArenaVertices);
+    this->indexRanges.grow(initialArenaIndices);
+  }
+
+  GeometryArena::~GeometryArena()
+  {
+    StateCache::forgetVertexArray(this->arrayID);
+    glDeleteVertexArrays(1, &this->arrayID);
+    glDeleteBuffers(1, &this->vertexBufferID);
+    glDeleteBuffers(1, &this->indexBufferID);
+    glDeleteBuffers(1, &this->commandBufferID);
+    glDeleteBuffers(1, &this->drawIDBufferID);
+  }
+
+  bool
+  GeometryArena::allocate(uint numVertices, uint numIndices, ArenaAllocation &outAllocation)
+  {
+    if (!this->vertexRanges.allocate(numVertices, outAllocation.firstVertex))
+    {
+      this->growVertices(this->vertexRanges.getCapacity() + numVertices);
+      if (!this->vertexRanges.allocate(numVertices, outAllocation.firstVertex))
+        return false;
+    }
+
+    if (!this->indexRanges.allocate(numIndices, outAllocation.firstIndex))
+    {
+      this->growIndices(this->indexRanges.getCapacity() + numIndices);
+      if (!this->indexRanges.allocate(numIndices, outAllocation.firstIndex))
+      {
+        this->vertexRanges.free(outAllocation.firstVertex, numVertices);
+        return false;
+      }
+    }
+
+    outAllocation.numVertices = numVertices;
+    outAllocation.numIndices = numIndices;
+    return true;
+  }
+
+  void
+  GeometryArena::free(const ArenaAllocation &allocation)
+  {
+    this->vertexRanges.free(allocation.firstVertex, allocation.numVertices);
+    this->indexRanges.free(allocation.firstIndex, allocation.numIndices);
+  }
+
+  // Uploads go through the copy target so the bound vertex array is left
+  // alone.
+  void
+  GeometryArena::setVertices(uint firstVertex, const Vertex* vertices, uint numVertices)
+  {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, this->vertexBufferID);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(firstVertex) * sizeof(Vertex),
+                    static_cast<GLsizeiptr>(numVertices) * sizeof(Vertex), vertices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  }
+
+  void
+  GeometryArena::setIndices(uint firstIndex, const uint* indices, uint numIndices)
+  {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, this->indexBufferID);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(firstIndex) * sizeof(uint),
+                    static_cast<GLsizeiptr>(numIndices) * sizeof(uint), indices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  }
+
+  void
+  GeometryArena::setCommands(const std::vector<DrawElementsIndirectCommand> &commands)
+  {
+    uint maxDrawID = 0;
+    for (auto& command : commands)
+      maxDrawID = std::max(maxDrawID, command.baseInstance + command.instanceCount);
+    if (maxDrawID > this->drawIDCapacity)
+      this->growDrawIDs(maxDrawID);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, this->commandBufferID);
+    if (commands.size() > this->commandCapacity)
+    {
+      while (this->commandCapacity < commands.size())
+        this->commandCapacity *= 2;
+      glBufferData(GL_DRAW_INDIRECT_BUFFER, this->commandCapacity * sizeof(DrawElementsIndirectCommand),
+                   nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands.size() * sizeof(DrawElementsIndirectCommand),
+                    commands.data());
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  }
+
+  void
+  GeometryArena::drawCommands(uint firstCommand, uint numCommands)
+  {
+    if (numCommands == 0)
+      return;
+
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                (void*) (firstCommand * sizeof(DrawElementsIndirectCommand)),
+                                numCommands, 0);
+  }
+
+  void
+  GeometryArena::bind()
+  {
+    StateCache::bindVertexArray(this->arrayID);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, this->commandBufferID);
+  }
+
+  void
+  GeometryArena::unbind()
+  {
+    StateCache::bindVertexArray(0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  }
+
+  uint64_t
+  GeometryArena::getUsedBytes()
+  {
+    return static_cast<uint64_t>(this->vertexRanges.getUsed()) * sizeof(Vertex)
+           + static_cast<uint64_t>(this->indexRanges.getUsed()) * sizeof(uint);
+  }
+
+  uint64_t
+  GeometryArena::getCapacityBytes()
+  {
+    return static_cast<uint64_t>(this->vertexRanges.getCapacity()) * sizeof(Vertex)
+           + static_cast<uint64_t>(this->indexRanges.getCapacity()) * sizeof(uint);
+  }
+
+  void
+  GeometryArena::growVertices(uint minCapacity)
+  {
+    uint oldCapacity = this->vertexRanges.getCapacity();
+    uint newCapacity = std::max(minCapacity, 2 * oldCapacity);
+    this->vertexBufferID = this->growBuffer(this->vertexBufferID,
+                                            static_cast<uint64_t>(oldCapacity) * sizeof(Vertex),
+                                            static_cast<uint64_t>(newCapacity) * sizeof(Vertex));
+
+    // Point the attributes at the new buffer.
+    StateCache::bindVertexArray(this->arrayID);
+    glBindBuffer(GL_ARRAY_BUFFER, this->vertexBufferID);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, position));
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, normal));
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, uv));
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, tangent));
+    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, bitangent));
+    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, boneWeights));
+    glVertexAttribIPointer(6, 4, GL_UNSIGNED_INT, sizeof(Vertex), (void*) offsetof(Vertex, boneIDs));
+    StateCache::bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    this->vertexRanges.grow(newCapacity);
+  }
+
+  void
+  GeometryArena::growIndices(uint minCapacity)
+  {
+    uint oldCapacity = this->indexRanges.getCapacity();
+    uint newCapacity = std::max(minCapacity, 2 * oldCapacity);
+    this->indexBufferID = this->growBuffer(this->indexBufferID,
+                                           static_cast<uint64_t>(oldCapacity) * sizeof(uint),
+                                           static_cast<uint64_t>(newCapacity) * sizeof(uint));
+
+    StateCache::bindVertexArray(this->arrayID);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->indexBufferID);
+    StateCache::bindVertexArray(0);
+
+    this->indexRanges.grow(newCapacity);
+  }
+
+  void
+  GeometryArena::growDrawIDs(uint minCapacity)
+  {
+    uint newCapacity = this->drawIDCapacity;
+    while (newCapacity < minCapacity)
+      newCapacity *= 2;
+
+    std::vector<uint> drawIDs(newCapacity);
+    for (uint i = 0; i < newCapacity; i++)
+      drawIDs[i] = i;
+
+    StateCache::bindVertexArray(this->arrayID);
+    glBindBuffer(GL_ARRAY_BUFFER, this->drawIDBufferID);
+    glBufferData(GL_ARRAY_BUFFER, drawIDs.size() * sizeof(uint), drawIDs.data(), GL_STATIC_DRAW);
+    glVertexAttribIPointer(7, 1, GL_UNSIGNED_INT, sizeof(uint), nullptr);
+    StateCache::bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    this->drawIDCapacity = newCapacity;
+  }
+
+  uint
+  GeometryArena::growBuffer(uint bufferID, uint64_t oldSize, uint64_t newSize)
+  {
+    uint newBufferID;
+    glGenBuffers(1, &newBufferID);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newBufferID);
+    glBufferData(GL_COPY_WRITE_BUFFER, newSize, nullptr, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_COPY_READ_BUFFER, bufferID);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    glDeleteBuffers(1, &bufferID);
+    return newBufferID;
+  }
+}
@@ -112,6 +112,24 @@ namespace Strontium
     // TODO: Reflection.
   }
 
+  // Resolve the sampler uniforms of a shader once, and again only after the
+  // shader is relinked.
+  std::vector<UniformHandle>&
+  Material::getSamplerHandles(Shader* shader)
+  {
+    auto& cached = this->samplerHandles[shader];
+    if (cached.linkCount != shader->getLinkCount()
+        || cached.handles.size() != this->sampler2Ds.size())
+    {
+      cached.linkCount = shader->getLinkCount();
+      cached.handles.clear();
+      for (auto& pair : this->sampler2Ds)
+        cached.handles.emplace_back(shader->getUniformHandle(pair.first));
+    }
+
+    return cached.handles;
+  }
+
   void
   Material::configure()
   {
@@ -120,11 +138,12 @@ namespace Strontium
 
     // Loop over 2D textures and assign them.
     // TODO: Other sampler types.
+    auto& handles = this->getSamplerHandles(this->program);
     for (auto& pair : this->sampler2Ds)
     {
       Texture2D* sampler = textureCache->getAsset(pair.second);
 
-      this->program->addUniformSampler(pair.first.c_str(), samplerCount);
+      this->program->addUniformSampler(handles[samplerCount], samplerCount);
       if (sampler != nullptr)
         sampler->bind(samplerCount);
 
@@ -142,11 +161,12 @@ namespace Strontium
 
     // Loop over 2D textures and assign them.
     // TODO: Other sampler types.
+    auto& handles = this->getSamplerHandles(override);
     for (auto& pair : this->sampler2Ds)
     {
       Texture2D* sampler = textureCache->getAsset(pair.second);
 
-      override->addUniformSampler(pair.first.c_str(), samplerCount);
+      override->addUniformSampler(handles[samplerCount], samplerCount);
       if (sampler != nullptr)
         sampler->bind(samplerCount);
 
@@ -193,6 +213,9 @@ namespace Strontium
       this->sampler2Ds.erase(loc);
       this->sampler2Ds.push_back(std::pair(samplerName, handle));
     }
+
+    // The samplers may have been reordered.
+    this->samplerHandles.clear();
   }
 
   bool
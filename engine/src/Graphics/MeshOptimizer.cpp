@@ -0,0 +1,967 @@
+#include "Graphics/MeshOptimizer.h"
+
+// STL includes.
+#include <cstring>
+
+namespace Strontium
+{
+  namespace MeshOptimizer
+  {
+    // Size of the LRU cache Forsyth's scoring is tuned for.
+    constexpr uint forsythCacheSize = 32;
+
+    // Size of the FIFO cache used to measure and cluster index buffers.
+    constexpr uint fifoCacheSize = 16;
+
+    // Score of a vertex for Forsyth's algorithm. Vertices which were just used
+    // or which have few triangles left score higher, so the triangles which
+    // use them get emitted sooner.
+    static float
+    computeVertexScore(int cachePosition, uint remainingTriangles)
+    {
+      if (remainingTriangles == 0)
+        return -1.0f;
+
+      float score = 0.0f;
+      if (cachePosition >= 0)
+      {
+        // The last triangle's vertices get a fixed score so the next triangle
+        // doesn't simply reuse the same edge.
+        if (cachePosition < 3)
+          score = 0.75f;
+        else
+        {
+          float scaler = 1.0f / (forsythCacheSize - 3);
+          score = std::pow(1.0f - (cachePosition - 3) * scaler, 1.5f);
+        }
+      }
+
+      // Boost vertices with only a few triangles left to get rid of them.
+      score += 2.0f / std::sqrt(static_cast<float>(remainingTriangles));
+      return score;
+    }
+
+    // Push a triangle through a FIFO cache, returning the number of misses.
+    // Vertices are in the cache if they were added in the last cacheSize
+    // misses. Bump the time by cacheSize + 1 to flush the cache.
+    static uint
+    simulateTriangle(const uint* triangle, std::vector<uint> &timestamps, uint &time,
+                     uint cacheSize)
+    {
+      uint misses = 0;
+      for (uint i = 0; i < 3; i++)
+      {
+        if (time - timestamps[triangle[i]] > cacheSize)
+        {
+          timestamps[triangle[i]] = time++;
+          misses++;
+        }
+      }
+
+      return misses;
+    }
+
+    VertexCacheStats
+    analyzeVertexCache(const std::vector<uint> &indices, uint numVertices, uint cacheSize)
+    {
+      VertexCacheStats stats;
+      uint numTriangles = static_cast<uint>(indices.size() / 3);
+      if (numTriangles == 0 || numVertices == 0)
+        return stats;
+
+      std::vector<uint> timestamps(numVertices, 0);
+      std::vector<bool> usedVertices(numVertices, false);
+      uint time = cacheSize + 1;
+      uint misses = 0;
+      uint numUsedVertices = 0;
+      for (uint i = 0; i < numTriangles; i++)
+      {
+        misses += simulateTriangle(&indices[3 * i], timestamps, time, cacheSize);
+
+        for (uint j = 0; j < 3; j++)
+        {
+          if (!usedVertices[indices[3 * i + j]])
+          {
+            usedVertices[indices[3 * i + j]] = true;
+            numUsedVertices++;
+          }
+        }
+      }
+
+      stats.acmr = static_cast<float>(misses) / numTriangles;
+      stats.atvr = static_cast<float>(misses) / numUsedVertices;
+      return stats;
+    }
+
+    void
+    optimizeVertexCache(std::vector<uint> &indices, uint numVertices)
+    {
+      uint numTriangles = static_cast<uint>(indices.size() / 3);
+      if (numTriangles < 2)
+        return;
+
+      // Build the list of triangles using each vertex. The triangles which
+      // haven't been emitted yet are kept at the front of each vertex's range.
+      std::vector<uint> remainingTriangles(numVertices, 0);
+      for (auto index : indices)
+        remainingTriangles[index]++;
+
+      std::vector<uint> adjacencyOffsets(numVertices + 1, 0);
+      for (uint i = 0; i < numVertices; i++)
+        adjacencyOffsets[i + 1] = adjacencyOffsets[i] + remainingTriangles[i];
+
+      std::vector<uint> adjacency(indices.size());
+      std::vector<uint> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+      for (uint i = 0; i < numTriangles; i++)
+        for (uint j = 0; j < 3; j++)
+          adjacency[adjacencyFill[indices[3 * i + j]]++] = i;
+
+      std::vector<int> cachePositions(numVertices, -1);
+      std::vector<float> vertexScores(numVertices);
+      for (uint i = 0; i < numVertices; i++)
+        vertexScores[i] = computeVertexScore(-1, remainingTriangles[i]);
+
+      auto triangleScore = [&](uint triangle)
+      {
+        return vertexScores[indices[3 * triangle]] + vertexScores[indices[3 * triangle + 1]]
+               + vertexScores[indices[3 * triangle + 2]];
+      };
+
+      // Start with the best triangle in the mesh.
+      std::vector<bool> emitted(numTriangles, false);
+      int bestTriangle = 0;
+      float bestScore = triangleScore(0);
+      for (uint i = 1; i < numTriangles; i++)
+      {
+        float score = triangleScore(i);
+        if (score > bestScore)
+        {
+          bestScore = score;
+          bestTriangle = static_cast<int>(i);
+        }
+      }
+
+      std::vector<uint> cache, nextCache;
+      cache.reserve(forsythCacheSize + 3);
+      nextCache.reserve(forsythCacheSize + 3);
+
+      std::vector<uint> outIndices;
+      outIndices.reserve(indices.size());
+
+      uint scanPosition = 0;
+      for (uint emittedTriangles = 0; emittedTriangles < numTriangles; emittedTriangles++)
+      {
+        // Nothing in the cache has triangles left, take the next triangle
+        // which hasn't been emitted yet.
+        if (bestTriangle < 0)
+        {
+          while (emitted[scanPosition])
+            scanPosition++;
+          bestTriangle = static_cast<int>(scanPosition);
+        }
+
+        uint triangle = static_cast<uint>(bestTriangle);
+        const uint* triangleIndices = &indices[3 * triangle];
+        emitted[triangle] = true;
+
+        // Emit the triangle and remove it from its vertices' lists.
+        for (uint i = 0; i < 3; i++)
+        {
+          uint vertex = triangleIndices[i];
+          outIndices.push_back(vertex);
+
+          uint begin = adjacencyOffsets[vertex];
+          uint end = begin + remainingTriangles[vertex];
+          for (uint j = begin; j < end; j++)
+          {
+            if (adjacency[j] == triangle)
+            {
+              std::swap(adjacency[j], adjacency[end - 1]);
+              remainingTriangles[vertex]--;
+              break;
+            }
+          }
+        }
+
+        // Move the triangle's vertices to the front of the LRU cache.
+        nextCache.clear();
+        nextCache.insert(nextCache.end(), triangleIndices, triangleIndices + 3);
+        for (auto vertex : cache)
+          if (vertex != triangleIndices[0] && vertex != triangleIndices[1] && vertex != triangleIndices[2])
+            nextCache.push_back(vertex);
+
+        // Rescore everything which moved, including the vertices which fell
+        // out of the cache.
+        for (uint i = 0; i < nextCache.size(); i++)
+        {
+          uint vertex = nextCache[i];
+          cachePositions[vertex] = i < forsythCacheSize ? static_cast<int>(i) : -1;
+          vertexScores[vertex] = computeVertexScore(cachePositions[vertex], remainingTriangles[vertex]);
+        }
+
+        // The next triangle is the best one touching the cache.
+        bestTriangle = -1;
+        bestScore = -1.0f;
+        for (uint i = 0; i < nextCache.size() && i < forsythCacheSize; i++)
+        {
+          uint vertex = nextCache[i];
+          uint begin = adjacencyOffsets[vertex];
+          uint end = begin + remainingTriangles[vertex];
+          for (uint j = begin; j < end; j++)
+          {
+            float score = triangleScore(adjacency[j]);
+            if (score > bestScore)
+            {
+              bestScore = score;
+              bestTriangle = static_cast<int>(adjacency[j]);
+            }
+          }
+        }
+
+        if (nextCache.size() > forsythCacheSize)
+          nextCache.resize(forsythCacheSize);
+        std::swap(cache, nextCache);
+      }
+
+      indices.swap(outIndices);
+    }
+
+    void
+    optimizeOverdraw(std::vector<uint> &indices, const std::vector<Vertex> &vertices,
+                     float threshold)
+    {
+      uint numTriangles = static_cast<uint>(indices.size() / 3);
+      uint numVertices = static_cast<uint>(vertices.size());
+      if (numTriangles < 2)
+        return;
+
+      std::vector<uint> timestamps(numVertices, 0);
+      uint time = fifoCacheSize + 1;
+
+      // Hard boundaries are wherever the cache has been completely flushed,
+      // moving those clusters around costs nothing.
+      std::vector<uint> hardBoundaries;
+      for (uint i = 0; i < numTriangles; i++)
+        if (simulateTriangle(&indices[3 * i], timestamps, time, fifoCacheSize) == 3)
+          hardBoundaries.push_back(i);
+      if (hardBoundaries.empty() || hardBoundaries[0] != 0)
+        hardBoundaries.insert(hardBoundaries.begin(), 0);
+      hardBoundaries.push_back(numTriangles);
+
+      // Split the hard clusters further wherever the cluster so far is within
+      // the threshold of the cache efficiency of the whole hard cluster.
+      std::vector<uint> clusters;
+      for (uint i = 0; i + 1 < hardBoundaries.size(); i++)
+      {
+        uint start = hardBoundaries[i];
+        uint end = hardBoundaries[i + 1];
+
+        time += fifoCacheSize + 1;
+        uint clusterMisses = 0;
+        for (uint j = start; j < end; j++)
+          clusterMisses += simulateTriangle(&indices[3 * j], timestamps, time, fifoCacheSize);
+        float clusterACMR = static_cast<float>(clusterMisses) / (end - start);
+
+        clusters.push_back(start);
+        time += fifoCacheSize + 1;
+        uint softStart = start;
+        uint softMisses = 0;
+        for (uint j = start; j < end; j++)
+        {
+          softMisses += simulateTriangle(&indices[3 * j], timestamps, time, fifoCacheSize);
+          float softACMR = static_cast<float>(softMisses) / (j - softStart + 1);
+          if (j + 1 < end && softACMR <= threshold * clusterACMR)
+          {
+            clusters.push_back(j + 1);
+            softStart = j + 1;
+            softMisses = 0;
+            time += fifoCacheSize + 1;
+          }
+        }
+      }
+      clusters.push_back(numTriangles);
+
+      // Area weighted centroid of the whole mesh.
+      auto triangleData = [&](uint triangle, glm::vec3 &outCentroid, glm::vec3 &outNormal)
+      {
+        glm::vec3 p0 = glm::vec3(vertices[indices[3 * triangle]].position);
+        glm::vec3 p1 = glm::vec3(vertices[indices[3 * triangle + 1]].position);
+        glm::vec3 p2 = glm::vec3(vertices[indices[3 * triangle + 2]].position);
+        outCentroid = (p0 + p1 + p2) / 3.0f;
+        outNormal = glm::cross(p1 - p0, p2 - p0); // Length is twice the area.
+      };
+
+      glm::vec3 meshCentroid(0.0f);
+      float meshArea = 0.0f;
+      for (uint i = 0; i < numTriangles; i++)
+      {
+        glm::vec3 centroid, normal;
+        triangleData(i, centroid, normal);
+        float area = glm::length(normal);
+        meshCentroid += centroid * area;
+        meshArea += area;
+      }
+      meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : meshCentroid;
+
+      // Clusters which sit far out along their own normal are likely to
+      // occlude the rest of the mesh, draw them first.
+      uint numClusters = static_cast<uint>(clusters.size() - 1);
+      std::vector<std::pair<float, uint>> sortKeys(numClusters);
+      for (uint i = 0; i < numClusters; i++)
+      {
+        glm::vec3 clusterCentroid(0.0f), clusterNormal(0.0f);
+        float clusterArea = 0.0f;
+        for (uint j = clusters[i]; j < clusters[i + 1]; j++)
+        {
+          glm::vec3 centroid, normal;
+          triangleData(j, centroid, normal);
+          float area = glm::length(normal);
+          clusterCentroid += centroid * area;
+          clusterNormal += normal;
+          clusterArea += area;
+        }
+
+        clusterCentroid = clusterArea > 0.0f ? clusterCentroid / clusterArea : clusterCentroid;
+        float normalLength = glm::length(clusterNormal);
+        clusterNormal = normalLength > 0.0f ? clusterNormal / normalLength : clusterNormal;
+
+        sortKeys[i] = std::make_pair(glm::dot(clusterCentroid - meshCentroid, clusterNormal), i);
+      }
+
+      std::stable_sort(sortKeys.begin(), sortKeys.end(),
+                       [](const std::pair<float, uint> &a, const std::pair<float, uint> &b)
+      {
+        return a.first > b.first;
+      });
+
+      std::vector<uint> outIndices;
+      outIndices.reserve(indices.size());
+      for (auto& [key, cluster] : sortKeys)
+        outIndices.insert(outIndices.end(), indices.begin() + 3 * clusters[cluster],
+                          indices.begin() + 3 * clusters[cluster + 1]);
+
+      indices.swap(outIndices);
+    }
+
+    void
+    optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<uint> &indices)
+    {
+      std::vector<uint> remap(vertices.size(), std::numeric_limits<uint>::max());
+      uint numUsedVertices = 0;
+      for (auto& index : indices)
+      {
+        if (remap[index] == std::numeric_limits<uint>::max())
+          remap[index] = numUsedVertices++;
+        index = remap[index];
+      }
+
+      std::vector<Vertex> outVertices(numUsedVertices);
+      for (uint i = 0; i < vertices.size(); i++)
+        if (remap[i] != std::numeric_limits<uint>::max())
+          outVertices[remap[i]] = vertices[i];
+
+      vertices.swap(outVertices);
+    }
+
+    // Symmetric 4x4 matrix measuring the weighted sum of squared distances
+    // to a set of planes, along with the sum of the weights.
+    struct Quadric
+    {
+      double a00, a01, a02, a03;
+      double a11, a12, a13;
+      double a22, a23;
+      double a33;
+      double weight;
+
+      Quadric()
+        : a00(0.0), a01(0.0), a02(0.0), a03(0.0)
+        , a11(0.0), a12(0.0), a13(0.0)
+        , a22(0.0), a23(0.0)
+        , a33(0.0)
+        , weight(0.0)
+      { }
+
+      void addPlane(const glm::vec3 &normal, float distance, float weight)
+      {
+        double a = normal.x, b = normal.y, c = normal.z, d = distance;
+        a00 += weight * a * a; a01 += weight * a * b; a02 += weight * a * c; a03 += weight * a * d;
+        a11 += weight * b * b; a12 += weight * b * c; a13 += weight * b * d;
+        a22 += weight * c * c; a23 += weight * c * d;
+        a33 += weight * d * d;
+        this->weight += weight;
+      }
+
+      void add(const Quadric &other)
+      {
+        a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+        a11 += other.a11; a12 += other.a12; a13 += other.a13;
+        a22 += other.a22; a23 += other.a23;
+        a33 += other.a33;
+        weight += other.weight;
+      }
+
+      // Weighted mean of the squared distances, so the error doesn't shrink
+      // as the triangles get smaller.
+      double evaluate(const glm::vec3 &point) const
+      {
+        if (weight <= 0.0)
+          return 0.0;
+
+        double x = point.x, y = point.y, z = point.z;
+        double error = a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x
+                     + a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y
+                     + a22 * z * z + 2.0 * a23 * z
+                     + a33;
+        return error > 0.0 ? error / weight : 0.0;
+      }
+    };
+
+    // Squared distance from a point to the closest point of a triangle.
+    static float
+    pointTriangleDistanceSquared(const glm::vec3 &p, const glm::vec3 &a, const glm::vec3 &b,
+                                 const glm::vec3 &c)
+    {
+      // Find the closest feature by the barycentric regions, as in Ericson's
+      // Real-Time Collision Detection.
+      glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+      float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+      glm::vec3 closest;
+      if (d1 <= 0.0f && d2 <= 0.0f)
+        closest = a;
+      else
+      {
+        glm::vec3 bp = p - b;
+        float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+        glm::vec3 cp = p - c;
+        float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+        float vc = d1 * d4 - d3 * d2;
+        float vb = d5 * d2 - d1 * d6;
+        float va = d3 * d6 - d5 * d4;
+
+        if (d3 >= 0.0f && d4 <= d3)
+          closest = b;
+        else if (d6 >= 0.0f && d5 <= d6)
+          closest = c;
+        else if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+          closest = a + ab * (d1 / (d1 - d3));
+        else if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+          closest = a + ac * (d2 / (d2 - d6));
+        else if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+          closest = b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+        else
+        {
+          float denominator = va + vb + vc;
+          if (denominator == 0.0f)
+            closest = a;
+          else
+            closest = a + ab * (vb / denominator) + ac * (vc / denominator);
+        }
+      }
+
+      glm::vec3 offset = p - closest;
+      return glm::dot(offset, offset);
+    }
+
+    // The triangles around each vertex, as ranges of the adjacency list.
+    static void
+    buildTriangleAdjacency(const std::vector<uint> &indices, uint numVertices,
+                           std::vector<uint> &outOffsets, std::vector<uint> &outAdjacency)
+    {
+      outOffsets.assign(numVertices + 1, 0);
+      for (auto index : indices)
+        outOffsets[index + 1]++;
+      for (uint i = 0; i < numVertices; i++)
+        outOffsets[i + 1] += outOffsets[i];
+
+      outAdjacency.resize(indices.size());
+      std::vector<uint> fill(outOffsets.begin(), outOffsets.end() - 1);
+      for (std::size_t i = 0; i < indices.size(); i++)
+        outAdjacency[fill[indices[i]]++] = static_cast<uint>(i / 3);
+    }
+
+    struct EdgeCollapse
+    {
+      uint from;
+      uint to;
+      float error;
+    };
+
+    std::vector<uint>
+    simplify(const std::vector<uint> &indices, const std::vector<Vertex> &vertices,
+             uint targetIndexCount, float targetError, float* outError)
+    {
+      uint numVertices = static_cast<uint>(vertices.size());
+      std::vector<uint> result = indices;
+      if (outError)
+        *outError = 0.0f;
+      if (indices.size() % 3 != 0 || result.size() <= targetIndexCount)
+        return result;
+
+      auto position = [&](uint vertex) { return glm::vec3(vertices[vertex].position); };
+
+      // Vertices which share a position are split along a seam. Weld them so
+      // borders can be found from the connectivity.
+      std::vector<uint> welded(numVertices);
+      std::vector<uint> numSharing(numVertices, 0);
+      {
+        struct PositionHash
+        {
+          std::size_t operator()(const glm::vec3 &p) const
+          {
+            uint32_t bits[3];
+            std::memcpy(bits, &p.x, sizeof(bits));
+            return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+          }
+        };
+        std::unordered_map<glm::vec3, uint, PositionHash> firstVertex;
+        firstVertex.reserve(numVertices);
+        for (uint i = 0; i < numVertices; i++)
+        {
+          welded[i] = firstVertex.emplace(position(i), i).first->second;
+          numSharing[welded[i]]++;
+        }
+      }
+
+      // Count how many triangles use each welded edge. Edges with only one
+      // triangle are on the border of the mesh.
+      auto edgeKey = [&](uint a, uint b)
+      {
+        uint weldedA = welded[a], weldedB = welded[b];
+        return weldedA < weldedB ? (static_cast<uint64_t>(weldedA) << 32) | weldedB
+                                 : (static_cast<uint64_t>(weldedB) << 32) | weldedA;
+      };
+      std::unordered_map<uint64_t, uint> edgeUses;
+      edgeUses.reserve(indices.size());
+      for (std::size_t i = 0; i < indices.size(); i += 3)
+        for (uint j = 0; j < 3; j++)
+          edgeUses[edgeKey(indices[i + j], indices[i + (j + 1) % 3])]++;
+
+      std::vector<bool> locked(numVertices, false);
+      for (uint i = 0; i < numVertices; i++)
+        locked[i] = numSharing[welded[i]] > 1;
+      for (std::size_t i = 0; i < indices.size(); i += 3)
+      {
+        for (uint j = 0; j < 3; j++)
+        {
+          uint a = indices[i + j], b = indices[i + (j + 1) % 3];
+          if (edgeUses[edgeKey(a, b)] != 2)
+          {
+            locked[a] = true;
+            locked[b] = true;
+          }
+        }
+      }
+
+      // Area weighted plane quadrics, scaled so errors are relative to the
+      // extent of the mesh. Evaluating one averages over the weights, so the
+      // error is a distance whatever the triangle density.
+      glm::vec3 minPos(std::numeric_limits<float>::max());
+      glm::vec3 maxPos(-std::numeric_limits<float>::max());
+      for (auto index : indices)
+      {
+        minPos = glm::min(minPos, position(index));
+        maxPos = glm::max(maxPos, position(index));
+      }
+      glm::vec3 extents = maxPos - minPos;
+      float extent = std::max(extents.x, std::max(extents.y, extents.z));
+      float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+
+      std::vector<Quadric> quadrics(numVertices);
+      for (std::size_t i = 0; i < indices.size(); i += 3)
+      {
+        glm::vec3 p0 = position(indices[i]) * scale;
+        glm::vec3 p1 = position(indices[i + 1]) * scale;
+        glm::vec3 p2 = position(indices[i + 2]) * scale;
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float area = glm::length(normal);
+        if (area == 0.0f)
+          continue;
+
+        normal /= area;
+        for (uint j = 0; j < 3; j++)
+          quadrics[indices[i + j]].addPlane(normal, -glm::dot(normal, p0), area);
+      }
+
+      auto collapseError = [&](uint from, uint to)
+      {
+        Quadric combined = quadrics[from];
+        combined.add(quadrics[to]);
+        return static_cast<float>(combined.evaluate(position(to) * scale));
+      };
+
+      float maxErrorSquared = targetError * targetError;
+
+      // The vertex each source vertex ended up collapsed onto.
+      std::vector<uint> collapsedTo(numVertices);
+      for (uint i = 0; i < numVertices; i++)
+        collapsedTo[i] = i;
+
+      std::vector<uint> remap(numVertices);
+      std::vector<bool> touched(numVertices);
+      std::vector<uint> adjacencyOffsets;
+      std::vector<uint> adjacency;
+      std::vector<EdgeCollapse> collapses;
+
+      // Collapse in passes. Each pass only touches a vertex once so the flip
+      // checks see up to date triangles.
+      while (result.size() > targetIndexCount)
+      {
+        uint numTriangles = static_cast<uint>(result.size() / 3);
+        buildTriangleAdjacency(result, numVertices, adjacencyOffsets, adjacency);
+
+        // Every edge once, in the cheapest direction which is allowed. Edges
+        // with an unlocked vertex are shared by two triangles with opposite
+        // windings, so only take them one way round.
+        collapses.clear();
+        for (uint i = 0; i < numTriangles; i++)
+        {
+          for (uint j = 0; j < 3; j++)
+          {
+            uint a = result[3 * i + j], b = result[3 * i + (j + 1) % 3];
+            if (a > b || (locked[a] && locked[b]))
+              continue;
+
+            float errorAB = locked[a] ? std::numeric_limits<float>::max() : collapseError(a, b);
+            float errorBA = locked[b] ? std::numeric_limits<float>::max() : collapseError(b, a);
+            if (errorAB <= errorBA)
+              collapses.push_back({ a, b, errorAB });
+            else
+              collapses.push_back({ b, a, errorBA });
+          }
+        }
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const EdgeCollapse &a, const EdgeCollapse &b) { return a.error < b.error; });
+
+        for (uint i = 0; i < numVertices; i++)
+          remap[i] = i;
+        std::fill(touched.begin(), touched.end(), false);
+
+        uint trianglesToRemove = static_cast<uint>((result.size() - targetIndexCount) / 3);
+        uint trianglesRemoved = 0;
+        uint numCollapsed = 0;
+        for (auto& collapse : collapses)
+        {
+          if (collapse.error > maxErrorSquared || trianglesRemoved >= trianglesToRemove)
+            break;
+          if (touched[collapse.from] || touched[collapse.to])
+            continue;
+
+          // Reject the collapse if it flips any of the remaining triangles.
+          bool flips = false;
+          uint removedTriangles = 0;
+          glm::vec3 target = position(collapse.to);
+          for (uint j = adjacencyOffsets[collapse.from]; j < adjacencyOffsets[collapse.from + 1]; j++)
+          {
+            const uint* triangle = &result[3 * adjacency[j]];
+            if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+            {
+              removedTriangles++;
+              continue;
+            }
+
+            glm::vec3 before[3], after[3];
+            for (uint k = 0; k < 3; k++)
+            {
+              before[k] = position(triangle[k]);
+              after[k] = triangle[k] == collapse.from ? target : before[k];
+            }
+            glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+            glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+            float lengths = glm::length(normalBefore) * glm::length(normalAfter);
+            if (lengths == 0.0f || glm::dot(normalBefore, normalAfter) < 0.25f * lengths)
+            {
+              flips = true;
+              break;
+            }
+          }
+          if (flips)
+            continue;
+
+          remap[collapse.from] = collapse.to;
+          quadrics[collapse.to].add(quadrics[collapse.from]);
+
+          // Lock the whole neighbourhood for the rest of the pass.
+          for (uint j = adjacencyOffsets[collapse.from]; j < adjacencyOffsets[collapse.from + 1]; j++)
+            for (uint k = 0; k < 3; k++)
+              touched[result[3 * adjacency[j] + k]] = true;
+
+          trianglesRemoved += removedTriangles;
+          numCollapsed++;
+        }
+
+        if (numCollapsed == 0)
+          break;
+
+        for (uint i = 0; i < numVertices; i++)
+          collapsedTo[i] = remap[collapsedTo[i]];
+
+        // Apply the collapses and drop the triangles which became degenerate.
+        std::size_t writeIndex = 0;
+        for (std::size_t i = 0; i < result.size(); i += 3)
+        {
+          uint a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+          if (a == b || b == c || c == a)
+            continue;
+
+          result[writeIndex++] = a;
+          result[writeIndex++] = b;
+          result[writeIndex++] = c;
+        }
+        result.resize(writeIndex);
+      }
+
+      // The quadrics only estimate the error, and can say a lot less than
+      // the surface actually moved. Measure the distance between the two
+      // surfaces both ways instead: from each removed vertex to the nearby
+      // simplified triangles, and from the centers and edge midpoints of
+      // the simplified triangles to the source triangles they replaced.
+      if (outError && result.size() < indices.size())
+      {
+        std::vector<uint> sourceOffsets, sourceAdjacency;
+        buildTriangleAdjacency(indices, numVertices, sourceOffsets, sourceAdjacency);
+        buildTriangleAdjacency(result, numVertices, adjacencyOffsets, adjacency);
+
+        // The source vertices which went into each remaining vertex.
+        std::vector<uint> memberOffsets(numVertices + 1, 0);
+        for (uint i = 0; i < numVertices; i++)
+          memberOffsets[collapsedTo[i] + 1]++;
+        for (uint i = 0; i < numVertices; i++)
+          memberOffsets[i + 1] += memberOffsets[i];
+        std::vector<uint> members(numVertices);
+        std::vector<uint> memberFill(memberOffsets.begin(), memberOffsets.end() - 1);
+        for (uint i = 0; i < numVertices; i++)
+          members[memberFill[collapsedTo[i]]++] = i;
+
+        auto triangleDistanceSquared = [&](const glm::vec3 &point, const uint* triangle)
+        {
+          return pointTriangleDistanceSquared(point, position(triangle[0]), position(triangle[1]),
+                                              position(triangle[2]));
+        };
+
+        float resultErrorSquared = 0.0f;
+        for (uint i = 0; i < numVertices; i++)
+        {
+          if (collapsedTo[i] == i)
+            continue;
+
+          // The simplified triangles around wherever its neighbours went.
+          float distanceSquared = std::numeric_limits<float>::max();
+          for (uint j = sourceOffsets[i]; j < sourceOffsets[i + 1]; j++)
+          {
+            for (uint k = 0; k < 3; k++)
+            {
+              uint target = collapsedTo[indices[3 * sourceAdjacency[j] + k]];
+              for (uint l = adjacencyOffsets[target]; l < adjacencyOffsets[target + 1]; l++)
+                distanceSquared = std::min(distanceSquared,
+                  triangleDistanceSquared(position(i), &result[3 * adjacency[l]]));
+            }
+          }
+          if (distanceSquared != std::numeric_limits<float>::max())
+            resultErrorSquared = std::max(resultErrorSquared, distanceSquared);
+        }
+
+        for (std::size_t i = 0; i < result.size(); i += 3)
+        {
+          glm::vec3 p0 = position(result[i]), p1 = position(result[i + 1]), p2 = position(result[i + 2]);
+          const glm::vec3 samples[4] = { (p0 + p1 + p2) / 3.0f, (p0 + p1) * 0.5f,
+                                         (p1 + p2) * 0.5f, (p2 + p0) * 0.5f };
+
+          float distancesSquared[4];
+          std::fill(distancesSquared, distancesSquared + 4, std::numeric_limits<float>::max());
+          for (uint j = 0; j < 3; j++)
+          {
+            for (uint k = memberOffsets[result[i + j]]; k < memberOffsets[result[i + j] + 1]; k++)
+            {
+              uint member = members[k];
+              for (uint l = sourceOffsets[member]; l < sourceOffsets[member + 1]; l++)
+                for (uint m = 0; m < 4; m++)
+                  distancesSquared[m] = std::min(distancesSquared[m],
+                    triangleDistanceSquared(samples[m], &indices[3 * sourceAdjacency[l]]));
+            }
+          }
+          for (uint m = 0; m < 4; m++)
+            resultErrorSquared = std::max(resultErrorSquared, distancesSquared[m]);
+        }
+
+        *outError = std::sqrt(resultErrorSquared) * scale;
+      }
+
+      return result;
+    }
+
+    OptimizationReport
+    optimizeMesh(Mesh &mesh)
+    {
+      OptimizationReport report;
+
+      auto& vertices = mesh.getData();
+      auto& indices = mesh.getIndices();
+
+      // Only triangle lists can be reordered.
+      if (!mesh.isLoaded() || indices.empty() || indices.size() % 3 != 0)
+        return report;
+
+      uint numVertices = static_cast<uint>(vertices.size());
+      report.before = analyzeVertexCache(indices, numVertices);
+
+      optimizeVertexCache(indices, numVertices);
+      optimizeOverdraw(indices, vertices);
+      optimizeVertexFetch(vertices, indices);
+
+      report.after = analyzeVertexCache(indices, static_cast<uint>(vertices.size()));
+      return report;
+    }
+
+    void
+    generateLODs(Mesh &mesh, float maxError)
+    {
+      auto& vertices = mesh.getData();
+      auto& indices = mesh.getIndices();
+      auto& lods = mesh.getLODs();
+      lods.clear();
+
+      // Small meshes aren't worth the extra index buffers.
+      if (!mesh.isLoaded() || indices.size() % 3 != 0 || indices.size() < 3 * 256)
+        return;
+
+      // Every level is simplified from the full mesh so the errors don't
+      // compound.
+      std::size_t previousCount = indices.size();
+      for (uint level = 1; level < MAX_MESH_LODS; level++)
+      {
+        uint targetCount = static_cast<uint>(indices.size() >> level) / 3 * 3;
+
+        float error = 0.0f;
+        auto lodIndices = simplify(indices, vertices, targetCount, maxError, &error);
+
+        // Stop once the simplifier can't make meaningful progress.
+        if (lodIndices.empty() || lodIndices.size() > previousCount * 3 / 4)
+          break;
+
+        optimizeVertexCache(lodIndices, static_cast<uint>(vertices.size()));
+        previousCount = lodIndices.size();
+        lods.emplace_back(std::move(lodIndices), error);
+      }
+    }
+
+    // Bounding sphere and normal cone of a run of triangles.
+    static Meshlet
+    computeMeshletBounds(const std::vector<uint> &indices, const std::vector<Vertex> &vertices,
+                         uint indexOffset, uint indexCount, uint vertexCount)
+    {
+      Meshlet meshlet;
+      meshlet.indexOffset = indexOffset;
+      meshlet.indexCount = indexCount;
+      meshlet.vertexCount = vertexCount;
+
+      // Sphere around the center of the box, tight enough for culling.
+      glm::vec3 minPos(std::numeric_limits<float>::max());
+      glm::vec3 maxPos(-std::numeric_limits<float>::max());
+      for (uint i = indexOffset; i < indexOffset + indexCount; i++)
+      {
+        glm::vec3 position = glm::vec3(vertices[indices[i]].position);
+        minPos = glm::min(minPos, position);
+        maxPos = glm::max(maxPos, position);
+      }
+
+      glm::vec3 center = 0.5f * (minPos + maxPos);
+      float radiusSquared = 0.0f;
+      for (uint i = indexOffset; i < indexOffset + indexCount; i++)
+      {
+        glm::vec3 offset = glm::vec3(vertices[indices[i]].position) - center;
+        radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+      }
+      meshlet.boundingSphere = glm::vec4(center, std::sqrt(radiusSquared));
+
+      // Average the face normals for the cone axis, then widen the cone until
+      // it holds every normal.
+      std::vector<glm::vec3> normals;
+      normals.reserve(indexCount / 3);
+      glm::vec3 axis(0.0f);
+      for (uint i = indexOffset; i < indexOffset + indexCount; i += 3)
+      {
+        glm::vec3 p0 = glm::vec3(vertices[indices[i]].position);
+        glm::vec3 p1 = glm::vec3(vertices[indices[i + 1]].position);
+        glm::vec3 p2 = glm::vec3(vertices[indices[i + 2]].position);
+
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float length = glm::length(normal);
+        if (length > 0.0f)
+        {
+          normals.push_back(normal / length);
+          axis += normals.back();
+        }
+      }
+
+      // A cutoff of 1 never culls, used when the normals are too spread out
+      // for the cone to reject anything.
+      meshlet.normalCone = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+      float axisLength = glm::length(axis);
+      if (axisLength <= 0.0f)
+        return meshlet;
+
+      axis /= axisLength;
+      float minDot = 1.0f;
+      for (auto& normal : normals)
+        minDot = std::min(minDot, glm::dot(axis, normal));
+
+      // The cone of view directions which only see back faces is the normal
+      // cone widened by 90 degrees, so its cutoff is the sine of the spread.
+      if (minDot > 0.1f)
+        meshlet.normalCone = glm::vec4(axis, std::sqrt(1.0f - minDot * minDot));
+
+      return meshlet;
+    }
+
+    void
+    buildMeshlets(Mesh &mesh)
+    {
+      auto& vertices = mesh.getData();
+      auto& indices = mesh.getIndices();
+      auto& meshlets = mesh.getMeshlets();
+      meshlets.clear();
+
+      // Meshes which fit in a single meshlet are culled as a whole already.
+      if (!mesh.isLoaded() || indices.size() % 3 != 0
+          || indices.size() <= 3 * MAX_MESHLET_TRIANGLES)
+        return;
+
+      // The last meshlet each vertex was counted in.
+      std::vector<uint> vertexMeshlet(vertices.size(), std::numeric_limits<uint>::max());
+
+      uint meshletStart = 0;
+      uint meshletVertices = 0;
+      for (uint i = 0; i < indices.size(); i += 3)
+      {
+        uint meshletIndex = static_cast<uint>(meshlets.size());
+        uint newVertices = 0;
+        for (uint j = 0; j < 3; j++)
+          newVertices += vertexMeshlet[indices[i + j]] != meshletIndex ? 1 : 0;
+
+        // Close the meshlet once this triangle doesn't fit.
+        if (meshletVertices + newVertices > MAX_MESHLET_VERTICES
+            || (i - meshletStart) / 3 == MAX_MESHLET_TRIANGLES)
+        {
+          meshlets.push_back(computeMeshletBounds(indices, vertices, meshletStart,
+                                                  i - meshletStart, meshletVertices));
+          meshletIndex++;
+          meshletStart = i;
+          meshletVertices = 0;
+        }
+
+        for (uint j = 0; j < 3; j++)
+        {
+          if (vertexMeshlet[indices[i + j]] != meshletIndex)
+          {
+            vertexMeshlet[indices[i + j]] = meshletIndex;
+            meshletVertices++;
+          }
+        }
+      }
+
+      meshlets.push_back(computeMeshletBounds(indices, vertices, meshletStart,
+                                              static_cast<uint>(indices.size()) - meshletStart,
+                                              meshletVertices));
+    }
+  }
+}
@@ -2,15 +2,95 @@
 
 // Project includes.
 #include "Core/Logs.h"
+#include "Graphics/Model.h"
+#include "Graphics/ModelCache.h"
+
+// GLM stuff.
+#include "glm/gtc/packing.hpp"
+
+// STL includes.
+#include <atomic>
 
 namespace Strontium
 {
+  // Octahedral encoding of a unit vector. The vector is projected onto the
+  // octahedron and the lower half is folded over the diagonals into [-1, 1]^2.
+  static glm::vec2
+  encodeOctahedral(const glm::vec3 &vector)
+  {
+    float l1Norm = std::abs(vector.x) + std::abs(vector.y) + std::abs(vector.z);
+    if (l1Norm == 0.0f)
+      return glm::vec2(0.0f);
+
+    glm::vec2 encoded = glm::vec2(vector.x, vector.y) / l1Norm;
+    if (vector.z < 0.0f)
+    {
+      glm::vec2 signs(encoded.x >= 0.0f ? 1.0f : -1.0f, encoded.y >= 0.0f ? 1.0f : -1.0f);
+      encoded = (1.0f - glm::abs(glm::vec2(encoded.y, encoded.x))) * signs;
+    }
+
+    return encoded;
+  }
+
+  // Pack the vertices into the compact format. Fails if a bone index doesn't
+  // fit in a byte.
+  static bool
+  packVertices(const std::vector<Vertex> &vertices, std::vector<PackedVertex> &outVertices)
+  {
+    outVertices.resize(vertices.size());
+    for (std::size_t i = 0; i < vertices.size(); i++)
+    {
+      const Vertex& vertex = vertices[i];
+      PackedVertex& packed = outVertices[i];
+
+      packed.position = glm::vec3(vertex.position);
+      packed.normal = glm::packSnorm2x16(encodeOctahedral(vertex.normal));
+
+      float handedness = glm::dot(glm::cross(vertex.normal, vertex.tangent), vertex.bitangent) < 0.0f
+                         ? -1.0f : 1.0f;
+      packed.tangent = glm::packSnorm3x10_1x2(glm::vec4(encodeOctahedral(vertex.tangent),
+                                                        0.0f, handedness));
+      packed.uv = glm::packHalf2x16(vertex.uv);
+
+      packed.boneIDs = 0;
+      for (uint j = 0; j < 4; j++)
+      {
+        if (vertex.boneIDs[j] > 255)
+          return false;
+        packed.boneIDs |= static_cast<uint32_t>(vertex.boneIDs[j]) << (8 * j);
+      }
+
+      // Give the rounding error to the largest weight so they still sum to one.
+      glm::ivec4 weights = glm::ivec4(glm::round(glm::clamp(vertex.boneWeights, 0.0f, 1.0f) * 255.0f));
+      int weightSum = weights.x + weights.y + weights.z + weights.w;
+      if (weightSum > 0)
+      {
+        uint largest = 0;
+        for (uint j = 1; j < 4; j++)
+          largest = weights[j] > weights[largest] ? j : largest;
+        weights[largest] = glm::clamp(weights[largest] + 255 - weightSum, 0, 255);
+      }
+      packed.boneWeights = static_cast<uint32_t>(weights.x) | static_cast<uint32_t>(weights.y) << 8
+                         | static_cast<uint32_t>(weights.z) << 16 | static_cast<uint32_t>(weights.w) << 24;
+    }
+
+    return true;
+  }
+
   Mesh::Mesh(const std::string &name, Model* parent)
     : loaded(false)
     , skinned(false)
+    , dataReleased(false)
+    , numVertices(0)
+    , numIndices(0)
+    , cookedOffset(0)
     , name(name)
     , parent(parent)
     , localTransform(1.0f)
+    , requestedFormat(VertexFormat::Full)
+    , vertexFormat(VertexFormat::Full)
+    , vertexBytes(0)
+    , inArena(false)
   { }
 
   Mesh::Mesh(const std::string &name, const std::vector<Vertex> &vertices,
@@ -20,30 +100,210 @@ namespace Strontium
     , data(vertices)
     , indices(indices)
     , vArray(nullptr)
+    , dataReleased(false)
+    , numVertices(0)
+    , numIndices(0)
+    , cookedOffset(0)
     , name(name)
     , parent(parent)
     , localTransform(1.0f)
+    , requestedFormat(VertexFormat::Full)
+    , vertexFormat(VertexFormat::Full)
+    , vertexBytes(0)
+    , inArena(false)
   { }
 
   Mesh::~Mesh()
   { }
 
+  // Running totals for the memory report.
+  static std::atomic<uint> numReleasedMeshes(0);
+  static std::atomic<uint64_t> numReleasedBytes(0);
+  static std::atomic<uint> numReloadedMeshes(0);
+  static std::atomic<uint64_t> numReloadedBytes(0);
+
   void
-  Mesh::generateVAO()
+  Mesh::generateVAO(VertexFormat format)
   {
     if (!this->isLoaded())
       return;
 
-    this->vArray = createUnique<VertexArray>(this->data.data(), this->data.size() * sizeof(Vertex), BufferType::Dynamic);
-    this->vArray->addIndexBuffer(this->indices.data(), this->indices.size(), BufferType::Dynamic);
+    this->requestedFormat = format;
 
-    this->vArray->addAttribute(0, AttribType::Vec4, false, sizeof(Vertex), 0);
-  	this->vArray->addAttribute(1, AttribType::Vec3, false, sizeof(Vertex), offsetof(Vertex, normal));
-    this->vArray->addAttribute(2, AttribType::Vec2, false, sizeof(Vertex), offsetof(Vertex, uv));
-    this->vArray->addAttribute(3, AttribType::Vec3, false, sizeof(Vertex), offsetof(Vertex, tangent));
-    this->vArray->addAttribute(4, AttribType::Vec3, false, sizeof(Vertex), offsetof(Vertex, bitangent));
+    // Keep the old vertex array if the data can't be brought back.
+    if (!this->reloadData())
+      return;
+
+    std::vector<PackedVertex> packedData;
+    if (format == VertexFormat::Packed && packVertices(this->data, packedData))
+    {
+      this->vertexFormat = VertexFormat::Packed;
+      this->vertexBytes = packedData.size() * sizeof(PackedVertex);
+
+      this->vArray = createUnique<VertexArray>(packedData.data(), this->vertexBytes, BufferType::Dynamic);
+      this->vArray->addIndexBuffer(this->indices.data(), this->indices.size(), BufferType::Dynamic);
+      for (auto& lod : this->lods)
+        this->vArray->addIndexBuffer(lod.indices.data(), lod.indices.size(), BufferType::Dynamic);
+
+      this->vArray->addAttribute(0, AttribType::Vec3, false, sizeof(PackedVertex), 0);
+      this->vArray->addAttribute(1, AttribType::Short2, true, sizeof(PackedVertex), offsetof(PackedVertex, normal));
+      this->vArray->addAttribute(2, AttribType::Half2, false, sizeof(PackedVertex), offsetof(PackedVertex, uv));
+      this->vArray->addAttribute(3, AttribType::Int2101010, true, sizeof(PackedVertex), offsetof(PackedVertex, tangent));
+
+      this->vArray->addAttribute(5, AttribType::UByte4, true, sizeof(PackedVertex), offsetof(PackedVertex, boneWeights));
+      this->vArray->addAttribute(6, AttribType::IUByte4, false, sizeof(PackedVertex), offsetof(PackedVertex, boneIDs));
+    }
+    else
+    {
+      this->vertexFormat = VertexFormat::Full;
+      this->vertexBytes = this->data.size() * sizeof(Vertex);
+
+      this->vArray = createUnique<VertexArray>(this->data.data(), this->data.size() * sizeof(Vertex), BufferType::Dynamic);
+      this->vArray->addIndexBuffer(this->indices.data(), this->indices.size(), BufferType::Dynamic);
+      for (auto& lod : this->lods)
+        this->vArray->addIndexBuffer(lod.indices.data(), lod.indices.size(), BufferType::Dynamic);
+
+      this->vArray->addAttribute(0, AttribType::Vec4, false, sizeof(Vertex), 0);
+      this->vArray->addAttribute(1, AttribType::Vec3, false, sizeof(Vertex), offsetof(Vertex, normal));
+      this->vArray->addAttribute(2, AttribType::Vec2, false, sizeof(Vertex), offsetof(Vertex, uv));
+      this->vArray->addAttribute(3, AttribType::Vec3, false, sizeof(Vertex), offsetof(Vertex, tangent));
+      this->vArray->addAttribute(4, AttribType::Vec3, false, sizeof(Vertex), offsetof(Vertex, bitangent));
+
+      this->vArray->addAttribute(5, AttribType::Vec4, false, sizeof(Vertex), offsetof(Vertex, boneWeights));
+      this->vArray->addAttribute(6, AttribType::UVec4, false, sizeof(Vertex), offsetof(Vertex, boneIDs));
+    }
 
-    this->vArray->addAttribute(5, AttribType::Vec4, false, sizeof(Vertex), offsetof(Vertex, boneWeights));
-    this->vArray->addAttribute(6, AttribType::IVec4, false, sizeof(Vertex), offsetof(Vertex, boneIDs));
+    // Everything the GPU needs is uploaded now.
+    if (this->parent && this->parent->canReleaseMeshData())
+      this->releaseData();
+  }
+
+  uint64_t
+  Mesh::releaseData()
+  {
+    if (this->dataReleased || this->cookedOffset == 0)
+      return 0;
+
+    uint64_t freedBytes = this->data.capacity() * sizeof(Vertex)
+                        + this->indices.capacity() * sizeof(uint);
+
+    this->numVertices = static_cast<uint>(this->data.size());
+    this->numIndices = static_cast<uint>(this->indices.size());
+    std::vector<Vertex>().swap(this->data);
+    std::vector<uint>().swap(this->indices);
+    for (auto& lod : this->lods)
+    {
+      freedBytes += lod.indices.capacity() * sizeof(uint);
+      lod.numIndices = static_cast<uint>(lod.indices.size());
+      std::vector<uint>().swap(lod.indices);
+    }
+
+    this->dataReleased = true;
+    numReleasedMeshes++;
+    numReleasedBytes += freedBytes;
+
+    return freedBytes;
+  }
+
+  // Bring released data back from the parent model's cooked file.
+  bool
+  Mesh::reloadData()
+  {
+    if (!this->dataReleased)
+      return true;
+
+    if (!this->parent || !ModelCache::readCookedMesh(*this, this->parent->getFilepath(),
+                                                     this->parent->cookedKey))
+    {
+      Logger::getInstance()->logMessage(LogMessage("Failed to reload the released data for the submesh "
+                                                   + this->name + ".", true, true));
+      return false;
+    }
+
+    this->dataReleased = false;
+    numReloadedMeshes++;
+    numReloadedBytes += this->data.size() * sizeof(Vertex) + this->indices.size() * sizeof(uint);
+    for (auto& lod : this->lods)
+      numReloadedBytes += lod.indices.size() * sizeof(uint);
+
+    return true;
+  }
+
+  bool
+  Mesh::uploadToArena()
+  {
+    if (this->inArena)
+      return true;
+    if (!this->isLoaded() || !this->reloadData())
+      return false;
+
+    uint numIndices = 0;
+    for (uint i = 0; i < this->getNumLODs(); i++)
+      numIndices += this->getNumIndices(i);
+
+    auto arena = GeometryArena::getInstance();
+    if (!arena->allocate(static_cast<uint>(this->data.size()), numIndices, this->arenaAllocation))
+      return false;
+
+    arena->setVertices(this->arenaAllocation.firstVertex, this->data.data(),
+                       static_cast<uint>(this->data.size()));
+    arena->setIndices(this->arenaAllocation.firstIndex, this->indices.data(),
+                      static_cast<uint>(this->indices.size()));
+    for (uint i = 1; i < this->getNumLODs(); i++)
+    {
+      auto& lodIndices = this->lods[i - 1].indices;
+      arena->setIndices(this->getArenaFirstIndex(i), lodIndices.data(),
+                        static_cast<uint>(lodIndices.size()));
+    }
+
+    this->inArena = true;
+
+    if (this->parent && this->parent->canReleaseMeshData())
+      this->releaseData();
+
+    return true;
+  }
+
+  void
+  Mesh::freeArena()
+  {
+    if (!this->inArena)
+      return;
+
+    GeometryArena::getInstance()->free(this->arenaAllocation);
+    this->arenaAllocation = ArenaAllocation();
+    this->inArena = false;
+  }
+
+  uint
+  Mesh::getArenaFirstIndex(uint lod)
+  {
+    uint firstIndex = this->arenaAllocation.firstIndex;
+    for (uint i = 0; i < lod; i++)
+      firstIndex += this->getNumIndices(i);
+
+    return firstIndex;
+  }
+
+  MeshMemoryReport
+  Mesh::getMemoryReport()
+  {
+    MeshMemoryReport report;
+    report.numReleased = numReleasedMeshes;
+    report.releasedBytes = numReleasedBytes;
+    report.numReloaded = numReloadedMeshes;
+    report.reloadedBytes = numReloadedBytes;
+
+    return report;
+  }
+
+  uint
+  Mesh::getNumIndices(uint lod)
+  {
+    if (lod == 0)
+      return this->dataReleased ? this->numIndices : static_cast<uint>(this->indices.size());
+    else
+      return this->dataReleased ? this->lods[lod - 1].numIndices
+                                : static_cast<uint>(this->lods[lod - 1].indices.size());
   }
 }
@@ -3,6 +3,9 @@
 // Project includes.
 #include "Core/Logs.h"
 #include "Core/Events.h"
+#include "Core/ThreadPool.h"
+#include "Graphics/ModelCache.h"
+#include "Graphics/MeshOptimizer.h"
 #include "Utils/AssimpUtilities.h"
 
 // GLM stuff.
@@ -12,9 +15,27 @@
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <assimp/ProgressHandler.hpp>
+
+// STL includes.
+#include <cstdio>
+#include <cstdlib>
 
 namespace Strontium
 {
+  // Tells Assimp to abort the import once the load has been cancelled.
+  class CancelProgressHandler : public Assimp::ProgressHandler
+  {
+  public:
+    CancelProgressHandler(const JobGroup* cancelGroup)
+      : cancelGroup(cancelGroup)
+    { }
+
+    bool Update(float percentage) override { return !this->cancelGroup->isCancelled(); }
+  private:
+    const JobGroup* cancelGroup;
+  };
+
   Model::Model()
     : loaded(false)
     , globalInverseTransform(1.0f)
@@ -22,26 +43,71 @@ namespace Strontium
     , minPos(std::numeric_limits<float>::max())
     , maxPos(std::numeric_limits<float>::min())
     , isSkinned(false)
+    , hasCookedFile(false)
+    , cookedKey(0)
+    , meshDataRetains(0)
   { }
 
   Model::~Model()
-  { }
+  {
+    for (auto& submesh : this->subMeshes)
+      submesh.freeArena();
+  }
 
   void
-  Model::load(const std::string &filepath)
+  Model::load(const std::string &filepath, const JobGroup* cancelGroup)
   {
     Logger* logs = Logger::getInstance();
     auto eventDispatcher = EventDispatcher::getInstance();
     eventDispatcher->queueEvent(new GuiEvent(GuiEventType::StartSpinnerEvent, filepath));
 
+    auto startTime = std::chrono::steady_clock::now();
+
     auto flags = aiProcess_Triangulate | aiProcess_GenNormals | aiProcess_GenUVCoords 
                 | aiProcess_OptimizeMeshes | aiProcess_ValidateDataStructure 
                 | aiProcess_JoinIdenticalVertices | aiProcess_CalcTangentSpace;
 
+    // Skip the importer entirely if this source file has already been cooked.
+    uint64_t cookedKey = 0;
+    bool hasCookedKey = ModelCache::computeSourceKey(filepath, flags, cookedKey);
+    if (hasCookedKey)
+    {
+      if (ModelCache::readCookedModel(*this, filepath, cookedKey))
+      {
+        this->filepath = filepath;
+        this->isSkinned = !this->storedBones.empty();
+        this->hasCookedFile = true;
+        this->cookedKey = cookedKey;
+        this->loaded = true;
+
+        float loadMilliseconds = std::chrono::duration<float, std::milli>(
+          std::chrono::steady_clock::now() - startTime).count();
+
+        eventDispatcher->queueEvent(new GuiEvent(GuiEventType::EndSpinnerEvent, ""));
+        logs->logMessage(LogMessage("Model loaded from the cooked cache at path " + filepath + " ("
+                                    + std::to_string(this->subMeshes.size()) + " submeshes, "
+                                    + std::to_string(loadMilliseconds) + " ms)."));
+        return;
+      }
+
+      // Stale or damaged, start over from the source file.
+      this->unload();
+    }
+
     Assimp::Importer importer;
 
+    // The importer takes ownership of the handler.
+    if (cancelGroup)
+      importer.SetProgressHandler(new CancelProgressHandler(cancelGroup));
+
     const aiScene* scene = importer.ReadFile(filepath, flags);
-    if (!scene)
+    if (cancelGroup && cancelGroup->isCancelled())
+    {
+      logs->logMessage(LogMessage("Cancelled loading the model at the path " + filepath + ".", true, true));
+      eventDispatcher->queueEvent(new GuiEvent(GuiEventType::EndSpinnerEvent, ""));
+      return;
+    }
+    else if (!scene)
     {
       logs->logMessage(LogMessage("Model failed to load at the path " + filepath +
                                   ", with the error: " + importer.GetErrorString()
@@ -74,7 +140,91 @@ namespace Strontium
     for (uint i = 0; i < scene->mRootNode->mNumChildren; i++)
       this->rootNode.childNames.emplace_back(scene->mRootNode->mChildren[i]->mName.C_Str());
     
-    this->processNode(scene->mRootNode, scene, directory);
+    // Walk the node hierarchy to find every submesh and its transform.
+    std::vector<std::pair<aiMesh*, glm::mat4>> meshNodes;
+    this->processNode(scene->mRootNode, scene, meshNodes);
+
+    // Reserve a slot for each submesh up front so they can be filled in
+    // parallel without the vector moving under the workers.
+    this->subMeshes.reserve(meshNodes.size());
+    for (auto& [mesh, transform] : meshNodes)
+    {
+      this->subMeshes.emplace_back(std::string(mesh->mName.C_Str()), this);
+      this->subMeshes.back().getTransform() = transform;
+    }
+
+    auto workerGroup = ThreadPool::getInstance();
+    workerGroup->parallelFor(0, static_cast<uint>(meshNodes.size()), 1, [&](uint i)
+    {
+      if (cancelGroup && cancelGroup->isCancelled())
+        return;
+      this->processMesh(meshNodes[i].first, scene, directory, this->subMeshes[i]);
+    });
+
+    if (cancelGroup && cancelGroup->isCancelled())
+    {
+      logs->logMessage(LogMessage("Cancelled loading the model at the path " + filepath + ".", true, true));
+      eventDispatcher->queueEvent(new GuiEvent(GuiEventType::EndSpinnerEvent, ""));
+      return;
+    }
+
+    // Merge the submeshes in order so the bounds and bone indices don't depend
+    // on which worker finished first.
+    std::vector<std::vector<uint>> meshBoneIndices(meshNodes.size());
+    for (uint i = 0; i < meshNodes.size(); i++)
+    {
+      aiMesh* mesh = meshNodes[i].first;
+      if (!this->subMeshes[i].isLoaded())
+        continue;
+
+      this->minPos = glm::min(this->minPos, this->subMeshes[i].getMinPos());
+      this->maxPos = glm::max(this->maxPos, this->subMeshes[i].getMaxPos());
+
+      if (mesh->HasBones())
+      {
+        this->isSkinned = true;
+        this->processBones(mesh, meshBoneIndices[i]);
+      }
+    }
+
+    // Bone weights only touch their own submesh, back to the workers.
+    if (this->isSkinned)
+    {
+      workerGroup->parallelFor(0, static_cast<uint>(meshNodes.size()), 1, [&](uint i)
+      {
+        if (!meshBoneIndices[i].empty())
+          this->loadBoneWeights(meshNodes[i].first, meshBoneIndices[i], this->subMeshes[i]);
+      });
+    }
+
+    // Reorder each submesh for the vertex cache, overdraw and vertex fetches,
+    // then build its simplified levels of detail and meshlets on top of the
+    // final order.
+    // The bone weights are in place by now so the vertices are free to move.
+    std::vector<MeshOptimizer::OptimizationReport> optimizationReports(meshNodes.size());
+    workerGroup->parallelFor(0, static_cast<uint>(meshNodes.size()), 1, [&](uint i)
+    {
+      optimizationReports[i] = MeshOptimizer::optimizeMesh(this->subMeshes[i]);
+      MeshOptimizer::generateLODs(this->subMeshes[i]);
+      MeshOptimizer::buildMeshlets(this->subMeshes[i]);
+    });
+
+    // Set SR_MESH_REPORT to log the vertex cache efficiency of every submesh.
+    if (std::getenv("SR_MESH_REPORT"))
+    {
+      char reportLine[256];
+      for (uint i = 0; i < meshNodes.size(); i++)
+      {
+        auto& report = optimizationReports[i];
+        std::snprintf(reportLine, sizeof(reportLine),
+                      "ACMR %.3f -> %.3f, ATVR %.3f -> %.3f (%u triangles, %u LODs)",
+                      report.before.acmr, report.after.acmr, report.before.atvr,
+                      report.after.atvr, static_cast<uint>(this->subMeshes[i].getIndices().size() / 3),
+                      this->subMeshes[i].getNumLODs());
+        logs->logMessage(LogMessage("Submesh " + this->subMeshes[i].getName() + " of "
+                                    + filepath + ": " + reportLine));
+      }
+    }
 
     // Load in animations.
     if (scene->HasAnimations())
@@ -85,19 +235,89 @@ namespace Strontium
 
     this->loaded = true;
 
+    if (hasCookedKey)
+    {
+      this->hasCookedFile = ModelCache::writeCookedModel(*this, filepath, cookedKey);
+      this->cookedKey = cookedKey;
+    }
+
+    float loadMilliseconds = std::chrono::duration<float, std::milli>(
+      std::chrono::steady_clock::now() - startTime).count();
+
     eventDispatcher->queueEvent(new GuiEvent(GuiEventType::EndSpinnerEvent, ""));
-    logs->logMessage(LogMessage("Model loaded at path " + filepath));
+    logs->logMessage(LogMessage("Model loaded at path " + filepath + " ("
+                                + std::to_string(this->subMeshes.size()) + " submeshes, "
+                                + std::to_string(loadMilliseconds) + " ms)."));
   }
 
   void 
   Model::unload()
   {
+    for (auto& submesh : this->subMeshes)
+      submesh.freeArena();
+    this->subMeshes.clear();
+    this->storedAnimations.clear();
+    this->storedBones.clear();
+    this->boneMap.clear();
+    this->sceneNodes.clear();
+    this->rootNode = SceneNode();
+
+    this->globalInverseTransform = glm::mat4(1.0f);
+    this->globalTransform = glm::mat4(1.0f);
+    this->minPos = glm::vec3(std::numeric_limits<float>::max());
+    this->maxPos = glm::vec3(std::numeric_limits<float>::min());
+
+    this->isSkinned = false;
+    this->hasCookedFile = false;
+    this->loaded = false;
+  }
 
+  void
+  Model::retainMeshData()
+  {
+    this->meshDataRetains++;
+    for (auto& submesh : this->subMeshes)
+      submesh.reloadData();
   }
 
-  // Recursively process all the nodes in the mesh.
   void
-  Model::processNode(aiNode* node, const aiScene* scene, const std::string &directory, 
+  Model::releaseMeshData()
+  {
+    assert(("Mesh data released more times than it was retained.", this->meshDataRetains > 0));
+
+    if (this->meshDataRetains > 0)
+      this->meshDataRetains--;
+    if (!this->canReleaseMeshData())
+      return;
+
+    uint64_t freedBytes = 0;
+    for (auto& submesh : this->subMeshes)
+    {
+      if (submesh.hasVAO())
+        freedBytes += submesh.releaseData();
+    }
+
+    if (freedBytes > 0)
+    {
+      Logger::getInstance()->logMessage(LogMessage("Released "
+        + std::to_string(freedBytes / 1024) + " KB of mesh data for the model at path "
+        + this->filepath + "."));
+    }
+  }
+
+  // Set SR_KEEP_MESH_DATA to keep every mesh resident, for debugging.
+  bool
+  Model::canReleaseMeshData()
+  {
+    static const bool keepMeshData = std::getenv("SR_KEEP_MESH_DATA") != nullptr;
+    return this->hasCookedFile && this->meshDataRetains == 0 && !keepMeshData;
+  }
+
+  // Recursively process all the nodes in the mesh, collecting the submeshes
+  // and their transforms in traversal order.
+  void
+  Model::processNode(aiNode* node, const aiScene* scene,
+                     std::vector<std::pair<aiMesh*, glm::mat4>> &outMeshes,
                      const glm::mat4& parentTransform)
   {
     if (this->sceneNodes.find(node->mName.C_Str()) == this->sceneNodes.end())
@@ -110,32 +330,27 @@ namespace Strontium
     auto globalTransform = parentTransform * Utilities::mat4ToGLM(node->mTransformation);
 
     for (uint i = 0; i < node->mNumMeshes; i++)
-    {
-      aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-      this->processMesh(mesh, scene, directory, globalTransform);
-    }
+      outMeshes.emplace_back(scene->mMeshes[node->mMeshes[i]], globalTransform);
 
     for (uint i = 0; i < node->mNumChildren; i++)
-      this->processNode(node->mChildren[i], scene, directory, globalTransform);
+      this->processNode(node->mChildren[i], scene, outMeshes, globalTransform);
   }
 
-  // Process each individual mesh.
+  // Process each individual mesh. Only writes to the output mesh so it's safe
+  // to run on many meshes at once.
   void
-  Model::processMesh(aiMesh* mesh, const aiScene* scene, const std::string &directory, 
-                     const glm::mat4& localTransform)
+  Model::processMesh(aiMesh* mesh, const aiScene* scene, const std::string &directory,
+                     Mesh &outMesh)
   {
-    std::string meshName = std::string(mesh->mName.C_Str());
-    this->subMeshes.emplace_back(meshName, this);
-    auto& meshVertices = this->subMeshes.back().getData();
-    auto& meshIndicies = this->subMeshes.back().getIndices();
-    this->subMeshes.back().getTransform() = localTransform;
+    auto& meshVertices = outMesh.getData();
+    auto& meshIndicies = outMesh.getIndices();
 
-    auto& meshMin = this->subMeshes.back().getMinPos();
-    auto& meshMax = this->subMeshes.back().getMaxPos();
+    auto& meshMin = outMesh.getMinPos();
+    auto& meshMax = outMesh.getMaxPos();
     meshMin = glm::vec3(std::numeric_limits<float>::max());
     meshMax = glm::vec3(std::numeric_limits<float>::min());
 
-    auto& materialInfo = this->subMeshes.back().getMaterialInfo();
+    auto& materialInfo = outMesh.getMaterialInfo();
 
     // Get the positions.
     if (mesh->HasPositions())
@@ -161,8 +376,6 @@ namespace Strontium
       // Nothing that can be done for this mesh as it has no data.
       return;
     }
-    this->minPos = glm::min(this->minPos, meshMin);
-    this->maxPos = glm::max(this->maxPos, meshMax);
 
     if (mesh->HasNormals())
     {
@@ -301,39 +514,47 @@ namespace Strontium
       }
     }
 
-    // Load in vertex bones.
-    // Vertex 0 has weights of 0 on specific hardware??
-    if (mesh->HasBones())
+    outMesh.setLoaded(true);
+  }
+
+  // Register the bones of a mesh with the model, in order, and fetch the model
+  // bone index for each of them.
+  void
+  Model::processBones(aiMesh* mesh, std::vector<uint> &outBoneIndices)
+  {
+    std::string meshName = std::string(mesh->mName.C_Str());
+
+    outBoneIndices.resize(mesh->mNumBones);
+    for (unsigned int i = 0; i < mesh->mNumBones; i++)
     {
-      this->isSkinned = true;
+      std::string boneName = mesh->mBones[i]->mName.C_Str();
+      glm::mat4 offsetMatrix = Utilities::mat4ToGLM(mesh->mBones[i]->mOffsetMatrix);
 
-      for (unsigned int i = 0; i < mesh->mNumBones; i++)
+      if (this->boneMap.find(boneName) == this->boneMap.end())
       {
-        std::string boneName = mesh->mBones[i]->mName.C_Str();
-        glm::mat4 offsetMatrix = Utilities::mat4ToGLM(mesh->mBones[i]->mOffsetMatrix);
-
-        unsigned int boneIndex;
-        if (this->boneMap.find(boneName) == this->boneMap.end())
-        {
-          this->storedBones.emplace_back(boneName, meshName, offsetMatrix);
-          this->boneMap[boneName] = this->storedBones.size() - 1;
-          boneIndex = this->storedBones.size() - 1;
-        }
-        else
-        {
-          boneIndex = this->boneMap.at(boneName);
-        }
-
-        for (unsigned int j = 0; j < mesh->mBones[i]->mNumWeights; j++)
-        {
-          unsigned int vertexIndex = mesh->mBones[i]->mWeights[j].mVertexId;
-          float weight = mesh->mBones[i]->mWeights[j].mWeight;
-          this->addBoneData(boneIndex, weight, meshVertices[vertexIndex]);
-        }
+        this->storedBones.emplace_back(boneName, meshName, offsetMatrix);
+        this->boneMap[boneName] = this->storedBones.size() - 1;
       }
+
+      outBoneIndices[i] = this->boneMap.at(boneName);
     }
+  }
 
-    this->subMeshes.back().setLoaded(true);
+  // Load in vertex bones.
+  // Vertex 0 has weights of 0 on specific hardware??
+  void
+  Model::loadBoneWeights(aiMesh* mesh, const std::vector<uint> &boneIndices, Mesh &outMesh)
+  {
+    auto& meshVertices = outMesh.getData();
+    for (unsigned int i = 0; i < mesh->mNumBones; i++)
+    {
+      for (unsigned int j = 0; j < mesh->mBones[i]->mNumWeights; j++)
+      {
+        unsigned int vertexIndex = mesh->mBones[i]->mWeights[j].mVertexId;
+        float weight = mesh->mBones[i]->mWeights[j].mWeight;
+        this->addBoneData(boneIndices[i], weight, meshVertices[vertexIndex]);
+      }
+    }
   }
 
   void
@@ -341,7 +562,7 @@ namespace Strontium
   {
     for (unsigned int i = 0; i < MAX_BONES_PER_VERTEX; i++)
     {
-      if (toMod.boneIDs[i] < 0 || toMod.boneWeights[i] == 0.0f)
+      if (toMod.boneWeights[i] == 0.0f)
       {
         toMod.boneWeights[i] = boneWeight;
         toMod.boneIDs[i] = boneIndex;
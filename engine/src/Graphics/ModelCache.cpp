@@ -0,0 +1,565 @@
+#include "Graphics/ModelCache.h"
+
+// Project includes.
+#include "Core/Logs.h"
+#include "Graphics/Model.h"
+#include "Utils/MappedFile.h"
+
+// STL includes.
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+#include <type_traits>
+
+namespace Strontium
+{
+  namespace ModelCache
+  {
+    // "SRCM" when read back on a little-endian machine.
+    constexpr uint32_t cookedModelMagic = 0x4D435253;
+    constexpr std::size_t cookedArrayAlignment = 16;
+
+    struct CookedModelHeader
+    {
+      uint32_t magic;
+      uint32_t version;
+      uint64_t sourceKey;
+      uint64_t fileSize;
+      uint32_t vertexSize;
+      uint32_t numSubmeshes;
+      uint32_t numBones;
+      uint32_t numSceneNodes;
+      uint32_t numAnimations;
+      uint32_t padding;
+    };
+
+    // FNV-1a, 64 bit.
+    static uint64_t
+    hashBytes(const uint8_t* data, std::size_t size, uint64_t hash = 14695981039346656037ull)
+    {
+      for (std::size_t i = 0; i < size; i++)
+      {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+      }
+
+      return hash;
+    }
+
+    //--------------------------------------------------------------------------
+    // Writing.
+    //--------------------------------------------------------------------------
+    class CookedWriter
+    {
+    public:
+      CookedWriter(std::ofstream &stream)
+        : stream(stream)
+        , offset(0)
+      { }
+
+      template <typename T>
+      void write(const T &value)
+      {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be cooked.");
+        this->writeBytes(&value, sizeof(T));
+      }
+
+      void writeString(const std::string &str)
+      {
+        this->write(static_cast<uint32_t>(str.size()));
+        this->writeBytes(str.data(), str.size());
+      }
+
+      // Arrays are aligned so they can be copied out of the mapping in one go.
+      template <typename T>
+      void writeArray(const std::vector<T> &array)
+      {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be cooked.");
+        this->write(static_cast<uint64_t>(array.size()));
+        this->align(cookedArrayAlignment);
+        this->writeBytes(array.data(), array.size() * sizeof(T));
+      }
+
+      template <typename T>
+      void writeKeys(const std::vector<std::pair<float, T>> &keys)
+      {
+        this->write(static_cast<uint64_t>(keys.size()));
+        for (auto& [time, value] : keys)
+        {
+          this->write(time);
+          this->write(value);
+        }
+      }
+
+      void writeSceneNode(const SceneNode &node)
+      {
+        this->writeString(node.name);
+        this->write(node.localTransform);
+        this->write(static_cast<uint32_t>(node.childNames.size()));
+        for (auto& childName : node.childNames)
+          this->writeString(childName);
+      }
+
+      void align(std::size_t alignment)
+      {
+        static const char zeros[cookedArrayAlignment] = { };
+        std::size_t padding = (alignment - this->offset % alignment) % alignment;
+        this->writeBytes(zeros, padding);
+      }
+
+      uint64_t getOffset() const { return this->offset; }
+    private:
+      void writeBytes(const void* data, std::size_t size)
+      {
+        if (size == 0)
+          return;
+
+        this->stream.write(static_cast<const char*>(data), size);
+        this->offset += size;
+      }
+
+      std::ofstream &stream;
+      uint64_t offset;
+    };
+
+    //--------------------------------------------------------------------------
+    // Reading. Every read is bounds checked, a damaged file sets the failed
+    // flag instead of reading past the end of the mapping.
+    //--------------------------------------------------------------------------
+    class CookedReader
+    {
+    public:
+      CookedReader(const uint8_t* data, std::size_t size)
+        : begin(data)
+        , cursor(data)
+        , end(data + size)
+        , failed(false)
+      { }
+
+      template <typename T>
+      bool read(T &outValue)
+      {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be cooked.");
+        return this->readBytes(&outValue, sizeof(T));
+      }
+
+      bool readString(std::string &outString)
+      {
+        uint32_t size = 0;
+        if (!this->read(size) || !this->canRead(size))
+          return this->fail();
+
+        outString.assign(reinterpret_cast<const char*>(this->cursor), size);
+        this->cursor += size;
+        return true;
+      }
+
+      template <typename T>
+      bool readArray(std::vector<T> &outArray)
+      {
+        uint64_t count = 0;
+        if (!this->read(count) || !this->align(cookedArrayAlignment)
+            || count > this->remaining() / sizeof(T))
+          return this->fail();
+
+        outArray.resize(count);
+        return this->readBytes(outArray.data(), count * sizeof(T));
+      }
+
+      template <typename T>
+      bool readKeys(std::vector<std::pair<float, T>> &outKeys)
+      {
+        uint64_t count = 0;
+        if (!this->read(count) || count > this->remaining() / (sizeof(float) + sizeof(T)))
+          return this->fail();
+
+        outKeys.resize(count);
+        for (auto& [time, value] : outKeys)
+        {
+          if (!this->read(time) || !this->read(value))
+            return false;
+        }
+
+        return true;
+      }
+
+      bool readSceneNode(SceneNode &outNode)
+      {
+        uint32_t numChildren = 0;
+        if (!this->readString(outNode.name) || !this->read(outNode.localTransform)
+            || !this->read(numChildren) || numChildren > this->remaining() / sizeof(uint32_t))
+          return this->fail();
+
+        outNode.childNames.resize(numChildren);
+        for (auto& childName : outNode.childNames)
+          this->readString(childName);
+
+        return !this->failed;
+      }
+
+      bool align(std::size_t alignment)
+      {
+        std::size_t offset = static_cast<std::size_t>(this->cursor - this->begin);
+        std::size_t padding = (alignment - offset % alignment) % alignment;
+        if (!this->canRead(padding))
+          return this->fail();
+
+        this->cursor += padding;
+        return true;
+      }
+
+      bool seek(uint64_t offset)
+      {
+        if (this->failed || offset > static_cast<uint64_t>(this->end - this->begin))
+          return this->fail();
+
+        this->cursor = this->begin + offset;
+        return true;
+      }
+
+      uint64_t getOffset() const { return static_cast<uint64_t>(this->cursor - this->begin); }
+      bool hasFailed() const { return this->failed; }
+    private:
+      bool readBytes(void* outData, std::size_t size)
+      {
+        if (!this->canRead(size))
+          return this->fail();
+
+        if (size > 0)
+          std::memcpy(outData, this->cursor, size);
+        this->cursor += size;
+        return true;
+      }
+
+      bool canRead(std::size_t size) const { return !this->failed && size <= this->remaining(); }
+      std::size_t remaining() const { return static_cast<std::size_t>(this->end - this->cursor); }
+      bool fail() { this->failed = true; return false; }
+
+      const uint8_t* begin;
+      const uint8_t* cursor;
+      const uint8_t* end;
+      bool failed;
+    };
+
+    //--------------------------------------------------------------------------
+    // Mesh geometry, the part of a cooked model which can be released once it's
+    // on the GPU and read back on its own later.
+    //--------------------------------------------------------------------------
+    static void
+    writeMeshGeometry(CookedWriter &writer, Mesh &mesh)
+    {
+      writer.writeArray(mesh.getData());
+      writer.writeArray(mesh.getIndices());
+
+      writer.write(static_cast<uint32_t>(mesh.getLODs().size()));
+      for (auto& lod : mesh.getLODs())
+      {
+        writer.write(lod.error);
+        writer.writeArray(lod.indices);
+      }
+    }
+
+    static bool
+    readMeshGeometry(CookedReader &reader, Mesh &mesh)
+    {
+      reader.readArray(mesh.getData());
+      reader.readArray(mesh.getIndices());
+
+      uint32_t numLODs = 0;
+      reader.read(numLODs);
+      if (numLODs >= MAX_MESH_LODS)
+        return false;
+
+      auto& lods = mesh.getLODs();
+      lods.resize(numLODs);
+      for (auto& lod : lods)
+      {
+        reader.read(lod.error);
+        reader.readArray(lod.indices);
+        lod.numIndices = static_cast<uint>(lod.indices.size());
+      }
+
+      return !reader.hasFailed();
+    }
+
+    // Map a cooked file and check it belongs to the source key.
+    static bool
+    openCookedFile(MappedFile &cookedFile, const std::string &filepath, uint64_t sourceKey,
+                   CookedModelHeader &outHeader)
+    {
+      if (!cookedFile.open(getCookedPath(filepath, sourceKey)))
+        return false;
+
+      CookedReader reader(cookedFile.data(), cookedFile.size());
+      return reader.read(outHeader) && outHeader.magic == cookedModelMagic
+             && outHeader.version == cookedModelVersion && outHeader.sourceKey == sourceKey
+             && outHeader.fileSize == cookedFile.size() && outHeader.vertexSize == sizeof(Vertex);
+    }
+
+    //--------------------------------------------------------------------------
+    // Model cache.
+    //--------------------------------------------------------------------------
+    bool
+    computeSourceKey(const std::string &filepath, uint importFlags, uint64_t &outKey)
+    {
+      MappedFile source;
+      if (!source.open(filepath))
+        return false;
+
+      uint64_t key = hashBytes(source.data(), source.size());
+
+      // Anything which changes what the importer produces goes into the key.
+      uint32_t settings[3] = { importFlags, cookedModelVersion,
+                               static_cast<uint32_t>(sizeof(Vertex)) };
+      outKey = hashBytes(reinterpret_cast<const uint8_t*>(settings), sizeof(settings), key);
+      return true;
+    }
+
+    std::string
+    getCookedPath(const std::string &filepath, uint64_t sourceKey)
+    {
+      char keyString[17];
+      std::snprintf(keyString, sizeof(keyString), "%016llx",
+                    static_cast<unsigned long long>(sourceKey));
+
+      std::filesystem::path sourcePath(filepath);
+      return "./assets/.cache/models/" + sourcePath.stem().string() + "_" + keyString + ".srcooked";
+    }
+
+    bool
+    readCookedModel(Model &model, const std::string &filepath, uint64_t sourceKey)
+    {
+      MappedFile cookedFile;
+      CookedModelHeader header;
+      if (!openCookedFile(cookedFile, filepath, sourceKey, header))
+        return false;
+
+      CookedReader reader(cookedFile.data(), cookedFile.size());
+      reader.seek(sizeof(CookedModelHeader));
+
+      // Scene information.
+      reader.read(model.getGlobalInverseTransform());
+      reader.read(model.getGlobalTransform());
+      reader.read(model.getMinPos());
+      reader.read(model.getMaxPos());
+      reader.readSceneNode(model.getRootNode());
+
+      auto& sceneNodes = model.getSceneNodes();
+      sceneNodes.reserve(header.numSceneNodes);
+      for (uint32_t i = 0; i < header.numSceneNodes && !reader.hasFailed(); i++)
+      {
+        SceneNode node;
+        if (reader.readSceneNode(node))
+          sceneNodes.emplace(node.name, std::move(node));
+      }
+
+      // Bones, in model bone index order.
+      auto& bones = model.getBones();
+      auto& boneMap = model.getBoneMap();
+      bones.reserve(header.numBones);
+      for (uint32_t i = 0; i < header.numBones && !reader.hasFailed(); i++)
+      {
+        std::string boneName, parentMesh;
+        glm::mat4 offsetMatrix;
+        reader.readString(boneName);
+        reader.readString(parentMesh);
+        reader.read(offsetMatrix);
+
+        bones.emplace_back(boneName, parentMesh, offsetMatrix);
+        boneMap[boneName] = i;
+      }
+
+      // Submeshes.
+      auto& subMeshes = model.getSubmeshes();
+      subMeshes.reserve(header.numSubmeshes);
+      for (uint32_t i = 0; i < header.numSubmeshes && !reader.hasFailed(); i++)
+      {
+        std::string meshName;
+        reader.readString(meshName);
+
+        Mesh& mesh = subMeshes.emplace_back(meshName, &model);
+        reader.read(mesh.getTransform());
+        reader.read(mesh.getMinPos());
+        reader.read(mesh.getMaxPos());
+
+        auto& materialInfo = mesh.getMaterialInfo();
+        reader.readString(materialInfo.albedoTexturePath);
+        reader.readString(materialInfo.roughnessTexturePath);
+        reader.readString(materialInfo.metallicTexturePath);
+        reader.readString(materialInfo.aoTexturePath);
+        reader.readString(materialInfo.specularTexturePath);
+        reader.readString(materialInfo.normalTexturePath);
+
+        uint32_t meshLoaded = 0;
+        reader.read(meshLoaded);
+        mesh.setCookedOffset(reader.getOffset());
+        if (!readMeshGeometry(reader, mesh))
+          return false;
+        reader.readArray(mesh.getMeshlets());
+
+        mesh.setLoaded(meshLoaded != 0);
+      }
+
+      // Animations.
+      auto& animations = model.getAnimations();
+      animations.reserve(header.numAnimations);
+      for (uint32_t i = 0; i < header.numAnimations && !reader.hasFailed(); i++)
+      {
+        std::string animationName;
+        float duration = 0.0f, ticksPerSecond = 0.0f;
+        uint32_t numNodes = 0;
+        reader.readString(animationName);
+        reader.read(duration);
+        reader.read(ticksPerSecond);
+        reader.read(numNodes);
+
+        Animation& animation = animations.emplace_back(animationName, duration,
+                                                       ticksPerSecond, &model);
+        auto& animationNodes = animation.getAniNodes();
+        for (uint32_t j = 0; j < numNodes && !reader.hasFailed(); j++)
+        {
+          AnimationNode node;
+          reader.readString(node.name);
+          reader.readKeys(node.keyTranslations);
+          reader.readKeys(node.keyRotations);
+          reader.readKeys(node.keyScales);
+          animationNodes.emplace(node.name, std::move(node));
+        }
+      }
+
+      return !reader.hasFailed();
+    }
+
+    bool
+    writeCookedModel(Model &model, const std::string &filepath, uint64_t sourceKey)
+    {
+      std::string cookedPath = getCookedPath(filepath, sourceKey);
+      std::string tempPath = cookedPath + "."
+                           + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()))
+                           + ".tmp";
+
+      std::error_code error;
+      std::filesystem::create_directories(std::filesystem::path(cookedPath).parent_path(), error);
+
+      std::ofstream output(tempPath, std::ios::binary | std::ios::trunc | std::ios::out);
+      if (!output.is_open())
+      {
+        Logger::getInstance()->logMessage(LogMessage("Failed to write the cooked model at the path "
+                                                     + cookedPath + ".", true, true));
+        return false;
+      }
+
+      auto& subMeshes = model.getSubmeshes();
+      auto& sceneNodes = model.getSceneNodes();
+      auto& bones = model.getBones();
+      auto& animations = model.getAnimations();
+
+      CookedModelHeader header;
+      header.magic = cookedModelMagic;
+      header.version = cookedModelVersion;
+      header.sourceKey = sourceKey;
+      header.fileSize = 0;
+      header.vertexSize = static_cast<uint32_t>(sizeof(Vertex));
+      header.numSubmeshes = static_cast<uint32_t>(subMeshes.size());
+      header.numBones = static_cast<uint32_t>(bones.size());
+      header.numSceneNodes = static_cast<uint32_t>(sceneNodes.size());
+      header.numAnimations = static_cast<uint32_t>(animations.size());
+      header.padding = 0;
+
+      CookedWriter writer(output);
+      writer.write(header);
+
+      // Scene information.
+      writer.write(model.getGlobalInverseTransform());
+      writer.write(model.getGlobalTransform());
+      writer.write(model.getMinPos());
+      writer.write(model.getMaxPos());
+      writer.writeSceneNode(model.getRootNode());
+      for (auto& [nodeName, node] : sceneNodes)
+        writer.writeSceneNode(node);
+
+      // Bones.
+      for (auto& bone : bones)
+      {
+        writer.writeString(bone.name);
+        writer.writeString(bone.parentMesh);
+        writer.write(bone.offsetMatrix);
+      }
+
+      // Submeshes.
+      for (auto& mesh : subMeshes)
+      {
+        writer.writeString(mesh.getName());
+        writer.write(mesh.getTransform());
+        writer.write(mesh.getMinPos());
+        writer.write(mesh.getMaxPos());
+
+        auto& materialInfo = mesh.getMaterialInfo();
+        writer.writeString(materialInfo.albedoTexturePath);
+        writer.writeString(materialInfo.roughnessTexturePath);
+        writer.writeString(materialInfo.metallicTexturePath);
+        writer.writeString(materialInfo.aoTexturePath);
+        writer.writeString(materialInfo.specularTexturePath);
+        writer.writeString(materialInfo.normalTexturePath);
+
+        writer.write(static_cast<uint32_t>(mesh.isLoaded()));
+        mesh.setCookedOffset(writer.getOffset());
+        writeMeshGeometry(writer, mesh);
+        writer.writeArray(mesh.getMeshlets());
+      }
+
+      // Animations.
+      for (auto& animation : animations)
+      {
+        auto& animationNodes = animation.getAniNodes();
+        writer.writeString(animation.getName());
+        writer.write(animation.getDuration());
+        writer.write(animation.getTPS());
+        writer.write(static_cast<uint32_t>(animationNodes.size()));
+
+        for (auto& [nodeName, node] : animationNodes)
+        {
+          writer.writeString(node.name);
+          writer.writeKeys(node.keyTranslations);
+          writer.writeKeys(node.keyRotations);
+          writer.writeKeys(node.keyScales);
+        }
+      }
+
+      // Patch in the final size so truncated files are caught on load.
+      header.fileSize = writer.getOffset();
+      output.seekp(0);
+      output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      output.close();
+
+      if (output.fail())
+      {
+        std::filesystem::remove(tempPath, error);
+        Logger::getInstance()->logMessage(LogMessage("Failed to write the cooked model at the path "
+                                                     + cookedPath + ".", true, true));
+        return false;
+      }
+
+      std::filesystem::rename(tempPath, cookedPath, error);
+      if (error)
+      {
+        std::filesystem::remove(tempPath, error);
+        return false;
+      }
+
+      return true;
+    }
+
+    bool
+    readCookedMesh(Mesh &mesh, const std::string &filepath, uint64_t sourceKey)
+    {
+      MappedFile cookedFile;
+      CookedModelHeader header;
+      if (mesh.getCookedOffset() == 0 || !openCookedFile(cookedFile, filepath, sourceKey, header))
+        return false;
+
+      CookedReader reader(cookedFile.data(), cookedFile.size());
+      return reader.seek(mesh.getCookedOffset()) && readMeshGeometry(reader, mesh);
+    }
+  }
+}
@@ -0,0 +1,73 @@
+#include "Graphics/RenderQueue.h"
+
+namespace Strontium
+{
+  namespace RenderQueue
+  {
+    uint64_t
+    makeKey(uint shader, uint textureSet, uint material, uint mesh,
+            uint lod, float depth)
+    {
+      auto field = [](uint value, uint bits)
+      {
+        return static_cast<uint64_t>(value) & ((1ull << bits) - 1ull);
+      };
+
+      float clampedDepth = std::min(std::max(depth, 0.0f), 1.0f);
+      uint quantizedDepth = static_cast<uint>(clampedDepth * static_cast<float>((1u << depthBits) - 1u));
+
+      uint64_t key = field(shader, shaderBits);
+      key = (key << textureSetBits) | field(textureSet, textureSetBits);
+      key = (key << materialBits) | field(material, materialBits);
+      key = (key << meshBits) | field(mesh, meshBits);
+      key = (key << lodBits) | field(lod, lodBits);
+      key = (key << depthBits) | field(quantizedDepth, depthBits);
+
+      return key;
+    }
+
+    void
+    radixSort(std::vector<SortEntry> &entries, std::vector<SortEntry> &scratch)
+    {
+      if (entries.size() < 2)
+        return;
+
+      scratch.resize(entries.size());
+
+      // Bits which differ between any two keys. Bytes without any are
+      // already sorted.
+      uint64_t firstKey = entries[0].key;
+      uint64_t differingBits = 0;
+      for (auto& entry : entries)
+        differingBits |= entry.key ^ firstKey;
+
+      std::vector<SortEntry>* source = &entries;
+      std::vector<SortEntry>* destination = &scratch;
+      for (uint shift = 0; shift < 64; shift += 8)
+      {
+        if (((differingBits >> shift) & 0xFF) == 0)
+          continue;
+
+        uint offsets[256] = { 0 };
+        for (auto& entry : *source)
+          offsets[(entry.key >> shift) & 0xFF]++;
+
+        uint total = 0;
+        for (uint i = 0; i < 256; i++)
+        {
+          uint count = offsets[i];
+          offsets[i] = total;
+          total += count;
+        }
+
+        for (auto& entry : *source)
+          (*destination)[offsets[(entry.key >> shift) & 0xFF]++] = entry;
+
+        std::swap(source, destination);
+      }
+
+      if (source != &entries)
+        entries.swap(scratch);
+    }
+  }
+}
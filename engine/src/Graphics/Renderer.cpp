@@ -8,6 +8,7 @@ namespace Strontium
   namespace Renderer3D
   {
     // Forward declaration for passes.
+    void cullingPass();
     void geometryPass();
     void shadowPass();
     void lightingPass();
@@ -102,6 +103,7 @@ namespace Strontium
       storage->shadowEffectsBuffer.attach(dSpec, depthAttachment);
       storage->shadowEffectsBuffer.setClearColour(glm::vec4(1.0f));
       storage->hasCascades = false;
+      storage->hasCasterBounds = false;
 
       // Resize the GBuffer.
       storage->gBuffer.resize(width, height);
@@ -145,10 +147,14 @@ namespace Strontium
     {
       storage->sceneCam = sceneCamera;
       storage->camFrustum = buildCameraFrustum(sceneCamera);
+      storage->hasCasterBounds = false;
 
       // Resize the framebuffer at the start of a frame, if required.
       storage->drawEdge = false;
 
+      // Per-draw data goes to the next region of the ring buffer.
+      storage->drawDataBuffer.beginFrame();
+
       // Update the frame.
       state->currentFrame++;
       if (state->currentFrame == 6)
@@ -201,14 +207,25 @@ namespace Strontium
       // Clear the lighting pass FBO.
       storage->lightingPass.clear();
 
+      // ImGui draws with the raw API between frames, so don't trust the
+      // cached state.
+      StateCache::invalidate();
+      StateCache::resetStats();
+
       // Reset the stats each frame.
       stats->drawCalls = 0;
+      stats->drawCallsSaved = 0;
+      stats->materialBindsSkipped = 0;
       stats->numVertices = 0;
       stats->numTriangles = 0;
+      stats->trianglesSaved = 0;
+      stats->meshletsCulled = 0;
+      stats->vertexBytes = 0;
       stats->numDirLights = 0;
       stats->numPointLights = 0;
       stats->numSpotLights = 0;
 
+      stats->cullFrametime = 0.0f;
       stats->geoFrametime = 0.0f;
       stats->shadowFrametime = 0.0f;
       stats->lightFrametime = 0.0f;
@@ -222,6 +239,8 @@ namespace Strontium
     void
     end(Shared<FrameBuffer> frontBuffer)
     {
+      cullingPass();
+
       geometryPass();
 
       shadowPass();
@@ -229,9 +248,15 @@ namespace Strontium
       lightingPass();
 
       postProcessPass(frontBuffer);
+
+      stats->drawDataBytes = storage->drawDataBuffer.getFrameUsage();
+      stats->drawDataFrameBytes = storage->drawDataBuffer.getFrameSize();
+      storage->drawDataBuffer.endFrame();
     }
 
-    // Draw the data to the screen.
+    // Draw the data to the screen. The vertex array and program are left
+    // bound, so the state cache can skip binding them again for the next
+    // draw.
     void
     draw(VertexArray* data, Shader* program)
     {
@@ -239,9 +264,28 @@ namespace Strontium
       program->bind();
 
       RendererCommands::drawElements(PrimativeType::Triangle, data->numToRender());
+    }
 
-      data->unbind();
-      program->unbind();
+    // Draw several ranges of the data's indices in one call.
+    void
+    drawRanges(VertexArray* data, Shader* program, const int* counts,
+               const void* const* offsets, uint numRanges)
+    {
+      data->bind();
+      program->bind();
+
+      RendererCommands::multiDrawElements(PrimativeType::Triangle, counts, offsets, numRanges);
+    }
+
+    // Draw several instances of the data.
+    void
+    drawInstanced(VertexArray* data, Shader* program, uint numInstances)
+    {
+      data->bind();
+      program->bind();
+
+      RendererCommands::drawElementsInstanced(PrimativeType::Triangle, data->numToRender(),
+                                              numInstances);
     }
 
     // Draw an environment map to the screen. Draws all the submeshes associated
@@ -312,184 +356,561 @@ namespace Strontium
       stats->numSpotLights++;
     }
 
+    void
+    submitSceneBounds(const glm::vec3 &min, const glm::vec3 &max)
+    {
+      storage->hasCasterBounds = true;
+      storage->casterMin = min;
+      storage->casterMax = max;
+    }
+
+    // Write the model block (ModelBlock, binding 2) of the next draw to the
+    // ring buffer. Shaders without the vertex format just ignore it.
+    void
+    bindModelBlock(const glm::mat4 &model, const glm::vec4 &vertexFormat)
+    {
+      ModelBlockData block = { model, vertexFormat };
+      storage->drawDataBuffer.bindData(2, &block, sizeof(ModelBlockData));
+    }
+
     //--------------------------------------------------------------------------
-    // Deferred geometry pass.
+    // Level of detail selection.
     //--------------------------------------------------------------------------
-    void geometryPass()
+    // Pick the coarsest level of detail of a submesh whose simplification
+    // error projects to less than the threshold in pixels on screen.
+    uint
+    computeLOD(Mesh &submesh, const glm::mat4 &transform)
     {
-      auto start = std::chrono::steady_clock::now();
+      uint lod = 0;
+      if (submesh.getNumLODs() > 1 && state->lodErrorThreshold > 0.0f)
+      {
+        glm::vec3 min = submesh.getMinPos();
+        glm::vec3 max = submesh.getMaxPos();
+        glm::vec3 extents = max - min;
+        float extent = glm::max(extents.x, glm::max(extents.y, extents.z));
+        float maxScale = glm::max(glm::length(glm::vec3(transform[0])),
+                                  glm::max(glm::length(glm::vec3(transform[1])),
+                                           glm::length(glm::vec3(transform[2]))));
+
+        // Distance to the bounding sphere, clamped so the camera being inside
+        // the sphere always picks the full mesh.
+        glm::vec3 center = glm::vec3(transform * glm::vec4(0.5f * (min + max), 1.0f));
+        float radius = 0.5f * glm::length(extents) * maxScale;
+        float distance = glm::length(center - storage->sceneCam.position) - radius;
+        distance = glm::max(distance, storage->sceneCam.near);
+
+        // World space error to pixels, at the given distance.
+        float pixelsPerUnit = storage->sceneCam.projection[1][1] * 0.5f
+                            * static_cast<float>(storage->height) / distance;
+        for (uint i = submesh.getNumLODs() - 1; i > 0; i--)
+        {
+          float pixelError = submesh.getLODError(i) * extent * maxScale * pixelsPerUnit;
+          if (pixelError <= state->lodErrorThreshold)
+          {
+            lod = i;
+            break;
+          }
+        }
+      }
 
-      // Upload camera uniforms to the camera uniform buffer.
-      storage->camBuffer.bindToPoint(0);
-      storage->camBuffer.setData(0, sizeof(glm::mat4), glm::value_ptr(storage->sceneCam.view));
-      storage->camBuffer.setData(sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(storage->sceneCam.projection));
-      storage->camBuffer.setData(2 * sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(storage->sceneCam.invViewProj));
-      storage->camBuffer.setData(3 * sizeof(glm::mat4), sizeof(glm::vec3), &(storage->sceneCam.position.x));
-      auto nearFar = glm::vec2(storage->sceneCam.near, storage->sceneCam.far);
-      storage->camBuffer.setData(3 * sizeof(glm::mat4) + sizeof(glm::vec4), sizeof(glm::vec2), &(nearFar.x));
+      return lod;
+    }
 
-      // Start the geometry pass.
-      storage->gBuffer.beginGeoPass();
+    // Pick the level of detail of a submesh and select its index buffer.
+    uint
+    selectLOD(Mesh &submesh, const glm::mat4 &transform)
+    {
+      uint lod = computeLOD(submesh, transform);
+      submesh.getVAO()->setIndices(lod);
+      return lod;
+    }
 
-      storage->transformBuffer.bindToPoint(2);
-      storage->editorBuffer.bindToPoint(3);
+    // Cull the meshlets of a submesh against the camera frustum, and their
+    // normal cones against the camera position if enabled. The visible
+    // meshlets are merged into as few index ranges as possible. Returns the
+    // number of indices left to draw.
+    uint
+    cullMeshlets(Mesh &submesh, const glm::mat4 &transform)
+    {
+      storage->meshletCounts.clear();
+      storage->meshletOffsets.clear();
+
+      glm::vec3 scales = glm::vec3(glm::length(glm::vec3(transform[0])),
+                                   glm::length(glm::vec3(transform[1])),
+                                   glm::length(glm::vec3(transform[2])));
+      float maxScale = glm::max(scales.x, glm::max(scales.y, scales.z));
+      float minScale = glm::min(scales.x, glm::min(scales.y, scales.z));
+
+      // Non-uniform scales bend the normal cones, so skip the cone test then.
+      bool coneCull = state->meshletConeCull && minScale > 0.99f * maxScale;
+      glm::mat3 normalMatrix = glm::mat3(transform) / maxScale;
+
+      uint numIndices = 0;
+      uint previousEnd = std::numeric_limits<uint>::max();
+      for (auto& meshlet : submesh.getMeshlets())
+      {
+        glm::vec3 center = glm::vec3(transform * glm::vec4(glm::vec3(meshlet.boundingSphere), 1.0f));
+        float radius = meshlet.boundingSphere.w * maxScale;
 
-      Shader* staticGeometry = ShaderCache::getShader("geometry_pass_shader");
-      Shader* dynamicGeometry = ShaderCache::getShader("dynamic_geometry_pass");
+        bool visible = sphereInFrustum(storage->camFrustum, center, radius);
+        if (visible && coneCull && meshlet.normalCone.w < 1.0f)
+        {
+          glm::vec3 axis = normalMatrix * glm::vec3(meshlet.normalCone);
+          glm::vec3 view = center - storage->sceneCam.position;
+          visible = glm::dot(view, axis) < meshlet.normalCone.w * glm::length(view) + radius;
+        }
+
+        if (!visible)
+        {
+          stats->meshletsCulled++;
+          continue;
+        }
+
+        if (meshlet.indexOffset == previousEnd)
+          storage->meshletCounts.back() += meshlet.indexCount;
+        else
+        {
+          storage->meshletCounts.push_back(meshlet.indexCount);
+          storage->meshletOffsets.push_back(reinterpret_cast<const void*>(
+            static_cast<std::size_t>(meshlet.indexOffset) * sizeof(uint)));
+        }
+
+        previousEnd = meshlet.indexOffset + meshlet.indexCount;
+        numIndices += meshlet.indexCount;
+      }
+
+      return numIndices;
+    }
+
+    // Draw a submesh into the geometry buffer at its level of detail, culling
+    // its meshlets if allowed. Skinned submeshes can't cull meshlets since
+    // the bounds are in the bind pose.
+    void
+    drawSubmesh(Mesh &submesh, const glm::mat4 &transform, Shader* program, bool allowMeshletCull)
+    {
+      uint lod = selectLOD(submesh, transform);
+      glm::vec4 meshFormat(submesh.getVertexFormat() == VertexFormat::Packed ? 1.0f : 0.0f);
+      bindModelBlock(transform, meshFormat);
 
-      // Static geometry pass.
-      for (auto& drawable : storage->staticRenderQueue)
+      uint numIndices = submesh.getNumIndices(lod);
+      if (lod == 0 && allowMeshletCull && state->meshletCull && submesh.getMeshlets().size() > 1)
       {
-        auto& [data, materials, transform, id, drawSelectionMask] = drawable;
-        for (auto& submesh : data->getSubmeshes())
+        numIndices = cullMeshlets(submesh, transform);
+        if (numIndices == 0)
+          return;
+
+        drawRanges(submesh.getVAO(), program, storage->meshletCounts.data(),
+                   storage->meshletOffsets.data(),
+                   static_cast<uint>(storage->meshletCounts.size()));
+      }
+      else
+        Renderer3D::draw(submesh.getVAO(), program);
+
+      stats->drawCalls++;
+      stats->numVertices += submesh.getNumVertices();
+      stats->vertexBytes += submesh.getVertexBytes();
+      stats->numTriangles += numIndices / 3;
+      stats->trianglesSaved += (submesh.getNumIndices(0) - numIndices) / 3;
+    }
+
+    //--------------------------------------------------------------------------
+    // Indirect drawing from the geometry arena.
+    //--------------------------------------------------------------------------
+    // Queue a submesh which lives in the geometry arena for the indirect path,
+    // at its level of detail. Visible meshlet ranges each get their own
+    // command. Returns the number of indices queued.
+    uint
+    queueIndirect(Mesh &submesh, const glm::mat4 &transform, Material* material,
+                  const glm::vec4 &maskColourID, bool allowMeshletCull)
+    {
+      IndirectDraw draw;
+      draw.material = material;
+      draw.command.instanceCount = 1;
+      draw.command.baseVertex = static_cast<int>(submesh.getArenaAllocation().firstVertex);
+      draw.command.baseInstance = 0;
+      draw.instance.modelMatrix = transform;
+      draw.instance.maskColourID = maskColourID;
+
+      uint lod = computeLOD(submesh, transform);
+      uint numIndices = submesh.getNumIndices(lod);
+      if (lod == 0 && allowMeshletCull && state->meshletCull && submesh.getMeshlets().size() > 1)
+      {
+        numIndices = cullMeshlets(submesh, transform);
+        for (uint i = 0; i < storage->meshletCounts.size(); i++)
+        {
+          auto offset = reinterpret_cast<std::size_t>(storage->meshletOffsets[i]);
+          draw.command.count = static_cast<uint>(storage->meshletCounts[i]);
+          draw.command.firstIndex = submesh.getArenaFirstIndex(0)
+                                  + static_cast<uint>(offset / sizeof(uint));
+          storage->indirectDraws.push_back(draw);
+        }
+      }
+      else
+      {
+        draw.command.count = numIndices;
+        draw.command.firstIndex = submesh.getArenaFirstIndex(lod);
+        storage->indirectDraws.push_back(draw);
+      }
+
+      return numIndices;
+    }
+
+    // Upload the per-instance data and bind it for the shaders.
+    void
+    uploadInstances()
+    {
+      uint instanceBytes = static_cast<uint>(storage->instances.size() * sizeof(InstanceData));
+      if (instanceBytes > storage->instanceBuffer->size())
+      {
+        uint newSize = storage->instanceBuffer->size();
+        while (newSize < instanceBytes)
+          newSize *= 2;
+        storage->instanceBuffer = createUnique<ShaderStorageBuffer>(newSize, BufferType::Dynamic);
+      }
+      if (instanceBytes > 0)
+        storage->instanceBuffer->setData(0, instanceBytes, storage->instances.data());
+      storage->instanceBuffer->bindToPoint(5);
+    }
+
+    // Upload the queued indirect draws. Each command's baseInstance is its
+    // first instance in the instance buffer. If the draws are to be batched
+    // by material they're sorted first, so each material is one contiguous
+    // range, and repeats of the same indices are merged into one command
+    // with several instances.
+    void
+    uploadIndirect(bool sortByMaterial)
+    {
+      if (sortByMaterial)
+      {
+        std::stable_sort(storage->indirectDraws.begin(), storage->indirectDraws.end(),
+                         [](const IndirectDraw &a, const IndirectDraw &b)
         {
-          // Cull the submesh if it isn't in the frustum.
-          glm::vec3 min = submesh.getMinPos();
-          glm::vec3 max = submesh.getMaxPos();
+          if (a.material != b.material)
+            return a.material < b.material;
+          if (a.command.firstIndex != b.command.firstIndex)
+            return a.command.firstIndex < b.command.firstIndex;
+          return a.command.count < b.command.count;
+        });
+      }
 
-          auto localTransform = transform * submesh.getTransform();
-          if (!boundingBoxInFrustum(storage->camFrustum, min, max, localTransform) && state->frustumCull)
-            continue;
+      storage->indirectCommands.clear();
+      storage->indirectMaterials.clear();
+      storage->instances.clear();
+      for (auto& draw : storage->indirectDraws)
+      {
+        bool merge = false;
+        if (sortByMaterial && !storage->indirectCommands.empty())
+        {
+          auto& previous = storage->indirectCommands.back();
+          merge = storage->indirectMaterials.back() == draw.material
+                  && previous.firstIndex == draw.command.firstIndex
+                  && previous.count == draw.command.count
+                  && previous.baseVertex == draw.command.baseVertex;
+        }
 
-          Material* material = materials->getMaterial(submesh.getName());
-          if (!material)
-            continue;
+        if (merge)
+          storage->indirectCommands.back().instanceCount++;
+        else
+        {
+          draw.command.instanceCount = 1;
+          draw.command.baseInstance = static_cast<uint>(storage->instances.size());
+          storage->indirectCommands.push_back(draw.command);
+          storage->indirectMaterials.push_back(draw.material);
+        }
 
-          storage->transformBuffer.setData(0, sizeof(glm::mat4), glm::value_ptr(localTransform));
+        storage->instances.push_back(draw.instance);
+      }
 
-          glm::vec4 maskColourID;
-          if (drawSelectionMask)
-          {
-            // Enable edge detection for selected mesh outlines.
-            storage->drawEdge = true;
-            maskColourID = glm::vec4(1.0f);
-          }
-          else
-            maskColourID = glm::vec4(0.0f);
+      uploadInstances();
 
-          maskColourID.w = id + 1.0f;
-          storage->editorBuffer.setData(0, sizeof(glm::vec4), &maskColourID.x);
+      auto arena = GeometryArena::getInstance();
+      arena->setCommands(storage->indirectCommands);
+      stats->arenaUsedBytes = arena->getUsedBytes();
+      stats->arenaCapacityBytes = arena->getCapacityBytes();
+    }
 
-          material->configure();
+    // Draw a range of the uploaded indirect commands, one multi-draw per
+    // material if the materials are to be bound. Returns the number of
+    // multi-draws.
+    uint
+    drawIndirect(Shader* program, uint firstCommand, uint numCommands, bool bindMaterials)
+    {
+      auto arena = GeometryArena::getInstance();
+      arena->bind();
+      program->bind();
 
-          if (submesh.hasVAO())
-            Renderer3D::draw(submesh.getVAO(), staticGeometry);
-          else
-          {
-            submesh.generateVAO();
-            Renderer3D::draw(submesh.getVAO(), staticGeometry);
-          }
+      uint numBatches = 0;
+      uint end = firstCommand + numCommands;
+      uint batchStart = firstCommand;
+      while (batchStart < end)
+      {
+        uint batchEnd = batchStart + 1;
+        if (bindMaterials)
+        {
+          Material* material = storage->indirectMaterials[batchStart];
+          while (batchEnd < end && storage->indirectMaterials[batchEnd] == material)
+            batchEnd++;
 
-          stats->drawCalls++;
-          stats->numVertices += submesh.getData().size();
-          stats->numTriangles += submesh.getIndices().size() / 3;
+          material->configureDynamic(program);
+          program->bind();
         }
+        else
+          batchEnd = end;
+
+        arena->drawCommands(batchStart, batchEnd - batchStart);
+        numBatches++;
+
+        batchStart = batchEnd;
       }
 
-      // Dynamic geometry pass.
-      storage->boneBuffer.bindToPoint(4);
-      for (auto& drawable : storage->dynamicRenderQueue)
+      arena->unbind();
+
+      return numBatches;
+    }
+
+    //--------------------------------------------------------------------------
+    // Sorted draw items and automatic instancing.
+    //--------------------------------------------------------------------------
+    // Per-frame IDs for the sort keys, handed out in the order things are
+    // first seen.
+    uint
+    getSortID(std::unordered_map<const void*, uint> &ids, const void* object)
+    {
+      auto result = ids.emplace(object, static_cast<uint>(ids.size()));
+      return result.first->second;
+    }
+
+    // Materials with the same 2D textures share a texture set ID.
+    uint
+    getTextureSetID(Material* material)
+    {
+      auto loc = storage->materialTextureSets.find(material);
+      if (loc != storage->materialTextureSets.end())
+        return loc->second;
+
+      std::string textures;
+      for (auto& [name, handle] : material->getSampler2Ds())
       {
-        auto& [data, animation, materials, transform, id, drawSelectionMask] = drawable;
+        textures += handle;
+        textures += '\n';
+      }
 
-        if (data->hasSkins())
+      auto result = storage->textureSetIDs.emplace(textures, static_cast<uint>(storage->textureSetIDs.size()));
+      storage->materialTextureSets.emplace(material, result.first->second);
+      return result.first->second;
+    }
+
+    // Queue a submesh draw with its sort key. Skinned items key on their
+    // animator instead of the submesh, so the bones are only uploaded again
+    // when the animator changes.
+    void
+    queueDrawItem(Mesh &submesh, Material* material, Animator* animation, Shader* program,
+                  const glm::mat4 &transform, const glm::vec4 &maskColourID)
+    {
+      DrawItem item;
+      item.submesh = &submesh;
+      item.material = material;
+      item.animation = animation;
+      item.lod = animation ? 0 : computeLOD(submesh, transform);
+      item.instance.modelMatrix = transform;
+      item.instance.maskColourID = maskColourID;
+
+      glm::vec3 center = glm::vec3(transform * glm::vec4(0.5f * (submesh.getMinPos() + submesh.getMaxPos()), 1.0f));
+      float depth = glm::length(center - storage->sceneCam.position) / storage->sceneCam.far;
+
+      const void* meshObject = animation ? static_cast<const void*>(animation)
+                                         : static_cast<const void*>(&submesh);
+      item.key = RenderQueue::makeKey(getSortID(storage->shaderSortIDs, program),
+                                      getTextureSetID(material),
+                                      getSortID(storage->materialSortIDs, material),
+                                      getSortID(storage->meshSortIDs, meshObject),
+                                      item.lod, depth);
+
+      storage->drawItems.push_back(item);
+    }
+
+    // Sort the queued draw items and draw them. Runs of the same static
+    // submesh, material and level of detail are drawn as a single instanced
+    // draw if instancing is on, and runs of the same material skip binding
+    // it again. Instanced groups of one take the regular path so they can
+    // still cull meshlets.
+    void
+    drawSortedItems(Shader* staticProgram, Shader* instancedProgram, Shader* skinnedProgram,
+                    VertexFormat vertexFormat)
+    {
+      auto& items = storage->drawItems;
+      auto& entries = storage->sortEntries;
+
+      entries.clear();
+      for (uint i = 0; i < items.size(); i++)
+        entries.push_back({ items[i].key, i });
+      if (state->sortRenderQueue)
+        RenderQueue::radixSort(entries, storage->sortScratch);
+
+      // The instances go into the buffer in draw order, so each group is a
+      // contiguous range.
+      if (state->instancing)
+      {
+        storage->instances.clear();
+        for (auto& entry : entries)
+          storage->instances.push_back(items[entry.index].instance);
+        uploadInstances();
+      }
+
+      Material* boundMaterial = nullptr;
+      Shader* boundProgram = nullptr;
+      Animator* boundAnimation = nullptr;
+
+      uint groupStart = 0;
+      while (groupStart < entries.size())
+      {
+        auto& first = items[entries[groupStart].index];
+        uint groupEnd = groupStart + 1;
+        if (state->instancing && !first.animation)
         {
-          // Dynamic geometry pass for skinned objects.
-          auto& bones = animation->getFinalBoneTransforms();
-          storage->boneBuffer.setData(0, bones.size() * sizeof(glm::mat4),
-                                      bones.data());
-          
-          for (auto& submesh : data->getSubmeshes())
+          while (groupEnd < entries.size())
           {
-            // Cull the submesh if it isn't in the frustum.
-            glm::vec3 min = submesh.getMinPos();
-            glm::vec3 max = submesh.getMaxPos();
-            
-            if (!boundingBoxInFrustum(storage->camFrustum, min, max, transform) && state->frustumCull)
-              continue;
-            
-            Material* material = materials->getMaterial(submesh.getName());
-            if (!material)
-              continue;
-            
-            storage->transformBuffer.setData(0, sizeof(glm::mat4), glm::value_ptr(transform));
-            
-            glm::vec4 maskColourID;
-            if (drawSelectionMask)
-            {
-              // Enable edge detection for selected mesh outlines.
-              storage->drawEdge = true;
-              maskColourID = glm::vec4(1.0f);
-            }
-            else
-              maskColourID = glm::vec4(0.0f);
-          
-            maskColourID.w = id + 1.0f;
-            storage->editorBuffer.setData(0, sizeof(glm::vec4), &maskColourID.x);
-          
-            material->configureDynamic(dynamicGeometry);
-          
-            if (submesh.hasVAO())
-              Renderer3D::draw(submesh.getVAO(), dynamicGeometry);
-            else
-            {
-              submesh.generateVAO();
-              Renderer3D::draw(submesh.getVAO(), dynamicGeometry);
-            }
-          
-            stats->drawCalls++;
-            stats->numVertices += submesh.getData().size();
-            stats->numTriangles += submesh.getIndices().size() / 3;
+            auto& next = items[entries[groupEnd].index];
+            if (next.submesh != first.submesh || next.material != first.material
+                || next.lod != first.lod || next.animation)
+              break;
+            groupEnd++;
           }
         }
+
+        Mesh& submesh = *first.submesh;
+        if (!submesh.hasVAO(vertexFormat))
+          submesh.generateVAO(vertexFormat);
+
+        uint numInstances = groupEnd - groupStart;
+        Shader* program = first.animation ? skinnedProgram
+                                          : (numInstances > 1 ? instancedProgram : staticProgram);
+
+        if (first.material == boundMaterial && program == boundProgram)
+          stats->materialBindsSkipped++;
         else
         {
-          // Dynamic geometry pass for unskinned objects.
-          auto& bones = animation->getFinalUnSkinnedTransforms();
-          for (auto& submesh : data->getSubmeshes())
+          if (program == staticProgram)
+            first.material->configure();
+          else
+            first.material->configureDynamic(program);
+
+          boundMaterial = first.material;
+          boundProgram = program;
+        }
+
+        if (numInstances == 1)
+        {
+          if (first.animation && first.animation != boundAnimation)
           {
-            // Cull the submesh if it isn't in the frustum.
-            glm::vec3 min = submesh.getMinPos();
-            glm::vec3 max = submesh.getMaxPos();
-            
-            auto localTransform = transform * bones[submesh.getName()];
-            if (!boundingBoxInFrustum(storage->camFrustum, min, max, localTransform) && state->frustumCull)
-              continue;
-            
-            Material* material = materials->getMaterial(submesh.getName());
-            if (!material)
-              continue;
-            
-            storage->transformBuffer.setData(0, sizeof(glm::mat4), glm::value_ptr(localTransform));
-            
-            glm::vec4 maskColourID;
-            if (drawSelectionMask)
-            {
-              // Enable edge detection for selected mesh outlines.
-              storage->drawEdge = true;
-              maskColourID = glm::vec4(1.0f);
-            }
-            else
-              maskColourID = glm::vec4(0.0f);
-          
-            maskColourID.w = id + 1.0f;
-            storage->editorBuffer.setData(0, sizeof(glm::vec4), &maskColourID.x);
-          
-            material->configure();
-          
-            if (submesh.hasVAO())
-              Renderer3D::draw(submesh.getVAO(), staticGeometry);
-            else
-            {
-              submesh.generateVAO();
-              Renderer3D::draw(submesh.getVAO(), staticGeometry);
-            }
-          
-            stats->drawCalls++;
-            stats->numVertices += submesh.getData().size();
-            stats->numTriangles += submesh.getIndices().size() / 3;
+            auto& bones = first.animation->getFinalBoneTransforms();
+            storage->boneBuffer.setData(0, bones.size() * sizeof(glm::mat4), bones.data());
+            boundAnimation = first.animation;
           }
+
+          storage->drawDataBuffer.bindData(3, &first.instance.maskColourID.x, sizeof(glm::vec4));
+
+          drawSubmesh(submesh, first.instance.modelMatrix, program, !first.animation);
+        }
+        else
+        {
+          submesh.getVAO()->setIndices(first.lod);
+          glm::vec4 meshFormat(submesh.getVertexFormat() == VertexFormat::Packed ? 1.0f : 0.0f,
+                               static_cast<float>(groupStart), 0.0f, 0.0f);
+          bindModelBlock(first.instance.modelMatrix, meshFormat);
+
+          drawInstanced(submesh.getVAO(), instancedProgram, numInstances);
+
+          uint numIndices = submesh.getNumIndices(first.lod);
+          stats->drawCalls++;
+          stats->drawCallsSaved += numInstances - 1;
+          stats->numVertices += numInstances * submesh.getNumVertices();
+          stats->vertexBytes += numInstances * submesh.getVertexBytes();
+          stats->numTriangles += numInstances * (numIndices / 3);
+          stats->trianglesSaved += numInstances * ((submesh.getNumIndices(0) - numIndices) / 3);
         }
+
+        groupStart = groupEnd;
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    // Deferred geometry pass.
+    //--------------------------------------------------------------------------
+    void geometryPass()
+    {
+      auto start = std::chrono::steady_clock::now();
+
+      // Upload camera uniforms to the camera uniform buffer.
+      storage->camBuffer.bindToPoint(0);
+      CameraBlockData cameraBlock;
+      cameraBlock.viewMatrix = storage->sceneCam.view;
+      cameraBlock.projMatrix = storage->sceneCam.projection;
+      cameraBlock.invViewProjMatrix = storage->sceneCam.invViewProj;
+      cameraBlock.camPosition = glm::vec4(storage->sceneCam.position, 0.0f);
+      cameraBlock.nearFar = glm::vec4(storage->sceneCam.near, storage->sceneCam.far, 0.0f, 0.0f);
+      storage->camBuffer.setData(cameraBlock);
+
+      // Start the geometry pass.
+      storage->gBuffer.beginGeoPass();
+
+      Shader* staticGeometry = ShaderCache::getShader("geometry_pass_shader");
+      Shader* dynamicGeometry = ShaderCache::getShader("dynamic_geometry_pass");
+      Shader* indirectGeometry = ShaderCache::getShader("indirect_geometry_pass");
+      Shader* instancedGeometry = ShaderCache::getShader("instanced_geometry_pass");
+
+      VertexFormat vertexFormat = state->packedVertices ? VertexFormat::Packed : VertexFormat::Full;
+
+      storage->indirectDraws.clear();
+      storage->drawItems.clear();
+      storage->shaderSortIDs.clear();
+      storage->materialSortIDs.clear();
+      storage->meshSortIDs.clear();
+      storage->textureSetIDs.clear();
+      storage->materialTextureSets.clear();
+
+      // Queue the submeshes which survived culling.
+      for (uint index : storage->cameraCuller.getVisible(0))
+      {
+        auto& item = storage->cameraCullItems[index];
+        Mesh& submesh = *item.submesh;
+
+        Material* material = item.materials->getMaterial(submesh.getName());
+        if (!material)
+          continue;
+
+        // Enable edge detection for selected mesh outlines.
+        if (item.selected)
+          storage->drawEdge = true;
+
+        // Batch static submeshes with the rest of the arena, if they fit.
+        if (item.isStatic && state->indirectDraws && submesh.uploadToArena())
+        {
+          uint numIndices = queueIndirect(submesh, item.transform, material, item.maskColourID, true);
+
+          stats->numVertices += submesh.getNumVertices();
+          stats->vertexBytes += static_cast<uint64_t>(submesh.getNumVertices()) * sizeof(Vertex);
+          stats->numTriangles += numIndices / 3;
+          stats->trianglesSaved += (submesh.getNumIndices(0) - numIndices) / 3;
+          continue;
+        }
+
+        queueDrawItem(submesh, material, item.animation,
+                      item.animation ? dynamicGeometry : staticGeometry,
+                      item.transform, item.maskColourID);
+      }
+
+      // Draw the queued items in sorted order.
+      storage->boneBuffer.bindToPoint(4);
+      if (!storage->drawItems.empty())
+        drawSortedItems(staticGeometry, instancedGeometry, dynamicGeometry, vertexFormat);
+
+      // Draw the static geometry in the arena, one batch per material.
+      if (!storage->indirectDraws.empty())
+      {
+        uploadIndirect(true);
+        stats->drawCalls += drawIndirect(indirectGeometry, 0,
+                                         static_cast<uint>(storage->indirectCommands.size()), true);
       }
 
       storage->gBuffer.endGeoPass();
@@ -500,13 +921,11 @@ namespace Strontium
     }
 
     //--------------------------------------------------------------------------
-    // Deferred shadow mapping pass. Cascaded shadows for a "primary light".
+    // Directional light shadow cascades.
     //--------------------------------------------------------------------------
     void
-    shadowPass()
+    computeCascades()
     {
-      auto start = std::chrono::steady_clock::now();
-
       //------------------------------------------------------------------------
       // Directional light shadow cascade calculations:
       //------------------------------------------------------------------------
@@ -519,7 +938,6 @@ namespace Strontium
 
       glm::mat4 camInvVP = storage->sceneCam.invViewProj;
 
-      Frustum lightCullingFrustums[NUM_CASCADES];
       float cascadeSplits[NUM_CASCADES];
 
       const float clipRange = far - near;
@@ -542,17 +960,25 @@ namespace Strontium
       // still need to cast shadows).
       glm::vec3 minPos = glm::vec3(std::numeric_limits<float>::max());
       glm::vec3 maxPos = glm::vec3(std::numeric_limits<float>::min());
-      for (auto& [model, transform] : storage->staticShadowQueue)
+      if (storage->hasCasterBounds)
       {
-        auto localTransform = transform * model->getGlobalTransform();
-        minPos = glm::min(minPos, glm::vec3(localTransform * glm::vec4(model->getMinPos(), 1.0f)));
-        maxPos = glm::max(maxPos, glm::vec3(localTransform * glm::vec4(model->getMaxPos(), 1.0f)));
+        minPos = storage->casterMin;
+        maxPos = storage->casterMax;
       }
-      for (auto& [model, animation, transform] : storage->dynamicShadowQueue)
+      else
       {
-        auto localTransform = transform * model->getGlobalTransform();
-        minPos = glm::min(minPos, glm::vec3(localTransform * glm::vec4(model->getMinPos(), 1.0f)));
-        maxPos = glm::max(maxPos, glm::vec3(localTransform * glm::vec4(model->getMaxPos(), 1.0f)));
+        for (auto& [model, transform] : storage->staticShadowQueue)
+        {
+          auto localTransform = transform * model->getGlobalTransform();
+          minPos = glm::min(minPos, glm::vec3(localTransform * glm::vec4(model->getMinPos(), 1.0f)));
+          maxPos = glm::max(maxPos, glm::vec3(localTransform * glm::vec4(model->getMaxPos(), 1.0f)));
+        }
+        for (auto& [model, animation, transform] : storage->dynamicShadowQueue)
+        {
+          auto localTransform = transform * model->getGlobalTransform();
+          minPos = glm::min(minPos, glm::vec3(localTransform * glm::vec4(model->getMinPos(), 1.0f)));
+          maxPos = glm::max(maxPos, glm::vec3(localTransform * glm::vec4(model->getMaxPos(), 1.0f)));
+        }
       }
 
       float sceneMaxRadius = glm::length(minPos);
@@ -663,22 +1089,178 @@ namespace Strontium
           cascadeProjMatrix[i] = texelSpaceOrtho;
 
           storage->cascades[i] = cascadeProjMatrix[i] * cascadeViewMatrix[i];
-          lightCullingFrustums[i] = buildCameraFrustum(storage->cascades[i], -lightDir);
+          storage->cascadeFrustums[i] = buildCameraFrustum(storage->cascades[i], -lightDir);
 
           previousCascadeDistance = cascadeSplits[i];
 
           storage->cascadeSplits[i].x = minZ + (cascadeSplits[i] * clipRange);
         }
       }
+    }
+
+    //--------------------------------------------------------------------------
+    // Culling pass. Every submesh is culled against the camera and the
+    // cascades up front, so the passes only walk the visible lists.
+    //--------------------------------------------------------------------------
+    // Compute the world space bounds of the items across the pool, then cull
+    // them against the frustums.
+    void
+    cullItems(const std::vector<CullItem> &items, CullingBounds &bounds, FrustumCuller &culler,
+              const Frustum* frustums, uint numFrustums, ThreadPool* pool)
+    {
+      const uint numItems = static_cast<uint>(items.size());
+      if (!state->frustumCull)
+      {
+        culler.setAllVisible(numItems, numFrustums);
+        return;
+      }
+
+      bounds.resize(numItems);
+      pool->parallelFor(0, numItems, 1024, [&items, &bounds](uint i)
+      {
+        auto& item = items[i];
+        bounds.set(i, buildBoundingBox(item.submesh->getMinPos(), item.submesh->getMaxPos(),
+                                       item.transform));
+      });
+
+      culler.cull(bounds, frustums, numFrustums, pool);
+    }
+
+    void
+    cullingPass()
+    {
+      auto start = std::chrono::steady_clock::now();
+
+      computeCascades();
+
+      // Gather the submeshes with the transforms they're drawn with. Done on
+      // this thread, the unskinned bone lookups aren't thread safe.
+      auto& cameraItems = storage->cameraCullItems;
+      cameraItems.clear();
+      for (auto& [data, materials, transform, id, drawSelectionMask] : storage->staticRenderQueue)
+      {
+        glm::vec4 maskColourID(drawSelectionMask ? 1.0f : 0.0f);
+        maskColourID.w = id + 1.0f;
+
+        for (auto& submesh : data->getSubmeshes())
+        {
+          cameraItems.push_back({ &submesh, materials, nullptr, transform * submesh.getTransform(),
+                                  maskColourID, true, drawSelectionMask });
+        }
+      }
+      for (auto& [data, animation, materials, transform, id, drawSelectionMask] : storage->dynamicRenderQueue)
+      {
+        glm::vec4 maskColourID(drawSelectionMask ? 1.0f : 0.0f);
+        maskColourID.w = id + 1.0f;
+
+        if (data->hasSkins())
+        {
+          for (auto& submesh : data->getSubmeshes())
+          {
+            cameraItems.push_back({ &submesh, materials, animation, transform,
+                                    maskColourID, false, drawSelectionMask });
+          }
+        }
+        else
+        {
+          auto& bones = animation->getFinalUnSkinnedTransforms();
+          for (auto& submesh : data->getSubmeshes())
+          {
+            cameraItems.push_back({ &submesh, materials, nullptr, transform * bones[submesh.getName()],
+                                    maskColourID, false, drawSelectionMask });
+          }
+        }
+      }
+
+      auto& shadowItems = storage->shadowCullItems;
+      shadowItems.clear();
+      if (storage->hasCascades)
+      {
+        for (auto& [model, transform] : storage->staticShadowQueue)
+        {
+          for (auto& submesh : model->getSubmeshes())
+          {
+            shadowItems.push_back({ &submesh, nullptr, nullptr, transform * submesh.getTransform(),
+                                    glm::vec4(0.0f), true, false });
+          }
+        }
+        for (auto& [model, animation, transform] : storage->dynamicShadowQueue)
+        {
+          if (model->hasSkins())
+          {
+            for (auto& submesh : model->getSubmeshes())
+            {
+              shadowItems.push_back({ &submesh, nullptr, animation, transform,
+                                      glm::vec4(0.0f), false, false });
+            }
+          }
+          else
+          {
+            auto& bones = animation->getFinalUnSkinnedTransforms();
+            for (auto& submesh : model->getSubmeshes())
+            {
+              shadowItems.push_back({ &submesh, nullptr, nullptr, transform * bones[submesh.getName()],
+                                      glm::vec4(0.0f), false, false });
+            }
+          }
+        }
+      }
+
+      ThreadPool* pool = ThreadPool::getInstance();
+      cullItems(cameraItems, storage->cameraBounds, storage->cameraCuller,
+                &storage->camFrustum, 1, pool);
+      cullItems(shadowItems, storage->shadowBounds, storage->shadowCuller,
+                storage->cascadeFrustums, storage->hasCascades ? NUM_CASCADES : 0, pool);
+
+      auto end = std::chrono::steady_clock::now();
+      std::chrono::duration<double> elapsed = end - start;
+      stats->cullFrametime += elapsed.count() * 1000.0f;
+    }
+
+    //--------------------------------------------------------------------------
+    // Deferred shadow mapping pass. Cascaded shadows for a "primary light".
+    //--------------------------------------------------------------------------
+    void
+    shadowPass()
+    {
+      auto start = std::chrono::steady_clock::now();
 
       // Actual shadow pass.
       Shader* horizontalShadowBlur = ShaderCache::getShader("gaussian_hori");
       Shader* verticalShadowBlur = ShaderCache::getShader("gaussian_vert");
 
-      storage->transformBuffer.bindToPoint(2);
+      VertexFormat vertexFormat = state->packedVertices ? VertexFormat::Packed : VertexFormat::Full;
+
+      // Queue the static shadow casters in the arena for every cascade up
+      // front, so the commands are only uploaded once.
+      auto& shadowItems = storage->shadowCullItems;
+      uint cascadeCommands[NUM_CASCADES + 1] = { 0 };
+      if (storage->hasCascades && state->indirectDraws)
+      {
+        storage->indirectDraws.clear();
+        for (unsigned int i = 0; i < NUM_CASCADES; i++)
+        {
+          for (uint index : storage->shadowCuller.getVisible(i))
+          {
+            auto& item = shadowItems[index];
+            if (item.isStatic && item.submesh->uploadToArena())
+              queueIndirect(*item.submesh, item.transform, nullptr, glm::vec4(0.0f), false);
+          }
+          cascadeCommands[i + 1] = static_cast<uint>(storage->indirectDraws.size());
+        }
+
+        uploadIndirect(false);
+      }
 
       if (storage->hasCascades)
       {
+        Shader* staticShadow = ShaderCache::getShader("static_shadow_shader");
+        Shader* dynamicShadow = ShaderCache::getShader("dynamic_shadow_shader");
+        Shader* indirectShadow = ShaderCache::getShader("indirect_shadow_shader");
+
+        // The geometry pass leaves other bones in the buffer.
+        Animator* boundAnimation = nullptr;
+
         for (unsigned int i = 0; i < NUM_CASCADES; i++)
         {
           storage->shadowBuffer[i].bind();
@@ -687,88 +1269,35 @@ namespace Strontium
           storage->cascadeShadowPassBuffer.bindToPoint(6);
           storage->cascadeShadowPassBuffer.setData(0, sizeof(glm::mat4), glm::value_ptr(storage->cascades[i]));
 
-          Shader* staticShadow = ShaderCache::getShader("static_shadow_shader");
-          Shader* dynamicShadow = ShaderCache::getShader("dynamic_shadow_shader");
-
-          // Static shadow pass.
-          for (auto& [model, transform] : storage->staticShadowQueue)
+          // Static shadow pass, from the arena.
+          if (cascadeCommands[i + 1] > cascadeCommands[i])
           {
-            for (auto& submesh : model->getSubmeshes())
-            {
-              // Cull the submesh if it isn't in the frustum.
-              glm::vec3 min = submesh.getMinPos();
-              glm::vec3 max = submesh.getMaxPos();
-
-              auto localTransform = transform * submesh.getTransform();
-              storage->transformBuffer.setData(0, sizeof(glm::mat4), glm::value_ptr(localTransform));
-
-              if (!boundingBoxInFrustum(lightCullingFrustums[i], min, max, localTransform) && state->frustumCull)
-                continue;
-
-              if (submesh.hasVAO())
-                Renderer3D::draw(submesh.getVAO(), staticShadow);
-              else
-              {
-                submesh.generateVAO();
-                Renderer3D::draw(submesh.getVAO(), staticShadow);
-              }
-            }
+            drawIndirect(indirectShadow, cascadeCommands[i],
+                         cascadeCommands[i + 1] - cascadeCommands[i], false);
           }
 
-          // Dynamic shadow pass.
-          for (auto& [model, animation, transform] : storage->dynamicShadowQueue)
+          // Everything else visible to the cascade.
+          for (uint index : storage->shadowCuller.getVisible(i))
           {
-            if (model->hasSkins())
+            auto& item = shadowItems[index];
+            Mesh& submesh = *item.submesh;
+            if (item.isStatic && state->indirectDraws && submesh.isInArena())
+              continue;
+
+            if (item.animation && item.animation != boundAnimation)
             {
-              storage->transformBuffer.setData(0, sizeof(glm::mat4), glm::value_ptr(transform));
-              
-              auto& bones = animation->getFinalBoneTransforms();
+              auto& bones = item.animation->getFinalBoneTransforms();
               storage->boneBuffer.setData(0, bones.size() * sizeof(glm::mat4),
                                           bones.data());
-              
-              for (auto& submesh : model->getSubmeshes())
-              {
-                // Cull the submesh if it isn't in the frustum.
-                glm::vec3 min = submesh.getMinPos();
-                glm::vec3 max = submesh.getMaxPos();
-              
-                if (!boundingBoxInFrustum(lightCullingFrustums[i], min, max, transform) && state->frustumCull)
-                  continue;
-              
-                if (submesh.hasVAO())
-                  Renderer3D::draw(submesh.getVAO(), dynamicShadow);
-                else
-                {
-                  submesh.generateVAO();
-                  Renderer3D::draw(submesh.getVAO(), dynamicShadow);
-                }
-              }
-            }
-            else
-            {
-              // Dynamic shadow pass for unskinned objects.
-              auto& bones = animation->getFinalUnSkinnedTransforms();
-              for (auto& submesh : model->getSubmeshes())
-              {
-                // Cull the submesh if it isn't in the frustum.
-                glm::vec3 min = submesh.getMinPos();
-                glm::vec3 max = submesh.getMaxPos();
-                
-                auto localTransform = transform * bones[submesh.getName()];
-                if (!boundingBoxInFrustum(lightCullingFrustums[i], min, max, localTransform) && state->frustumCull)
-                  continue;
-                
-                storage->transformBuffer.setData(0, sizeof(glm::mat4), glm::value_ptr(localTransform));
-              
-                if (submesh.hasVAO())
-                  Renderer3D::draw(submesh.getVAO(), staticShadow);
-                else
-                {
-                  submesh.generateVAO();
-                  Renderer3D::draw(submesh.getVAO(), staticShadow);
-                }
-              }
+              boundAnimation = item.animation;
             }
+
+            bindModelBlock(item.transform, glm::vec4(0.0f));
+
+            if (!submesh.hasVAO(vertexFormat))
+              submesh.generateVAO(vertexFormat);
+            selectLOD(submesh, item.transform);
+            Renderer3D::draw(submesh.getVAO(), item.animation ? dynamicShadow : staticShadow);
           }
         }
 
@@ -928,19 +1457,17 @@ namespace Strontium
       // Set the shadow map uniforms.
       if (storage->hasCascades)
       {
-        storage->cascadeShadowBuffer.bindToPoint(7);
+        CascadedShadowBlockData shadowBlock;
         for (unsigned int i = 0; i < NUM_CASCADES; i++)
         {
-          storage->cascadeShadowBuffer.setData(i * sizeof(glm::mat4), sizeof(glm::mat4),
-                                                glm::value_ptr(storage->cascades[i]));
-          storage->cascadeShadowBuffer.setData(NUM_CASCADES * sizeof(glm::mat4)
-                                                + i * sizeof(glm::vec4), sizeof(glm::vec4),
-                                                &storage->cascadeSplits[i]);
+          shadowBlock.lightVP[i] = storage->cascades[i];
+          shadowBlock.cascadeData[i] = storage->cascadeSplits[i];
         }
-        storage->cascadeShadowBuffer.setData(NUM_CASCADES * sizeof(glm::mat4)
-                                              + NUM_CASCADES * sizeof(glm::vec4),
-                                              2 * sizeof(glm::vec4),
-                                              state->shadowParams);
+        shadowBlock.shadowParams[0] = state->shadowParams[0];
+        shadowBlock.shadowParams[1] = state->shadowParams[1];
+
+        storage->cascadeShadowBuffer.bindToPoint(7);
+        storage->cascadeShadowBuffer.setData(shadowBlock);
       }
 
       for (auto& light : storage->directionalQueue)
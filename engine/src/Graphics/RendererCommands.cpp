@@ -80,6 +80,21 @@ namespace Strontium
     glDrawElements(static_cast<GLenum>(primative), count, GL_UNSIGNED_INT, indices);
   }
 
+  void
+  RendererCommands::multiDrawElements(PrimativeType primative, const int* counts,
+                                      const void* const* indices, uint drawCount)
+  {
+    glMultiDrawElements(static_cast<GLenum>(primative), counts, GL_UNSIGNED_INT, indices, drawCount);
+  }
+
+  void
+  RendererCommands::drawElementsInstanced(PrimativeType primative, uint count,
+                                          uint numInstances, const void* indices)
+  {
+    glDrawElementsInstanced(static_cast<GLenum>(primative), count, GL_UNSIGNED_INT,
+                            indices, numInstances);
+  }
+
   void 
   RendererCommands::drawArrays(PrimativeType primative, uint start, uint count)
   {
@@ -3,6 +3,7 @@
 // Project includes.
 #include "Core/Logs.h"
 #include "Serialization/YamlSerialization.h"
+#include "Graphics/StateCache.h"
 
 // OpenGL includes.
 #include "glad/glad.h"
@@ -34,11 +35,13 @@ namespace Strontium
   }
 
   Shader::Shader()
+    : linkCount(0)
   {
     this->progID = glCreateProgram();
   }
 
   Shader::Shader(const std::string &filepath)
+    : linkCount(0)
   {
     this->progID = glCreateProgram();
 
@@ -56,12 +59,14 @@ namespace Strontium
 
   Shader::~Shader()
   {
+    StateCache::forgetProgram(this->progID);
     glDeleteProgram(this->progID);
   }
 
   void
   Shader::rebuild()
   {
+    StateCache::forgetProgram(this->progID);
     glDeleteProgram(this->progID);
     this->progID = glCreateProgram();
 
@@ -186,20 +191,20 @@ namespace Strontium
   void
   Shader::bind()
   {
-    glUseProgram(this->progID);
+    StateCache::useProgram(this->progID);
   }
 
   void
   Shader::unbind()
   {
-    glUseProgram(0);
+    StateCache::useProgram(0);
   }
 
   void
   Shader::launchCompute(uint globalX, uint globalY, uint globalZ)
   {
     assert(("Shader does not have a compute stage. ", this->shaderSources.count(ShaderStage::Compute)));
-    glUseProgram(this->progID);
+    StateCache::useProgram(this->progID);
     glDispatchCompute(globalX, globalY, globalZ);
   }
 
@@ -269,94 +274,248 @@ namespace Strontium
     // program.
     for (auto& shaderID : binaries)
       glDeleteShader(shaderID);
+
+    this->reflect();
+    this->linkCount++;
+  }
+
+  // Collect the active uniforms and uniform blocks of the linked program.
+  void
+  Shader::reflect()
+  {
+    this->uniforms.clear();
+    this->uniformBlocks.clear();
+    this->samplerUnits.clear();
+
+    int numUniforms = 0;
+    int maxNameLength = 0;
+    glGetProgramiv(this->progID, GL_ACTIVE_UNIFORMS, &numUniforms);
+    glGetProgramiv(this->progID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    std::vector<char> name(std::max(maxNameLength, 1));
+    int maxLocation = -1;
+    for (int i = 0; i < numUniforms; i++)
+    {
+      int nameLength = 0;
+      int size = 0;
+      GLenum type = 0;
+      glGetActiveUniform(this->progID, i, static_cast<GLsizei>(name.size()), &nameLength,
+                         &size, &type, name.data());
+
+      // Members of uniform blocks don't have a location.
+      std::string uniformName(name.data(), nameLength);
+      int location = glGetUniformLocation(this->progID, uniformName.c_str());
+      if (location < 0)
+        continue;
+
+      UniformInfo info;
+      info.location = location;
+      info.size = size;
+      info.type = uniformTypeFromGL(type);
+      this->uniforms.emplace(uniformName, info);
+
+      // Arrays are reported as "name[0]", but are also set by their name.
+      auto bracket = uniformName.find('[');
+      if (bracket != std::string::npos)
+        this->uniforms.emplace(uniformName.substr(0, bracket), info);
+
+      maxLocation = std::max(maxLocation, location);
+    }
+    this->samplerUnits.resize(maxLocation + 1, -1);
+
+    int numBlocks = 0;
+    glGetProgramiv(this->progID, GL_ACTIVE_UNIFORM_BLOCKS, &numBlocks);
+    glGetProgramiv(this->progID, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxNameLength);
+    name.resize(std::max(maxNameLength, 1));
+    for (int i = 0; i < numBlocks; i++)
+    {
+      int nameLength = 0;
+      int binding = 0;
+      glGetActiveUniformBlockName(this->progID, i, static_cast<GLsizei>(name.size()),
+                                  &nameLength, name.data());
+      glGetActiveUniformBlockiv(this->progID, i, GL_UNIFORM_BLOCK_BINDING, &binding);
+      this->uniformBlocks.emplace(std::string(name.data(), nameLength), binding);
+    }
+  }
+
+  UniformType
+  Shader::uniformTypeFromGL(uint glType)
+  {
+    switch (glType)
+    {
+      case GL_FLOAT: return UniformType::Float;
+      case GL_FLOAT_VEC2: return UniformType::Vec2;
+      case GL_FLOAT_VEC3: return UniformType::Vec3;
+      case GL_FLOAT_VEC4: return UniformType::Vec4;
+      case GL_FLOAT_MAT3: return UniformType::Mat3;
+      case GL_FLOAT_MAT4: return UniformType::Mat4;
+      case GL_SAMPLER_1D: return UniformType::Sampler1D;
+      case GL_SAMPLER_2D: return UniformType::Sampler2D;
+      case GL_SAMPLER_3D: return UniformType::Sampler3D;
+      case GL_SAMPLER_CUBE: return UniformType::SamplerCube;
+      default: return UniformType::Unknown;
+    }
+  }
+
+  // Handles are only looked up by name once, the setters don't touch the
+  // name table. Names which aren't active uniforms get an invalid handle,
+  // which the setters ignore.
+  UniformHandle
+  Shader::getUniformHandle(const std::string &uniformName)
+  {
+    auto loc = this->uniforms.find(uniformName);
+    if (loc == this->uniforms.end())
+      return UniformHandle();
+
+    return UniformHandle(loc->second.location);
+  }
+
+  int
+  Shader::getUniformBlockBinding(const std::string &blockName)
+  {
+    auto loc = this->uniformBlocks.find(blockName);
+    return loc != this->uniformBlocks.end() ? loc->second : -1;
+  }
+
+  // Push uniform data by handle. glProgramUniform is core since 4.1, so the
+  // program doesn't need to be bound.
+  void
+  Shader::addUniformMatrix(UniformHandle handle, const glm::mat4 &matrix, bool transpose)
+  {
+    glProgramUniformMatrix4fv(this->progID, handle.location, 1, static_cast<GLboolean>(transpose),
+                              glm::value_ptr(matrix));
   }
 
-  // Push uniform data.
-	void
-	Shader::addUniformMatrix(const char* uniformName, const glm::mat4 &matrix,
-													  bool transpose)
-	{
-		GLboolean glTranspose = static_cast<GLboolean>(transpose);
-		glUseProgram(this->progID);
-		uint uniLoc = glGetUniformLocation(this->progID, uniformName);
-		glUniformMatrix4fv(uniLoc, 1, glTranspose, glm::value_ptr(matrix));
-	}
-
-	void
-	Shader::addUniformMatrix(const char* uniformName, const glm::mat3 &matrix,
-													  bool transpose)
-	{
-		GLboolean glTranspose = static_cast<GLboolean>(transpose);
-		glUseProgram(this->progID);
-		uint uniLoc = glGetUniformLocation(this->progID, uniformName);
-		glUniformMatrix3fv(uniLoc, 1, glTranspose, glm::value_ptr(matrix));
-	}
-
-	void
-	Shader::addUniformMatrix(const char* uniformName, const glm::mat2 &matrix,
-													  bool transpose)
-	{
-		GLboolean glTranspose = static_cast<GLboolean>(transpose);
-		glUseProgram(this->progID);
-		uint uniLoc = glGetUniformLocation(this->progID, uniformName);
-		glUniformMatrix2fv(uniLoc, 1, glTranspose, glm::value_ptr(matrix));
-	}
-
-	void
-	Shader::addUniformVector(const char* uniformName, const glm::vec4 &vector)
-	{
-		glUseProgram(this->progID);
-		uint uniLoc = glGetUniformLocation(this->progID, uniformName);
-		glUniform4f(uniLoc, vector[0], vector[1], vector[2], vector[3]);
-	}
-
-	void
-	Shader::addUniformVector(const char* uniformName, const glm::vec3 &vector)
-	{
-		glUseProgram(this->progID);
-		uint uniLoc = glGetUniformLocation(this->progID, uniformName);
-		glUniform3f(uniLoc, vector[0], vector[1], vector[2]);
-	}
-
-	void
-	Shader::addUniformVector(const char* uniformName, const glm::vec2 &vector)
-	{
-		glUseProgram(this->progID);
-		uint uniLoc = glGetUniformLocation(this->progID, uniformName);
-		glUniform2f(uniLoc, vector[0], vector[1]);
-	}
-
-	void
-	Shader::addUniformFloat(const char* uniformName, float value)
-	{
-		glUseProgram(this->progID);
-		uint uniLoc = glGetUniformLocation(this->progID, uniformName);
-		glUniform1f(uniLoc, value);
-	}
-
-	void
-	Shader::addUniformInt(const char* uniformName, int value)
-	{
-		glUseProgram(this->progID);
-		uint uniLoc = glGetUniformLocation(this->progID, uniformName);
-		glUniform1i(uniLoc, value);
-	}
-
-	void
-	Shader::addUniformUInt(const char* uniformName, uint value)
-	{
-		glUseProgram(this->progID);
-		uint uniLoc = glGetUniformLocation(this->progID, uniformName);
-		glUniform1ui(uniLoc, value);
-	}
-
-	void
-	Shader::addUniformSampler(const char* uniformName, uint texID)
-	{
-		glUseProgram(this->progID);
-		uint uniLoc = glGetUniformLocation(this->progID, uniformName);
-		glUniform1i(uniLoc, texID);
-	}
+  void
+  Shader::addUniformMatrix(UniformHandle handle, const glm::mat3 &matrix, bool transpose)
+  {
+    glProgramUniformMatrix3fv(this->progID, handle.location, 1, static_cast<GLboolean>(transpose),
+                              glm::value_ptr(matrix));
+  }
+
+  void
+  Shader::addUniformMatrix(UniformHandle handle, const glm::mat2 &matrix, bool transpose)
+  {
+    glProgramUniformMatrix2fv(this->progID, handle.location, 1, static_cast<GLboolean>(transpose),
+                              glm::value_ptr(matrix));
+  }
+
+  void
+  Shader::addUniformVector(UniformHandle handle, const glm::vec4 &vector)
+  {
+    glProgramUniform4f(this->progID, handle.location, vector[0], vector[1], vector[2], vector[3]);
+  }
+
+  void
+  Shader::addUniformVector(UniformHandle handle, const glm::vec3 &vector)
+  {
+    glProgramUniform3f(this->progID, handle.location, vector[0], vector[1], vector[2]);
+  }
+
+  void
+  Shader::addUniformVector(UniformHandle handle, const glm::vec2 &vector)
+  {
+    glProgramUniform2f(this->progID, handle.location, vector[0], vector[1]);
+  }
+
+  void
+  Shader::addUniformFloat(UniformHandle handle, float value)
+  {
+    glProgramUniform1f(this->progID, handle.location, value);
+  }
+
+  void
+  Shader::addUniformInt(UniformHandle handle, int value)
+  {
+    glProgramUniform1i(this->progID, handle.location, value);
+
+    // Might be a sampler, so forget the unit.
+    if (handle.location >= 0 && static_cast<uint>(handle.location) < this->samplerUnits.size())
+      this->samplerUnits[handle.location] = -1;
+  }
+
+  void
+  Shader::addUniformUInt(UniformHandle handle, uint value)
+  {
+    glProgramUniform1ui(this->progID, handle.location, value);
+  }
+
+  // Samplers rarely change units, so the upload is skipped if it's the same.
+  void
+  Shader::addUniformSampler(UniformHandle handle, uint texID)
+  {
+    if (handle.location < 0 || static_cast<uint>(handle.location) >= this->samplerUnits.size())
+      return;
+    if (this->samplerUnits[handle.location] == static_cast<int>(texID))
+      return;
+
+    glProgramUniform1i(this->progID, handle.location, texID);
+    this->samplerUnits[handle.location] = static_cast<int>(texID);
+  }
+
+  // Push uniform data by name.
+  void
+  Shader::addUniformMatrix(const char* uniformName, const glm::mat4 &matrix,
+                           bool transpose)
+  {
+    this->addUniformMatrix(this->getUniformHandle(uniformName), matrix, transpose);
+  }
+
+  void
+  Shader::addUniformMatrix(const char* uniformName, const glm::mat3 &matrix,
+                           bool transpose)
+  {
+    this->addUniformMatrix(this->getUniformHandle(uniformName), matrix, transpose);
+  }
+
+  void
+  Shader::addUniformMatrix(const char* uniformName, const glm::mat2 &matrix,
+                           bool transpose)
+  {
+    this->addUniformMatrix(this->getUniformHandle(uniformName), matrix, transpose);
+  }
+
+  void
+  Shader::addUniformVector(const char* uniformName, const glm::vec4 &vector)
+  {
+    this->addUniformVector(this->getUniformHandle(uniformName), vector);
+  }
+
+  void
+  Shader::addUniformVector(const char* uniformName, const glm::vec3 &vector)
+  {
+    this->addUniformVector(this->getUniformHandle(uniformName), vector);
+  }
+
+  void
+  Shader::addUniformVector(const char* uniformName, const glm::vec2 &vector)
+  {
+    this->addUniformVector(this->getUniformHandle(uniformName), vector);
+  }
+
+  void
+  Shader::addUniformFloat(const char* uniformName, float value)
+  {
+    this->addUniformFloat(this->getUniformHandle(uniformName), value);
+  }
+
+  void
+  Shader::addUniformInt(const char* uniformName, int value)
+  {
+    this->addUniformInt(this->getUniformHandle(uniformName), value);
+  }
+
+  void
+  Shader::addUniformUInt(const char* uniformName, uint value)
+  {
+    this->addUniformUInt(this->getUniformHandle(uniformName), value);
+  }
+
+  void
+  Shader::addUniformSampler(const char* uniformName, uint texID)
+  {
+    this->addUniformSampler(this->getUniformHandle(uniformName), texID);
+  }
 
     namespace ShaderCache
     {
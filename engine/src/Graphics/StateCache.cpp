@@ -0,0 +1,187 @@
+#include "Graphics/StateCache.h"
+
+// OpenGL includes.
+#include "glad/glad.h"
+
+namespace Strontium
+{
+  namespace StateCache
+  {
+    // Calls straight into OpenGL.
+    class GLStateBackend : public StateCacheBackend
+    {
+    public:
+      void useProgram(uint programID) override { glUseProgram(programID); }
+      void bindVertexArray(uint arrayID) override { glBindVertexArray(arrayID); }
+      void activeTexture(uint unit) override { glActiveTexture(GL_TEXTURE0 + unit); }
+      void bindTexture(uint target, uint textureID) override { glBindTexture(target, textureID); }
+    };
+
+    // Texture targets with a cached binding per unit.
+    constexpr uint numCachedTargets = 4;
+
+    // Marks state which hasn't been seen yet, and so always needs the call.
+    constexpr uint unknownState = std::numeric_limits<uint>::max();
+
+    GLStateBackend glBackend;
+    StateCacheBackend* backend = &glBackend;
+    StateCacheStats stats;
+
+    uint currentProgram = unknownState;
+    uint currentArray = unknownState;
+    uint currentUnit = unknownState;
+    uint currentTextures[MAX_CACHED_TEXTURE_UNITS][numCachedTargets];
+    bool texturesValid = false;
+
+    // Slot of a target in the per-unit bindings, or numCachedTargets if it
+    // isn't cached.
+    uint
+    getTargetSlot(uint target)
+    {
+      switch (target)
+      {
+        case GL_TEXTURE_2D: return 0;
+        case GL_TEXTURE_2D_ARRAY: return 1;
+        case GL_TEXTURE_CUBE_MAP: return 2;
+        case GL_TEXTURE_3D: return 3;
+        default: return numCachedTargets;
+      }
+    }
+
+    void
+    setBackend(StateCacheBackend* newBackend)
+    {
+      backend = newBackend ? newBackend : &glBackend;
+      invalidate();
+    }
+
+    void
+    useProgram(uint programID)
+    {
+      if (programID == currentProgram)
+      {
+        stats.bindsSkipped++;
+        return;
+      }
+
+      backend->useProgram(programID);
+      currentProgram = programID;
+      stats.bindsIssued++;
+    }
+
+    void
+    bindVertexArray(uint arrayID)
+    {
+      if (arrayID == currentArray)
+      {
+        stats.bindsSkipped++;
+        return;
+      }
+
+      backend->bindVertexArray(arrayID);
+      currentArray = arrayID;
+      stats.bindsIssued++;
+    }
+
+    void
+    activeTexture(uint unit)
+    {
+      if (unit == currentUnit)
+      {
+        stats.bindsSkipped++;
+        return;
+      }
+
+      backend->activeTexture(unit);
+      currentUnit = unit;
+      stats.bindsIssued++;
+    }
+
+    void
+    bindTexture(uint target, uint textureID)
+    {
+      if (!texturesValid)
+        invalidate();
+
+      uint slot = getTargetSlot(target);
+      bool cached = slot < numCachedTargets && currentUnit < MAX_CACHED_TEXTURE_UNITS;
+      if (cached && currentTextures[currentUnit][slot] == textureID)
+      {
+        stats.bindsSkipped++;
+        return;
+      }
+
+      backend->bindTexture(target, textureID);
+      if (cached)
+        currentTextures[currentUnit][slot] = textureID;
+      stats.bindsIssued++;
+    }
+
+    void
+    bindTexture(uint unit, uint target, uint textureID)
+    {
+      if (!texturesValid)
+        invalidate();
+
+      uint slot = getTargetSlot(target);
+      if (slot < numCachedTargets && unit < MAX_CACHED_TEXTURE_UNITS
+          && currentTextures[unit][slot] == textureID)
+      {
+        stats.bindsSkipped++;
+        return;
+      }
+
+      activeTexture(unit);
+      bindTexture(target, textureID);
+    }
+
+    void
+    forgetProgram(uint programID)
+    {
+      if (programID == currentProgram)
+        currentProgram = unknownState;
+    }
+
+    void
+    forgetVertexArray(uint arrayID)
+    {
+      if (arrayID == currentArray)
+        currentArray = 0;
+    }
+
+    void
+    forgetTexture(uint textureID)
+    {
+      for (uint i = 0; i < MAX_CACHED_TEXTURE_UNITS; i++)
+      {
+        for (uint j = 0; j < numCachedTargets; j++)
+        {
+          if (currentTextures[i][j] == textureID)
+            currentTextures[i][j] = 0;
+        }
+      }
+    }
+
+    void
+    invalidate()
+    {
+      currentProgram = unknownState;
+      currentArray = unknownState;
+      currentUnit = unknownState;
+      for (uint i = 0; i < MAX_CACHED_TEXTURE_UNITS; i++)
+      {
+        for (uint j = 0; j < numCachedTargets; j++)
+          currentTextures[i][j] = unknownState;
+      }
+      texturesValid = true;
+    }
+
+    StateCacheStats& getStats() { return stats; }
+
+    void
+    resetStats()
+    {
+      stats = StateCacheStats();
+    }
+  }
+}
@@ -5,6 +5,7 @@
 #include "Core/Events.h"
 #include "Assets/AssetManager.h"
 #include "Utils/Utilities.h"
+#include "Graphics/StateCache.h"
 
 // OpenGL includes.
 #include "glad/glad.h"
@@ -321,7 +322,7 @@ namespace Strontium
     , n(0)
   {
     glGenTextures(1, &this->textureID);
-    glBindTexture(GL_TEXTURE_2D, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_2D, this->textureID);
   }
 
   Texture2D::Texture2D(const uint &width, const uint &height, const uint &n,
@@ -333,7 +334,7 @@ namespace Strontium
     , filepath("")
   {
     glGenTextures(1, &this->textureID);
-    glBindTexture(GL_TEXTURE_2D, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_2D, this->textureID);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
                     static_cast<GLenum>(this->params.sWrap));
@@ -347,6 +348,7 @@ namespace Strontium
 
   Texture2D::~Texture2D()
   {
+    StateCache::forgetTexture(this->textureID);
     glDeleteTextures(1, &this->textureID);
   }
 
@@ -354,40 +356,40 @@ namespace Strontium
   void
   Texture2D::initNullTexture()
   {
-    glBindTexture(GL_TEXTURE_2D, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_2D, this->textureID);
     glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLenum>(this->params.internal),
                  this->width, this->height, 0, static_cast<GLenum>(this->params.format),
                  static_cast<GLenum>(this->params.dataType), nullptr);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    StateCache::bindTexture(GL_TEXTURE_2D, 0);
   }
 
   void
   Texture2D::loadData(const float* data)
   {
-    glBindTexture(GL_TEXTURE_2D, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_2D, this->textureID);
     glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLenum>(this->params.internal),
                  this->width, this->height, 0, static_cast<GLenum>(this->params.format),
                  static_cast<GLenum>(this->params.dataType), data);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    StateCache::bindTexture(GL_TEXTURE_2D, 0);
   }
 
   void
   Texture2D::loadData(const unsigned char* data)
   {
-    glBindTexture(GL_TEXTURE_2D, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_2D, this->textureID);
     glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLenum>(this->params.internal),
                  this->width, this->height, 0, static_cast<GLenum>(this->params.format),
                  static_cast<GLenum>(this->params.dataType), data);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    StateCache::bindTexture(GL_TEXTURE_2D, 0);
   }
 
   // Generate mipmaps.
   void
   Texture2D::generateMips()
   {
-    glBindTexture(GL_TEXTURE_2D, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_2D, this->textureID);
     glGenerateMipmap(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    StateCache::bindTexture(GL_TEXTURE_2D, 0);
   }
 
   // Clear the texture.
@@ -460,7 +462,7 @@ namespace Strontium
   {
     this->params = newParams;
 
-    glBindTexture(GL_TEXTURE_2D, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_2D, this->textureID);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
                     static_cast<GLint>(this->params.sWrap));
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
@@ -469,33 +471,31 @@ namespace Strontium
                     static_cast<GLint>(this->params.minFilter));
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
                     static_cast<GLint>(this->params.maxFilter));
-    glBindTexture(GL_TEXTURE_2D, 0);
+    StateCache::bindTexture(GL_TEXTURE_2D, 0);
   }
 
   void
   Texture2D::bind()
   {
-    glBindTexture(GL_TEXTURE_2D, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_2D, this->textureID);
   }
 
   void
   Texture2D::bind(uint bindPoint)
   {
-    glActiveTexture(GL_TEXTURE0 + bindPoint);
-    glBindTexture(GL_TEXTURE_2D, this->textureID);
+    StateCache::bindTexture(bindPoint, GL_TEXTURE_2D, this->textureID);
   }
 
   void
   Texture2D::unbind()
   {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    StateCache::bindTexture(GL_TEXTURE_2D, 0);
   }
 
   void
   Texture2D::unbind(uint bindPoint)
   {
-    glActiveTexture(GL_TEXTURE0 + bindPoint);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    StateCache::bindTexture(bindPoint, GL_TEXTURE_2D, 0);
   }
 
   // Bind the texture as an image unit.
@@ -525,7 +525,7 @@ namespace Strontium
     , params(params)
   {
     glGenTextures(1, &this->textureID);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    StateCache::bindTexture(GL_TEXTURE_2D_ARRAY, 0);
 
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S,
         static_cast<GLint>(this->params.sWrap));
@@ -539,6 +539,7 @@ namespace Strontium
 
   Texture2DArray::~Texture2DArray()
   {
+    StateCache::forgetTexture(this->textureID);
     glDeleteTextures(1, &this->textureID);
   }
 
@@ -546,10 +547,10 @@ namespace Strontium
   void 
   Texture2DArray::initNullTexture()
   {
-    glBindTexture(GL_TEXTURE_2D_ARRAY, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_2D_ARRAY, this->textureID);
     glTexStorage3D(GL_TEXTURE_2D_ARRAY, 0, static_cast<GLenum>(this->params.internal), 
                    this->width, this->height, this->numLayers);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    StateCache::bindTexture(GL_TEXTURE_2D_ARRAY, 0);
   }
 
   // Set the parameters after generating the texture.
@@ -567,7 +568,7 @@ namespace Strontium
   {
     this->params = newParams;
 
-    glBindTexture(GL_TEXTURE_2D_ARRAY, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_2D_ARRAY, this->textureID);
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S,
                     static_cast<GLint>(this->params.sWrap));
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T,
@@ -576,7 +577,7 @@ namespace Strontium
                     static_cast<GLint>(this->params.minFilter));
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER,
                     static_cast<GLint>(this->params.maxFilter));
-    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    StateCache::bindTexture(GL_TEXTURE_2D_ARRAY, 0);
   }
 
   // Generate mipmaps. TODO
@@ -597,27 +598,25 @@ namespace Strontium
   void 
   Texture2DArray::bind()
   {
-    glBindTexture(GL_TEXTURE_2D, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_2D, this->textureID);
   }
 
   void 
   Texture2DArray::bind(uint bindPoint)
   {
-    glActiveTexture(GL_TEXTURE0 + bindPoint);
-    glBindTexture(GL_TEXTURE_2D, this->textureID);
+    StateCache::bindTexture(bindPoint, GL_TEXTURE_2D, this->textureID);
   }
 
   void 
   Texture2DArray::unbind()
   {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    StateCache::bindTexture(GL_TEXTURE_2D, 0);
   }
 
   void 
   Texture2DArray::unbind(uint bindPoint)
   {
-    glActiveTexture(GL_TEXTURE0 + bindPoint);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    StateCache::bindTexture(bindPoint, GL_TEXTURE_2D, 0);
   }
 
   // Bind the texture as an image unit.
@@ -637,7 +636,7 @@ namespace Strontium
   CubeMap::CubeMap()
   {
     glGenTextures(1, &this->textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_CUBE_MAP, this->textureID);
 
     for (uint i = 0; i < 6; i++)
     {
@@ -660,7 +659,7 @@ namespace Strontium
 
     glGenTextures(1, &this->textureID);
 
-    glBindTexture(GL_TEXTURE_CUBE_MAP, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_CUBE_MAP, this->textureID);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S,
                     static_cast<GLenum>(params.sWrap));
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T,
@@ -671,33 +670,34 @@ namespace Strontium
                     static_cast<GLenum>(params.minFilter));
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER,
                     static_cast<GLenum>(params.maxFilter));
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    StateCache::bindTexture(GL_TEXTURE_CUBE_MAP, 0);
   }
 
   CubeMap::~CubeMap()
   {
+    StateCache::forgetTexture(this->textureID);
     glDeleteTextures(1, &this->textureID);
   }
 
   void
   CubeMap::initNullTexture()
   {
-    glBindTexture(GL_TEXTURE_CUBE_MAP, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_CUBE_MAP, this->textureID);
     for (unsigned int i = 0; i < 6; i++)
     {
       glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, static_cast<GLenum>(this->params.internal),
                   this->width[i], this->height[i], 0, static_cast<GLenum>(this->params.format),
                   static_cast<GLenum>(this->params.dataType), nullptr);
     }
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    StateCache::bindTexture(GL_TEXTURE_CUBE_MAP, 0);
   }
 
   void
   CubeMap::generateMips()
   {
-    glBindTexture(GL_TEXTURE_CUBE_MAP, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_CUBE_MAP, this->textureID);
     glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    StateCache::bindTexture(GL_TEXTURE_CUBE_MAP, 0);
   }
 
   // Clear the texture.
@@ -766,7 +766,7 @@ namespace Strontium
   {
     this->params = newParams;
 
-    glBindTexture(GL_TEXTURE_CUBE_MAP, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_CUBE_MAP, this->textureID);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S,
                     static_cast<GLint>(params.sWrap));
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T,
@@ -777,33 +777,31 @@ namespace Strontium
                     static_cast<GLint>(params.minFilter));
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER,
                     static_cast<GLint>(params.maxFilter));
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    StateCache::bindTexture(GL_TEXTURE_CUBE_MAP, 0);
   }
 
   void
   CubeMap::bind()
   {
-    glBindTexture(GL_TEXTURE_CUBE_MAP, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_CUBE_MAP, this->textureID);
   }
 
   void
   CubeMap::bind(uint bindPoint)
   {
-    glActiveTexture(GL_TEXTURE0 + bindPoint);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, this->textureID);
+    StateCache::bindTexture(bindPoint, GL_TEXTURE_CUBE_MAP, this->textureID);
   }
 
   void
   CubeMap::unbind()
   {
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    StateCache::bindTexture(GL_TEXTURE_CUBE_MAP, 0);
   }
 
   void
   CubeMap::unbind(uint bindPoint)
   {
-    glActiveTexture(GL_TEXTURE0 + bindPoint);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    StateCache::bindTexture(bindPoint, GL_TEXTURE_CUBE_MAP, 0);
   }
 
   // Bind the texture as an image unit.
@@ -836,7 +834,7 @@ namespace Strontium
     , params(params)
   {
     glGenTextures(1, &this->textureID);
-    glBindTexture(GL_TEXTURE_3D, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_3D, this->textureID);
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S,
         static_cast<GLint>(params.sWrap));
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T,
@@ -847,11 +845,12 @@ namespace Strontium
         static_cast<GLint>(params.minFilter));
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER,
         static_cast<GLint>(params.maxFilter));
-    glBindTexture(GL_TEXTURE_3D, 0);
+    StateCache::bindTexture(GL_TEXTURE_3D, 0);
   }
 
   Texture3D::~Texture3D()
   {
+    StateCache::forgetTexture(this->textureID);
     glDeleteTextures(1, &this->textureID);
   }
 
@@ -859,12 +858,12 @@ namespace Strontium
   void 
   Texture3D::initNullTexture()
   {
-    glBindTexture(GL_TEXTURE_3D, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_3D, this->textureID);
     glTexImage3D(GL_TEXTURE_3D, 0, static_cast<GLenum>(this->params.internal),
                    this->width, this->height, this->depth, 0, 
                    static_cast<GLenum>(this->params.format), 
                    static_cast<GLenum>(this->params.dataType), nullptr);
-    glBindTexture(GL_TEXTURE_3D, 0);
+    StateCache::bindTexture(GL_TEXTURE_3D, 0);
   }
 
   // TODO: Generate mipmaps.
@@ -892,7 +891,7 @@ namespace Strontium
   void 
   Texture3D::setParams(const Texture3DParams& newParams)
   {
-    glBindTexture(GL_TEXTURE_3D, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_3D, this->textureID);
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S,
         static_cast<GLint>(newParams.sWrap));
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T,
@@ -903,7 +902,7 @@ namespace Strontium
         static_cast<GLint>(newParams.minFilter));
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER,
         static_cast<GLint>(newParams.maxFilter));
-    glBindTexture(GL_TEXTURE_3D, 0);
+    StateCache::bindTexture(GL_TEXTURE_3D, 0);
     this->params = newParams;
   }
 
@@ -911,27 +910,25 @@ namespace Strontium
   void 
   Texture3D::bind()
   {
-    glBindTexture(GL_TEXTURE_3D, this->textureID);
+    StateCache::bindTexture(GL_TEXTURE_3D, this->textureID);
   }
 
   void 
   Texture3D::bind(uint bindPoint)
   {
-    glActiveTexture(GL_TEXTURE0 + bindPoint);
-    glBindTexture(GL_TEXTURE_3D, this->textureID);
+    StateCache::bindTexture(bindPoint, GL_TEXTURE_3D, this->textureID);
   }
 
   void 
   Texture3D::unbind()
   {
-    glBindTexture(GL_TEXTURE_3D, 0);
+    StateCache::bindTexture(GL_TEXTURE_3D, 0);
   }
 
   void 
   Texture3D::unbind(uint bindPoint)
   {
-    glActiveTexture(GL_TEXTURE0 + bindPoint);
-    glBindTexture(GL_TEXTURE_3D, 0);
+    StateCache::bindTexture(bindPoint, GL_TEXTURE_3D, 0);
   }
 
   // Bind the texture as an image unit.
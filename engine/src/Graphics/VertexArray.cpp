@@ -1,5 +1,6 @@
 // Project includes.
 #include "Graphics/VertexArray.h"
+#include "Graphics/StateCache.h"
 
 // OpenGL includes.
 #include "glad/glad.h"
@@ -12,7 +13,7 @@ namespace Strontium
     , indices(nullptr)
   {
     glGenVertexArrays(1, &this->arrayID);
-  	glBindVertexArray(this->arrayID);
+  	StateCache::bindVertexArray(this->arrayID);
     this->data->bind();
   }
 
@@ -21,7 +22,7 @@ namespace Strontium
   {
     this->data = createShared<VertexBuffer>(bufferData, dataSize, bufferType);
     glGenVertexArrays(1, &this->arrayID);
-  	glBindVertexArray(this->arrayID);
+  	StateCache::bindVertexArray(this->arrayID);
     this->data->bind();
   }
 
@@ -30,11 +31,12 @@ namespace Strontium
     , indices(nullptr)
   {
     glGenVertexArrays(1, &this->arrayID);
-  	glBindVertexArray(this->arrayID);
+  	StateCache::bindVertexArray(this->arrayID);
   }
 
   VertexArray::~VertexArray()
   {
+    StateCache::forgetVertexArray(this->arrayID);
     glDeleteVertexArrays(1, &this->arrayID);
   }
 
@@ -42,7 +44,7 @@ namespace Strontium
   void
   VertexArray::bind()
   {
-    glBindVertexArray(this->arrayID);
+    StateCache::bindVertexArray(this->arrayID);
     if (this->data != nullptr)
       this->data->bind();
     if (this->indices != nullptr)
@@ -53,7 +55,7 @@ namespace Strontium
   void
   VertexArray::unbind()
   {
-    glBindVertexArray(0);
+    StateCache::bindVertexArray(0);
     if (this->data != nullptr)
       this->data->unbind();
     if (this->indices != nullptr)
@@ -99,6 +101,36 @@ namespace Strontium
         glVertexAttribIPointer(location, 2, GL_INT, size, (void*) (unsigned long) stride);
         break;
       }
+      case AttribType::UVec4:
+      {
+        glVertexAttribIPointer(location, 4, GL_UNSIGNED_INT, size, (void*) (unsigned long) stride);
+        break;
+      }
+      case AttribType::Short2:
+      {
+        glVertexAttribPointer(location, 2, GL_SHORT, glNormalized, size, (void*) (unsigned long) stride);
+        break;
+      }
+      case AttribType::Half2:
+      {
+        glVertexAttribPointer(location, 2, GL_HALF_FLOAT, glNormalized, size, (void*) (unsigned long) stride);
+        break;
+      }
+      case AttribType::Int2101010:
+      {
+        glVertexAttribPointer(location, 4, GL_INT_2_10_10_10_REV, glNormalized, size, (void*) (unsigned long) stride);
+        break;
+      }
+      case AttribType::UByte4:
+      {
+        glVertexAttribPointer(location, 4, GL_UNSIGNED_BYTE, glNormalized, size, (void*) (unsigned long) stride);
+        break;
+      }
+      case AttribType::IUByte4:
+      {
+        glVertexAttribIPointer(location, 4, GL_UNSIGNED_BYTE, size, (void*) (unsigned long) stride);
+        break;
+      }
     }
 
 		glEnableVertexAttribArray(location);
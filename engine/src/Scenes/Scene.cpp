@@ -1,8 +1,11 @@
 #include "Scenes/Scene.h"
 
 // Project includes.
+#include "Core/TaskGraph.h"
+#include "Core/ThreadPool.h"
 #include "Scenes/Components.h"
 #include "Scenes/Entity.h"
+#include "Utils/AsyncAssetLoading.h"
 
 namespace Strontium
 {
@@ -11,7 +14,10 @@ namespace Strontium
   { }
 
   Scene::~Scene()
-  { }
+  {
+    // Loads still in flight would be attached to a dead scene.
+    AsyncLoading::cancelSceneLoads(this);
+  }
 
   Entity
   Scene::createEntity(const std::string& name)
@@ -76,26 +82,35 @@ namespace Strontium
   void
   Scene::onUpdateRuntime(float dt)
   {
-    this->updateAnimations(dt);
-
+    // Looked up before fanning out, creating the group isn't thread safe.
     auto ambLight = this->sceneECS.group<AmbientComponent>(entt::get<TransformComponent>);
-    for (auto entity : ambLight)
-    {
-      auto [ambient, transform] = ambLight.get<AmbientComponent, TransformComponent>(entity);
 
-      if (ambient.animate)
+    // The animators and the ambient lights touch different components, so
+    // they update side by side. Everything has finished once execute()
+    // returns, before the scene is submitted to the renderer.
+    TaskGraph updateGraph;
+    updateGraph.addTask([this, dt]() { this->updateAnimations(dt); });
+    updateGraph.addTask([&ambLight, dt]()
+    {
+      for (auto entity : ambLight)
       {
-        transform.rotation.z += glm::radians(ambient.animationSpeed) * dt;
-        if (transform.rotation.z > glm::radians(360.0f))
-        {
-          transform.rotation.z = 0.0f;
-        }
-        if (transform.rotation.z < glm::radians(-360.0f))
+        auto [ambient, transform] = ambLight.get<AmbientComponent, TransformComponent>(entity);
+
+        if (ambient.animate)
         {
-          transform.rotation.z = 0.0f;
+          transform.rotation.z += glm::radians(ambient.animationSpeed) * dt;
+          if (transform.rotation.z > glm::radians(360.0f))
+          {
+            transform.rotation.z = 0.0f;
+          }
+          if (transform.rotation.z < glm::radians(-360.0f))
+          {
+            transform.rotation.z = 0.0f;
+          }
         }
       }
-    }
+    });
+    updateGraph.execute(ThreadPool::getInstance());
   }
 
   void
@@ -173,6 +188,7 @@ namespace Strontium
     }
 
     // Group together the transform and renderable components.
+    uint numBounded = 0;
     auto drawables = this->sceneECS.group<RenderableComponent>(entt::get<TransformComponent>);
     for (auto entity : drawables)
     {
@@ -186,6 +202,12 @@ namespace Strontium
       if (currentEntity.hasComponent<ParentEntityComponent>())
         transformMatrix = computeGlobalTransform(currentEntity);
 
+      if (renderable)
+      {
+        this->updateBounds(entity, renderable, transformMatrix);
+        numBounded++;
+      }
+
       bool selected = entity == selectedEntity;
 
       // Submit the mesh + material + transform to the static deferred renderer queue.
@@ -197,6 +219,8 @@ namespace Strontium
         Renderer3D::submit(renderable, &renderable.animator, renderable,
                            transformMatrix, static_cast<float>(entity), selected);
     }
+
+    this->commitBounds(numBounded);
   }
 
   void
@@ -274,6 +298,7 @@ namespace Strontium
     }
 
     // Group together the transform and renderable components.
+    uint numBounded = 0;
     auto drawables = this->sceneECS.group<RenderableComponent>(entt::get<TransformComponent>);
     for (auto entity : drawables)
     {
@@ -287,6 +312,12 @@ namespace Strontium
       if (currentEntity.hasComponent<ParentEntityComponent>())
         transformMatrix = computeGlobalTransform(currentEntity);
 
+      if (renderable)
+      {
+        this->updateBounds(entity, renderable, transformMatrix);
+        numBounded++;
+      }
+
       // Submit the mesh + material + transform to the static deferred renderer queue.
       if (renderable && !renderable.animator.animationRenderable())
         Renderer3D::submit(renderable, renderable, transformMatrix,
@@ -296,6 +327,43 @@ namespace Strontium
         Renderer3D::submit(renderable, &renderable.animator, renderable,
                            transformMatrix, static_cast<float>(entity));
     }
+
+    this->commitBounds(numBounded);
+  }
+
+  void
+  Scene::updateBounds(entt::entity entity, Model* model, const glm::mat4 &transform)
+  {
+    auto box = buildBoundingBox(model->getMinPos(), model->getMaxPos(),
+                                transform * model->getGlobalTransform());
+    this->renderableBVH.insert(static_cast<uint>(entity), box.center - box.extents,
+                               box.center + box.extents);
+  }
+
+  void
+  Scene::commitBounds(uint numBounded)
+  {
+    // Anything in the BVH which wasn't bounded this frame has been deleted,
+    // lost a component or had its model unloaded.
+    if (this->renderableBVH.size() > numBounded)
+    {
+      // Copied, since removing reorders the IDs.
+      std::vector<uint> boundedIDs = this->renderableBVH.getIDs();
+      for (uint id : boundedIDs)
+      {
+        auto entity = static_cast<entt::entity>(id);
+        if (!this->sceneECS.valid(entity)
+            || !this->sceneECS.has<RenderableComponent, TransformComponent>(entity)
+            || !this->sceneECS.get<RenderableComponent>(entity))
+          this->renderableBVH.remove(id);
+      }
+    }
+
+    this->renderableBVH.commit();
+
+    glm::vec3 min, max;
+    if (this->renderableBVH.getBounds(min, max))
+      Renderer3D::submitSceneBounds(min, max);
   }
 
   Entity
@@ -355,12 +423,16 @@ namespace Strontium
   void
   Scene::updateAnimations(float dt)
   {
-    // Get all the renderable components to update animations.
+    // Get all the renderable components to update animations. Each animator
+    // only writes to its own bone transforms, so they're updated in parallel.
     auto renderables = this->sceneECS.view<RenderableComponent>();
-    for (auto entity : renderables)
+    std::vector<entt::entity> animated(renderables.begin(), renderables.end());
+
+    auto workerGroup = ThreadPool::getInstance();
+    workerGroup->parallelFor(0, animated.size(), 8, [&renderables, &animated, dt](uint i)
     {
-      auto& renderable = renderables.get<RenderableComponent>(entity);
+      auto& renderable = renderables.get<RenderableComponent>(animated[i]);
       renderable.animator.onUpdate(dt);
-    }
+    });
   }
 }
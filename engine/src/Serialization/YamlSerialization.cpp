@@ -477,6 +477,13 @@ namespace Strontium
       out << YAML::Key << "BasicSettings";
       out << YAML::BeginMap;
       out << YAML::Key << "FrustumCull" << YAML::Value << state->frustumCull;
+      out << YAML::Key << "PackedVertices" << YAML::Value << state->packedVertices;
+      out << YAML::Key << "LODErrorThreshold" << YAML::Value << state->lodErrorThreshold;
+      out << YAML::Key << "MeshletCull" << YAML::Value << state->meshletCull;
+      out << YAML::Key << "MeshletConeCull" << YAML::Value << state->meshletConeCull;
+      out << YAML::Key << "IndirectDraws" << YAML::Value << state->indirectDraws;
+      out << YAML::Key << "Instancing" << YAML::Value << state->instancing;
+      out << YAML::Key << "SortRenderQueue" << YAML::Value << state->sortRenderQueue;
       out << YAML::Key << "UseFXAA" << YAML::Value << state->enableFXAA;
       out << YAML::EndMap;
 
@@ -549,6 +556,73 @@ namespace Strontium
       output.close();
     }
 
+    void
+    serializeHistogram(YAML::Emitter &out, const std::string &name,
+                       const JobTimeHistogram &histogram)
+    {
+      out << YAML::Key << name << YAML::Value << YAML::BeginMap;
+      out << YAML::Key << "NumSamples" << YAML::Value << histogram.numSamples;
+      out << YAML::Key << "MeanMicroseconds" << YAML::Value << histogram.getMeanMicroseconds();
+      out << YAML::Key << "MaxMicroseconds" << YAML::Value << histogram.maxMicroseconds;
+
+      // Bucket i holds samples below 2^i microseconds.
+      out << YAML::Key << "Buckets" << YAML::Value << YAML::Flow << YAML::BeginSeq;
+      for (auto bucket : histogram.buckets)
+        out << bucket;
+      out << YAML::EndSeq;
+
+      out << YAML::EndMap;
+    }
+
+    void
+    serializeThreadPoolStats(const ThreadPoolStats &stats, const std::string &filepath)
+    {
+      YAML::Emitter out;
+      out << YAML::BeginMap;
+      out << YAML::Key << "ThreadPoolStats" << YAML::Value << YAML::BeginMap;
+
+      out << YAML::Key << "ElapsedSeconds" << YAML::Value << stats.elapsedSeconds;
+      out << YAML::Key << "NumQueued" << YAML::Value << stats.numQueued;
+      out << YAML::Key << "NumQueuedCPU" << YAML::Value << stats.numQueuedCPU;
+      out << YAML::Key << "NumQueuedIO" << YAML::Value << stats.numQueuedIO;
+      out << YAML::Key << "NumRunning" << YAML::Value << stats.numRunning;
+      out << YAML::Key << "NumSubmitted" << YAML::Value << stats.numSubmitted;
+      out << YAML::Key << "NumCompleted" << YAML::Value << stats.numCompleted;
+      out << YAML::Key << "NumCancelled" << YAML::Value << stats.numCancelled;
+
+      serializeHistogram(out, "WaitTimes", stats.waitTimes);
+      serializeHistogram(out, "ExecTimes", stats.execTimes);
+
+      out << YAML::Key << "Workers" << YAML::Value << YAML::BeginSeq;
+      for (auto& worker : stats.workers)
+      {
+        out << YAML::BeginMap;
+        out << YAML::Key << "Lane" << YAML::Value << (worker.lane == JobLane::IO ? "IO" : "CPU");
+        out << YAML::Key << "NumCompleted" << YAML::Value << worker.numCompleted;
+        out << YAML::Key << "Utilisation" << YAML::Value << worker.utilisation;
+        out << YAML::EndMap;
+      }
+      out << YAML::EndSeq;
+
+      out << YAML::Key << "Labels" << YAML::Value << YAML::BeginMap;
+      for (auto& [label, labelStats] : stats.labels)
+      {
+        out << YAML::Key << label << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "NumCompleted" << YAML::Value << labelStats.numCompleted;
+        out << YAML::Key << "TotalWaitMicroseconds" << YAML::Value << labelStats.totalWaitMicroseconds;
+        out << YAML::Key << "TotalExecMicroseconds" << YAML::Value << labelStats.totalExecMicroseconds;
+        out << YAML::EndMap;
+      }
+      out << YAML::EndMap;
+
+      out << YAML::EndMap;
+      out << YAML::EndMap;
+
+      std::ofstream output(filepath, std::ofstream::trunc | std::ofstream::out);
+      output << out.c_str();
+      output.close();
+    }
+
     void
     deserializeMaterial(YAML::Node &mat, std::vector<std::string> &texturePaths,
                         bool override = false, const std::string &filepath = "")
@@ -949,6 +1023,20 @@ namespace Strontium
         if (basicSettings)
         {
           state->frustumCull = basicSettings["FrustumCull"].as<bool>();
+          if (basicSettings["PackedVertices"])
+            state->packedVertices = basicSettings["PackedVertices"].as<bool>();
+          if (basicSettings["LODErrorThreshold"])
+            state->lodErrorThreshold = basicSettings["LODErrorThreshold"].as<float>();
+          if (basicSettings["MeshletCull"])
+            state->meshletCull = basicSettings["MeshletCull"].as<bool>();
+          if (basicSettings["MeshletConeCull"])
+            state->meshletConeCull = basicSettings["MeshletConeCull"].as<bool>();
+          if (basicSettings["IndirectDraws"])
+            state->indirectDraws = basicSettings["IndirectDraws"].as<bool>();
+          if (basicSettings["Instancing"])
+            state->instancing = basicSettings["Instancing"].as<bool>();
+          if (basicSettings["SortRenderQueue"])
+            state->sortRenderQueue = basicSettings["SortRenderQueue"].as<bool>();
           state->enableFXAA = basicSettings["UseFXAA"].as<bool>();
         }
 
@@ -3,6 +3,7 @@
 // Project includes.
 #include "Core/Events.h"
 #include "Core/ThreadPool.h"
+#include "Core/MPSCQueue.h"
 #include "Graphics/Material.h"
 #include "Scenes/Entity.h"
 #include "Scenes/Components.h"
@@ -22,26 +23,40 @@ namespace Strontium
     //--------------------------------------------------------------------------
     // Models, materials and meshes.
     //--------------------------------------------------------------------------
-    std::queue<std::tuple<Model*, Scene*, uint>> asyncModelQueue;
-    std::mutex asyncModelMutex;
+    // Loaded models waiting to be attached to their scene, along with the load
+    // group so cancelled loads can be skipped. Filled by the loaders and only
+    // drained on the main thread.
+    MPSCQueue<std::tuple<Model*, Scene*, uint, Shared<JobGroup>>> asyncModelQueue(256);
+
+    // The job group for the model loads of each scene.
+    std::unordered_map<Scene*, Shared<JobGroup>> sceneLoadGroups;
+    std::mutex sceneLoadMutex;
+
+    // Attach a texture to a material sampler and request it. Textures are
+    // keyed by their filename in the cache.
+    static void
+    attachTexture(Material* material, const std::string &samplerName,
+                  const std::string &texturePath)
+    {
+      std::string texName = texturePath.substr(texturePath.find_last_of('/') + 1);
+      material->attachSampler2D(samplerName, texName);
+
+      if (!AssetManager<Texture2D>::getManager()->hasAsset(texName))
+        requestTexture(texturePath);
+    }
 
     void
     bulkGenerateMaterials()
     {
-      // This occasionally segfaults... TODO: Figure out a better solution.
-      std::lock_guard<std::mutex> modelGuard(asyncModelMutex);
-
-      Logger* logs = Logger::getInstance();
-      auto textureCache = AssetManager<Texture2D>::getManager();
+      std::tuple<Model*, Scene*, uint, Shared<JobGroup>> loadedModel;
+      while (asyncModelQueue.tryPop(loadedModel))
+      {
+        auto [model, activeScene, entityID, loadGroup] = loadedModel;
 
-      // Filepaths of the textures that need to be loaded.
-      std::vector<std::string> texturesToLoad;
-      // Reserve for the worst case scenario.
-      texturesToLoad.reserve(asyncModelQueue.size() * 6);
+        // The scene was replaced after the model finished loading.
+        if (loadGroup->isCancelled())
+          continue;
 
-      while (!asyncModelQueue.empty())
-      {
-        auto [model, activeScene, entityID] = asyncModelQueue.front();
         Entity entity((entt::entity) entityID, activeScene);
 
         if (entity)
@@ -76,104 +91,43 @@ namespace Strontium
                 materials.attachMesh(submeshName, MaterialType::PBR);
                 auto submeshMaterial = materials.getMaterial(submeshName);
 
-                std::string texName;
                 if (submeshTexturePaths.albedoTexturePath != "")
                 {
                   submeshMaterial->set(glm::vec3(1.0f), "uAlbedo");
-                  texName = submeshTexturePaths.albedoTexturePath.substr(submeshTexturePaths.albedoTexturePath.find_last_of('/') + 1);
-                  submeshMaterial->attachSampler2D("albedoMap", texName);
-
-                  bool shouldLoad = std::find(texturesToLoad.begin(),
-                                              texturesToLoad.end(),
-                                              submeshTexturePaths.albedoTexturePath
-                                              ) == texturesToLoad.end();
-
-                  if (!textureCache->hasAsset(texName) && shouldLoad)
-                    texturesToLoad.emplace_back(submeshTexturePaths.albedoTexturePath);
+                  attachTexture(submeshMaterial, "albedoMap", submeshTexturePaths.albedoTexturePath);
                 }
 
                 if (submeshTexturePaths.roughnessTexturePath != "")
                 {
                   submeshMaterial->set(1.0f, "uRoughness");
-                  texName = submeshTexturePaths.roughnessTexturePath.substr(submeshTexturePaths.roughnessTexturePath.find_last_of('/') + 1);
-                  submeshMaterial->attachSampler2D("roughnessMap", texName);
-
-                  bool shouldLoad = std::find(texturesToLoad.begin(),
-                                              texturesToLoad.end(),
-                                              submeshTexturePaths.roughnessTexturePath
-                                              ) == texturesToLoad.end();
-
-                  if (!textureCache->hasAsset(texName) && shouldLoad)
-                    texturesToLoad.emplace_back(submeshTexturePaths.roughnessTexturePath);
+                  attachTexture(submeshMaterial, "roughnessMap", submeshTexturePaths.roughnessTexturePath);
                 }
 
                 if (submeshTexturePaths.metallicTexturePath != "")
                 {
                   submeshMaterial->set(1.0f, "uMetallic");
-                  texName = submeshTexturePaths.metallicTexturePath.substr(submeshTexturePaths.metallicTexturePath.find_last_of('/') + 1);
-                  submeshMaterial->attachSampler2D("metallicMap", texName);
-
-                  bool shouldLoad = std::find(texturesToLoad.begin(),
-                                              texturesToLoad.end(),
-                                              submeshTexturePaths.metallicTexturePath
-                                              ) == texturesToLoad.end();
-
-                  if (!textureCache->hasAsset(texName) && shouldLoad)
-                    texturesToLoad.emplace_back(submeshTexturePaths.metallicTexturePath);
+                  attachTexture(submeshMaterial, "metallicMap", submeshTexturePaths.metallicTexturePath);
                 }
 
                 if (submeshTexturePaths.aoTexturePath != "")
                 {
                   submeshMaterial->set(1.0f, "uAO");
-                  texName = submeshTexturePaths.aoTexturePath.substr(submeshTexturePaths.aoTexturePath.find_last_of('/') + 1);
-                  submeshMaterial->attachSampler2D("aOcclusionMap", texName);
-
-                  bool shouldLoad = std::find(texturesToLoad.begin(),
-                                              texturesToLoad.end(),
-                                              submeshTexturePaths.aoTexturePath
-                                              ) == texturesToLoad.end();
-
-                  if (!textureCache->hasAsset(texName) && shouldLoad)
-                    texturesToLoad.emplace_back(submeshTexturePaths.aoTexturePath);
+                  attachTexture(submeshMaterial, "aOcclusionMap", submeshTexturePaths.aoTexturePath);
                 }
 
                 if (submeshTexturePaths.specularTexturePath != "")
                 {
                   submeshMaterial->set(0.04f, "uF0");
-                  texName = submeshTexturePaths.specularTexturePath.substr(submeshTexturePaths.specularTexturePath.find_last_of('/') + 1);
-                  submeshMaterial->attachSampler2D("specF0Map", texName);
-
-                  bool shouldLoad = std::find(texturesToLoad.begin(),
-                                              texturesToLoad.end(),
-                                              submeshTexturePaths.specularTexturePath
-                                              ) == texturesToLoad.end();
-
-                  if (!textureCache->hasAsset(texName) && shouldLoad)
-                    texturesToLoad.emplace_back(submeshTexturePaths.specularTexturePath);
+                  attachTexture(submeshMaterial, "specF0Map", submeshTexturePaths.specularTexturePath);
                 }
 
                 if (submeshTexturePaths.normalTexturePath != "")
-                {
-                  texName = submeshTexturePaths.normalTexturePath.substr(submeshTexturePaths.normalTexturePath.find_last_of('/') + 1);
-                  submeshMaterial->attachSampler2D("normalMap", texName);
-
-                  bool shouldLoad = std::find(texturesToLoad.begin(),
-                                              texturesToLoad.end(),
-                                              submeshTexturePaths.normalTexturePath
-                                              ) == texturesToLoad.end();
-
-                  if (!textureCache->hasAsset(texName) && shouldLoad)
-                    texturesToLoad.emplace_back(submeshTexturePaths.normalTexturePath);
-                }
+                  attachTexture(submeshMaterial, "normalMap", submeshTexturePaths.normalTexturePath);
               }
             }
           }
         }
-        asyncModelQueue.pop();
       }
-
-      for (auto& texturePath : texturesToLoad)
-        loadImageAsync(texturePath);
     }
 
     void
@@ -192,10 +146,21 @@ namespace Strontium
       }
 
       // Fetch the thread pool.
-      auto workerGroup = ThreadPool::getInstance(2);
+      auto workerGroup = ThreadPool::getInstance();
+
+      // Fetch the load group for the scene.
+      Shared<JobGroup> loadGroup;
+      {
+        std::lock_guard<std::mutex> groupGuard(sceneLoadMutex);
+        auto& sceneGroup = sceneLoadGroups[activeScene];
+        if (!sceneGroup)
+          sceneGroup = createShared<JobGroup>();
+        loadGroup = sceneGroup;
+      }
 
       auto loaderImpl = [](const std::string &filepath, const std::string &name,
-                           uint entityID, Scene* activeScene)
+                           uint entityID, Scene* activeScene,
+                           const Shared<JobGroup> &loadGroup)
       {
         auto modelAssets = AssetManager<Model>::getManager();
 
@@ -203,141 +168,273 @@ namespace Strontium
         if (!modelAssets->hasAsset(name))
         {
           loadable = new Model();
-          loadable->load(filepath);
+          loadable->load(filepath, loadGroup.get());
 
-          modelAssets->attachAsset(name, loadable);
+          // The import was cancelled part way through.
+          if (!loadable->isLoaded())
+          {
+            delete loadable;
+            return;
+          }
 
-          std::lock_guard<std::mutex> imageGuard(asyncModelMutex);
-          asyncModelQueue.push({ loadable, activeScene, entityID });
+          modelAssets->attachAsset(name, loadable);
         }
         else
-        {
           loadable = modelAssets->getAsset(name);
-          std::lock_guard<std::mutex> imageGuard(asyncModelMutex);
-          asyncModelQueue.push({ loadable, activeScene, entityID });
-        }
+
+        // Wait for the main thread to make room if the queue is full. The
+        // main thread skips the model if the load is cancelled after this.
+        auto workerGroup = ThreadPool::getInstance();
+        auto giveUp = [&loadGroup, workerGroup]()
+        {
+          return loadGroup->isCancelled() || workerGroup->isShuttingDown();
+        };
+        asyncModelQueue.push({ loadable, activeScene, entityID, loadGroup }, giveUp);
       };
 
-      workerGroup->push(loaderImpl, filepath, name, entityID, activeScene);
+      // Model imports are mostly mesh processing, keep them on the CPU lane.
+      workerGroup->pushJob({ JobLane::CPU, loadGroup, "Model import" }, loaderImpl, filepath, name,
+                           entityID, activeScene, loadGroup);
+    }
+
+    void
+    cancelSceneLoads(Scene* scene)
+    {
+      std::lock_guard<std::mutex> groupGuard(sceneLoadMutex);
+      auto sceneGroup = sceneLoadGroups.find(scene);
+      if (sceneGroup == sceneLoadGroups.end())
+        return;
+
+      sceneGroup->second->cancel();
+      sceneLoadGroups.erase(sceneGroup);
+
+      // Loads which finished but haven't been attached yet are skipped by
+      // bulkGenerateMaterials() since their group is cancelled.
     }
 
     //--------------------------------------------------------------------------
     // Textures.
     //--------------------------------------------------------------------------
-    std::queue<ImageData2D> asyncTexQueue;
-    std::mutex asyncTexMutex;
+    // The state of every texture which has been requested, keyed by canonical
+    // path. Lets all the materials which share a texture share one decode.
+    std::unordered_map<std::string, TextureLoadState> textureRequests;
+    std::mutex textureRequestMutex;
 
-    void
-    bulkGenerateTextures()
+    static std::string
+    getCanonicalPath(const std::string &filepath)
     {
-      std::lock_guard<std::mutex> imageGuard(asyncTexMutex);
+      std::error_code error;
+      auto canonicalPath = std::filesystem::weakly_canonical(filepath, error);
+      if (error)
+        return std::filesystem::path(filepath).lexically_normal().generic_string();
 
-      Logger* logs = Logger::getInstance();
-      auto textureCache = AssetManager<Texture2D>::getManager();
+      return canonicalPath.generic_string();
+    }
 
-      while (!asyncTexQueue.empty())
-      {
-        ImageData2D& image = asyncTexQueue.front();
+    static void
+    setTextureState(const std::string &canonicalPath, TextureLoadState state)
+    {
+      std::lock_guard<std::mutex> requestGuard(textureRequestMutex);
+      textureRequests[canonicalPath] = state;
+    }
+
+    TextureLoadState
+    getTextureState(const std::string &filepath)
+    {
+      std::string canonicalPath = getCanonicalPath(filepath);
+
+      std::lock_guard<std::mutex> requestGuard(textureRequestMutex);
+      auto request = textureRequests.find(canonicalPath);
+      return request != textureRequests.end() ? request->second : TextureLoadState::None;
+    }
+
+    // Decoded images waiting on an upload. Filled by the decode jobs and only
+    // drained on the main thread.
+    MPSCQueue<ImageData2D> asyncTexQueue(256);
+    std::atomic<uint64_t> pendingUploadBytes(0);
+
+    // Only touched on the main thread.
+    UploadBudget uploadBudget;
+    float lastUploadMilliseconds = 0.0f;
+    double uploadMillisecondsPerByte = 0.0;
+
+    // Size of the base level of an image once it's uploaded.
+    static uint64_t
+    getImageBytes(const ImageData2D &image)
+    {
+      return static_cast<uint64_t>(image.width) * image.height * image.n
+             * (image.isHDR ? sizeof(float) : sizeof(unsigned char));
+    }
 
-        // Generate a 2D texture. Currently supports both bytes and floating point
-        // HDR images!
-        switch (image.n)
+    // Pick the texture formats for a loaded image. Done on the loading thread
+    // since it may need to expand RGB HDR images to RGBA.
+    static void
+    setImageFormat(ImageData2D &image)
+    {
+      // Currently supports both bytes and floating point HDR images!
+      switch (image.n)
+      {
+        case 1:
         {
-          case 1:
+          if (image.isHDR)
           {
-            if (image.isHDR)
-            {
-              image.params.internal = TextureInternalFormats::R32f;
-              image.params.format = TextureFormats::Red;
-              image.params.dataType = TextureDataType::Floats;
-            }
-            else
-            {
-              image.params.internal = TextureInternalFormats::Red;
-              image.params.format = TextureFormats::Red;
-              image.params.dataType = TextureDataType::Bytes;
-            }
-            break;
+            image.params.internal = TextureInternalFormats::R32f;
+            image.params.format = TextureFormats::Red;
+            image.params.dataType = TextureDataType::Floats;
           }
-
-          case 2:
+          else
           {
-            if (image.isHDR)
-            {
-              image.params.internal = TextureInternalFormats::RG32f;
-              image.params.format = TextureFormats::RG;
-              image.params.dataType = TextureDataType::Floats;
-            }
-            else
-            {
-              image.params.internal = TextureInternalFormats::RG;
-              image.params.format = TextureFormats::RG;
-              image.params.dataType = TextureDataType::Bytes;
-            }
-            break;
+            image.params.internal = TextureInternalFormats::Red;
+            image.params.format = TextureFormats::Red;
+            image.params.dataType = TextureDataType::Bytes;
           }
+          break;
+        }
 
-          case 3:
+        case 2:
+        {
+          if (image.isHDR)
           {
-            // If its HDR, needs to be GL_RGBA16F instead of GL_RGB16F. Thanks OpenGL....
-            if (image.isHDR)
-            {
-              float* dataFNew;
-              dataFNew = new float[image.width * image.height * 4];
-              uint offset = 0;
-
-              for (uint i = 0; i < (image.width * image.height * 4); i+=4)
-              {
-                // Copy over the data from the image loading.
-                dataFNew[i] = ((float*) image.data)[i - offset];
-                dataFNew[i + 1] = ((float*) image.data)[i + 1 - offset];
-                dataFNew[i + 2] = ((float*) image.data)[i + 2 - offset];
-                // Make the 4th component (alpha) equal to 1.0f. Could make this a param :thinking:.
-                dataFNew[i + 3] = 1.0f;
-                // Increment the offset to we don't segfault. :D
-                offset ++;
-              }
+            image.params.internal = TextureInternalFormats::RG32f;
+            image.params.format = TextureFormats::RG;
+            image.params.dataType = TextureDataType::Floats;
+          }
+          else
+          {
+            image.params.internal = TextureInternalFormats::RG;
+            image.params.format = TextureFormats::RG;
+            image.params.dataType = TextureDataType::Bytes;
+          }
+          break;
+        }
 
-              image.n = 4;
-              image.params.internal = TextureInternalFormats::RGBA32f;
-              image.params.format = TextureFormats::RGBA;
-              image.params.dataType = TextureDataType::Floats;
+        case 3:
+        {
+          // If its HDR, needs to be GL_RGBA16F instead of GL_RGB16F. Thanks OpenGL....
+          if (image.isHDR)
+          {
+            // Allocated with malloc so stbi_image_free can release it.
+            float* dataFNew;
+            dataFNew = (float*) malloc(sizeof(float) * image.width * image.height * 4);
+            uint offset = 0;
 
-              stbi_image_free(image.data);
-              image.data = dataFNew;
-            }
-            else
+            for (uint i = 0; i < (image.width * image.height * 4); i+=4)
             {
-              image.params.internal = TextureInternalFormats::RGB;
-              image.params.format = TextureFormats::RGB;
-              image.params.dataType = TextureDataType::Bytes;
+              // Copy over the data from the image loading.
+              dataFNew[i] = ((float*) image.data)[i - offset];
+              dataFNew[i + 1] = ((float*) image.data)[i + 1 - offset];
+              dataFNew[i + 2] = ((float*) image.data)[i + 2 - offset];
+              // Make the 4th component (alpha) equal to 1.0f. Could make this a param :thinking:.
+              dataFNew[i + 3] = 1.0f;
+              // Increment the offset to we don't segfault. :D
+              offset ++;
             }
 
-            break;
-          }
+            image.n = 4;
+            image.params.internal = TextureInternalFormats::RGBA32f;
+            image.params.format = TextureFormats::RGBA;
+            image.params.dataType = TextureDataType::Floats;
 
-          case 4:
+            stbi_image_free(image.data);
+            image.data = dataFNew;
+          }
+          else
           {
-            if (image.isHDR)
-            {
-              image.params.internal = TextureInternalFormats::RGBA32f;
-              image.params.format = TextureFormats::RGBA;
-              image.params.dataType = TextureDataType::Floats;
-            }
-            else
-            {
-              image.params.internal = TextureInternalFormats::RGBA;
-              image.params.format = TextureFormats::RGBA;
-              image.params.dataType = TextureDataType::Bytes;
-            }
+            image.params.internal = TextureInternalFormats::RGB;
+            image.params.format = TextureFormats::RGB;
+            image.params.dataType = TextureDataType::Bytes;
+          }
 
-            break;
+          break;
+        }
+
+        case 4:
+        {
+          if (image.isHDR)
+          {
+            image.params.internal = TextureInternalFormats::RGBA32f;
+            image.params.format = TextureFormats::RGBA;
+            image.params.dataType = TextureDataType::Floats;
+          }
+          else
+          {
+            image.params.internal = TextureInternalFormats::RGBA;
+            image.params.format = TextureFormats::RGBA;
+            image.params.dataType = TextureDataType::Bytes;
           }
 
-          default: break;
+          break;
         }
 
-        image.params.minFilter = TextureMinFilterParams::LinearMipMapLinear;
+        default: break;
+      }
+
+      image.params.minFilter = TextureMinFilterParams::LinearMipMapLinear;
+    }
+
+    UploadBudget::UploadBudget(float maxMilliseconds, uint64_t maxBytes)
+      : maxMilliseconds(maxMilliseconds)
+      , maxBytes(maxBytes)
+    { }
+
+    void
+    setUploadBudget(const UploadBudget &budget)
+    {
+      uploadBudget = budget;
+    }
+
+    UploadBudget
+    getUploadBudget()
+    {
+      return uploadBudget;
+    }
+
+    PendingUploads
+    getPendingUploads()
+    {
+      PendingUploads pending;
+      pending.numTextures = asyncTexQueue.size();
+      pending.numBytes = pendingUploadBytes.load();
+      pending.lastFrameMilliseconds = lastUploadMilliseconds;
+      return pending;
+    }
+
+    void
+    bulkGenerateTextures()
+    {
+      Logger* logs = Logger::getInstance();
+      auto textureCache = AssetManager<Texture2D>::getManager();
+
+      auto startTime = std::chrono::steady_clock::now();
+      auto getElapsed = [&startTime]()
+      {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now()
+                                                        - startTime).count();
+      };
+
+      // Upload until the budget runs out. The first texture always goes
+      // through so a texture bigger than the budget still gets loaded.
+      uint numUploaded = 0;
+      uint64_t uploadedBytes = 0;
+      while (true)
+      {
+        ImageData2D* nextImage = asyncTexQueue.peek();
+        if (!nextImage)
+          break;
+
+        uint64_t imageBytes = getImageBytes(*nextImage);
+        float predictedMilliseconds = static_cast<float>(imageBytes * uploadMillisecondsPerByte);
+        if (numUploaded > 0
+            && (getElapsed() + predictedMilliseconds > uploadBudget.maxMilliseconds
+                || uploadedBytes + imageBytes > uploadBudget.maxBytes))
+          break;
+
+        ImageData2D image;
+        asyncTexQueue.tryPop(image);
+        pendingUploadBytes.fetch_sub(imageBytes);
+
+        auto uploadStart = std::chrono::steady_clock::now();
+
         Texture2D* outTex = new Texture2D(image.width, image.height, image.n, image.params);
         outTex->bind();
         outTex->getFilepath() = image.filepath;
@@ -349,6 +446,7 @@ namespace Strontium
         outTex->generateMips();
 
         textureCache->attachAsset(image.name, outTex);
+        setTextureState(getCanonicalPath(image.filepath), TextureLoadState::Ready);
 
         logs->logMessage(LogMessage("Loaded texture: " + image.name + " " +
                                     "(W: " + std::to_string(image.width) + ", H: " +
@@ -356,12 +454,27 @@ namespace Strontium
                                     + std::to_string(image.n) + ").", true, true));
 
         stbi_image_free(image.data);
-        asyncTexQueue.pop();
+
+        // Keep a running estimate of the upload cost to predict the next one.
+        double uploadMilliseconds = std::chrono::duration<double, std::milli>(
+          std::chrono::steady_clock::now() - uploadStart).count();
+        double sampleMillisecondsPerByte = uploadMilliseconds / std::max<uint64_t>(imageBytes, 1);
+        uploadMillisecondsPerByte = uploadMillisecondsPerByte == 0.0
+          ? sampleMillisecondsPerByte
+          : 0.8 * uploadMillisecondsPerByte + 0.2 * sampleMillisecondsPerByte;
+
+        numUploaded++;
+        uploadedBytes += imageBytes;
       }
+
+      lastUploadMilliseconds = numUploaded > 0 ? getElapsed() : 0.0f;
     }
 
-    void
-    loadImageAsync(const std::string &filepath, const Texture2DParams &params)
+    // Start loading an image. Images which are already in flight are never
+    // decoded twice, loaded images are only decoded again when reloading.
+    static void
+    startImageLoad(const std::string &filepath, const Texture2DParams &params,
+                   bool reload)
     {
       // Fetch the logs.
       Logger* logs = Logger::getInstance();
@@ -369,21 +482,39 @@ namespace Strontium
       // Fetch the texture cache.
       auto textureCache = AssetManager<Texture2D>::getManager();
 
+      std::filesystem::path fsPath(filepath);
+      std::string canonicalPath = getCanonicalPath(filepath);
+
+      {
+        std::lock_guard<std::mutex> requestGuard(textureRequestMutex);
+        auto& state = textureRequests[canonicalPath];
+
+        if (state == TextureLoadState::Pending || state == TextureLoadState::Loading)
+          return;
+        if (state == TextureLoadState::Ready && !reload
+            && textureCache->hasAsset(fsPath.filename().string()))
+          return;
+
+        state = TextureLoadState::Pending;
+      }
+
       // Check if the file is valid or not.
       std::ifstream test(filepath);
       if (!test)
       {
         logs->logMessage(LogMessage("Error, file " + filepath + " cannot be opened.", true, true));
+        setTextureState(canonicalPath, TextureLoadState::Failed);
         return;
       }
 
-      std::filesystem::path fsPath(filepath);
-      
       // Fetch the thread pool and event dispatcher.
-      auto workerGroup = ThreadPool::getInstance(2);
+      auto workerGroup = ThreadPool::getInstance();
 
-      auto loaderImpl = [](const std::filesystem::path& path, const Texture2DParams &params)
+      auto loaderImpl = [](const std::filesystem::path& path, const Texture2DParams &params,
+                           const std::string &canonicalPath)
       {
+        setTextureState(canonicalPath, TextureLoadState::Loading);
+
         auto eventDispatcher = EventDispatcher::getInstance();
         eventDispatcher->queueEvent(new GuiEvent(GuiEventType::StartSpinnerEvent, path.string()));
 
@@ -406,16 +537,45 @@ namespace Strontium
         if (!outImage.data)
         {
           stbi_image_free(outImage.data);
+          setTextureState(canonicalPath, TextureLoadState::Failed);
+          eventDispatcher->queueEvent(new GuiEvent(GuiEventType::EndSpinnerEvent, ""));
           return;
         }
 
-        std::lock_guard<std::mutex> imageGuard(asyncTexMutex);
-        asyncTexQueue.push(outImage);
+        setImageFormat(outImage);
+
+        // Wait for the main thread to make room if the queue is full. The
+        // image is only moved from if the push succeeds.
+        uint64_t imageBytes = getImageBytes(outImage);
+        pendingUploadBytes.fetch_add(imageBytes);
+        auto workerGroup = ThreadPool::getInstance();
+        auto giveUp = [workerGroup]() { return workerGroup->isShuttingDown(); };
+        if (!asyncTexQueue.push(std::move(outImage), giveUp))
+        {
+          pendingUploadBytes.fetch_sub(imageBytes);
+          stbi_image_free(outImage.data);
+          setTextureState(canonicalPath, TextureLoadState::Failed);
+          return;
+        }
 
         eventDispatcher->queueEvent(new GuiEvent(GuiEventType::EndSpinnerEvent, ""));
       };
 
-      workerGroup->push(loaderImpl, fsPath, params);
+      // Image decoding goes on the IO lane so it can't hold up model imports.
+      workerGroup->pushJob({ JobLane::IO, nullptr, "Image decode" }, loaderImpl, fsPath,
+                           params, canonicalPath);
+    }
+
+    void
+    loadImageAsync(const std::string &filepath, const Texture2DParams &params)
+    {
+      startImageLoad(filepath, params, true);
+    }
+
+    void
+    requestTexture(const std::string &filepath, const Texture2DParams &params)
+    {
+      startImageLoad(filepath, params, false);
     }
   }
 }
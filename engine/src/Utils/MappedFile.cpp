@@ -0,0 +1,122 @@
+#include "Utils/MappedFile.h"
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace Strontium
+{
+  MappedFile::MappedFile()
+    : fileData(nullptr)
+    , fileSize(0)
+#ifdef WIN32
+    , fileHandle(nullptr)
+    , mappingHandle(nullptr)
+#else
+    , fileDescriptor(-1)
+#endif
+  { }
+
+  MappedFile::~MappedFile()
+  {
+    this->close();
+  }
+
+  bool
+  MappedFile::open(const std::string &filepath)
+  {
+    this->close();
+
+#ifdef WIN32
+    HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+      return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+      CloseHandle(file);
+      return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+      CloseHandle(file);
+      return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+      CloseHandle(mapping);
+      CloseHandle(file);
+      return false;
+    }
+
+    this->fileHandle = file;
+    this->mappingHandle = mapping;
+    this->fileData = static_cast<const uint8_t*>(view);
+    this->fileSize = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+    int file = ::open(filepath.c_str(), O_RDONLY);
+    if (file < 0)
+      return false;
+
+    struct stat fileStats;
+    if (fstat(file, &fileStats) != 0 || fileStats.st_size <= 0)
+    {
+      ::close(file);
+      return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<std::size_t>(fileStats.st_size), PROT_READ,
+                      MAP_PRIVATE, file, 0);
+    if (view == MAP_FAILED)
+    {
+      ::close(file);
+      return false;
+    }
+
+    // Files are read front to back, let the kernel read ahead.
+    madvise(view, static_cast<std::size_t>(fileStats.st_size), MADV_SEQUENTIAL);
+
+    this->fileDescriptor = file;
+    this->fileData = static_cast<const uint8_t*>(view);
+    this->fileSize = static_cast<std::size_t>(fileStats.st_size);
+#endif
+
+    return true;
+  }
+
+  void
+  MappedFile::close()
+  {
+    if (!this->fileData)
+      return;
+
+#ifdef WIN32
+    UnmapViewOfFile(this->fileData);
+    CloseHandle(this->mappingHandle);
+    CloseHandle(this->fileHandle);
+    this->fileHandle = nullptr;
+    this->mappingHandle = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(this->fileData), this->fileSize);
+    ::close(this->fileDescriptor);
+    this->fileDescriptor = -1;
+#endif
+
+    this->fileData = nullptr;
+    this->fileSize = 0;
+  }
+}
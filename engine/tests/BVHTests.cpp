@@ -0,0 +1,474 @@
+#include "Testing.h"
+
+// Project includes.
+#include "Core/BVH.h"
+
+// STL includes.
+#include <random>
+
+namespace Strontium
+{
+  namespace
+  {
+    struct TestBox
+    {
+      glm::vec3 min;
+      glm::vec3 max;
+    };
+
+    // The boxes the tree should hold, checked by brute force.
+    using TestScene = std::unordered_map<uint, TestBox>;
+
+    TestBox
+    randomBox(std::mt19937 &generator, float worldSize, float maxExtent)
+    {
+      std::uniform_real_distribution<float> position(-worldSize, worldSize);
+      std::uniform_real_distribution<float> extent(0.0f, maxExtent);
+
+      glm::vec3 center(position(generator), position(generator), position(generator));
+      glm::vec3 extents(extent(generator), extent(generator), extent(generator));
+      return { center - extents, center + extents };
+    }
+
+    TestBox
+    movedBox(const TestBox &box, const glm::vec3 &offset)
+    {
+      return { box.min + offset, box.max + offset };
+    }
+
+    glm::vec3
+    randomDirection(std::mt19937 &generator)
+    {
+      std::uniform_real_distribution<float> component(-1.0f, 1.0f);
+      glm::vec3 direction(component(generator), component(generator), component(generator));
+      return glm::normalize(direction + glm::vec3(1e-3f, 0.0f, 0.0f));
+    }
+
+    Frustum
+    cameraFrustum(const glm::vec3 &eye, const glm::vec3 &front, float farPlane)
+    {
+      glm::mat4 view = glm::lookAt(eye, eye + front, glm::vec3(0.0f, 1.0f, 0.0f));
+      glm::mat4 proj = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, farPlane);
+      return buildCameraFrustum(proj * view, front);
+    }
+
+    Frustum
+    randomFrustum(std::mt19937 &generator, float worldSize)
+    {
+      std::uniform_real_distribution<float> position(-worldSize, worldSize);
+      std::uniform_real_distribution<float> farPlane(worldSize * 0.1f, worldSize);
+
+      glm::vec3 eye(position(generator), position(generator), position(generator));
+      return cameraFrustum(eye, randomDirection(generator), farPlane(generator));
+    }
+
+    // Brute force versions of the queries, with the same math as the tree.
+    std::vector<uint>
+    scanFrustum(const TestScene &scene, const Frustum &frustum)
+    {
+      std::vector<uint> ids;
+      for (auto& [id, box] : scene)
+      {
+        BoundingBox bounds = buildBoundingBox(box.min, box.max);
+        bool inFrustum = true;
+        for (uint p = 0; p < 6; p++)
+          inFrustum = inFrustum && boundingBoxOnPlane(frustum.sides[p], bounds);
+
+        if (inFrustum)
+          ids.push_back(id);
+      }
+
+      std::sort(ids.begin(), ids.end());
+      return ids;
+    }
+
+    std::vector<uint>
+    scanSphere(const TestScene &scene, const glm::vec3 &center, float radius)
+    {
+      std::vector<uint> ids;
+      for (auto& [id, box] : scene)
+      {
+        float distance2 = 0.0f;
+        for (uint i = 0; i < 3; i++)
+        {
+          const float d = std::max(std::max(box.min[i] - center[i], 0.0f), center[i] - box.max[i]);
+          distance2 += d * d;
+        }
+
+        if (distance2 <= radius * radius)
+          ids.push_back(id);
+      }
+
+      std::sort(ids.begin(), ids.end());
+      return ids;
+    }
+
+    std::vector<BVHRayHit>
+    scanRay(const TestScene &scene, const glm::vec3 &origin, const glm::vec3 &direction,
+            float maxDistance)
+    {
+      const glm::vec3 invDirection = 1.0f / direction;
+
+      std::vector<BVHRayHit> hits;
+      for (auto& [id, box] : scene)
+      {
+        float tNear = 0.0f;
+        float tFar = maxDistance;
+        for (uint i = 0; i < 3; i++)
+        {
+          const float t1 = (box.min[i] - origin[i]) * invDirection[i];
+          const float t2 = (box.max[i] - origin[i]) * invDirection[i];
+          tNear = std::max(tNear, std::min(t1, t2));
+          tFar = std::min(tFar, std::max(t1, t2));
+        }
+
+        if (tNear <= tFar)
+          hits.push_back({ id, tNear });
+      }
+
+      return hits;
+    }
+
+    // Hits at the same distance can come back in any order.
+    void
+    sortHits(std::vector<BVHRayHit> &hits)
+    {
+      std::sort(hits.begin(), hits.end(), [](const BVHRayHit &a, const BVHRayHit &b)
+      {
+        return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+      });
+    }
+
+    bool
+    sameHits(const std::vector<BVHRayHit> &a, const std::vector<BVHRayHit> &b)
+    {
+      if (a.size() != b.size())
+        return false;
+
+      for (uint i = 0; i < a.size(); i++)
+      {
+        if (a[i].id != b[i].id || a[i].distance != b[i].distance)
+          return false;
+      }
+
+      return true;
+    }
+
+    // Runs one query of every kind against the tree and the scan.
+    void
+    checkQueries(const BVH &bvh, const TestScene &scene, const Frustum &frustum,
+                 const glm::vec3 &center, float radius, const glm::vec3 &origin,
+                 const glm::vec3 &direction, float maxDistance)
+    {
+      std::vector<uint> ids;
+      bvh.queryFrustum(frustum, ids);
+      std::sort(ids.begin(), ids.end());
+      SR_CHECK(ids == scanFrustum(scene, frustum));
+
+      ids.clear();
+      bvh.querySphere(center, radius, ids);
+      std::sort(ids.begin(), ids.end());
+      SR_CHECK(ids == scanSphere(scene, center, radius));
+
+      std::vector<BVHRayHit> expected = scanRay(scene, origin, direction, maxDistance);
+      std::vector<BVHRayHit> hits;
+      bvh.queryRay(origin, direction, maxDistance, hits);
+      bool nearestFirst = true;
+      for (uint i = 1; i < hits.size(); i++)
+        nearestFirst = nearestFirst && hits[i - 1].distance <= hits[i].distance;
+      SR_CHECK(nearestFirst);
+
+      sortHits(hits);
+      sortHits(expected);
+      SR_CHECK(sameHits(hits, expected));
+
+      BVHRayHit nearest;
+      bool hit = bvh.raycast(origin, direction, maxDistance, nearest);
+      SR_CHECK(hit == !expected.empty());
+      if (hit && !expected.empty())
+      {
+        SR_CHECK(nearest.distance == expected[0].distance);
+        SR_CHECK(scene.count(nearest.id) == 1);
+      }
+    }
+
+    // Random queries through the whole world, then small ones aimed at the
+    // given boxes, which would miss them if their nodes weren't refit.
+    void
+    checkQueries(const BVH &bvh, const TestScene &scene, std::mt19937 &generator,
+                 float worldSize, const std::vector<uint> &focusIDs = {})
+    {
+      std::uniform_real_distribution<float> position(-worldSize, worldSize);
+      std::uniform_real_distribution<float> radius(0.0f, worldSize * 0.3f);
+
+      SR_CHECK(bvh.size() == scene.size());
+      for (uint query = 0; query < 20; query++)
+      {
+        Frustum frustum = randomFrustum(generator, worldSize);
+        glm::vec3 center(position(generator), position(generator), position(generator));
+        float r = radius(generator);
+        glm::vec3 origin(position(generator), position(generator), position(generator));
+        glm::vec3 direction = randomDirection(generator) * (query % 2 == 0 ? 1.0f : 3.0f);
+        float maxDistance = query % 3 == 0 ? std::numeric_limits<float>::max() : worldSize;
+        checkQueries(bvh, scene, frustum, center, r, origin, direction, maxDistance);
+      }
+
+      for (uint id : focusIDs)
+      {
+        const TestBox &box = scene.at(id);
+        glm::vec3 center = (box.min + box.max) / 2.0f;
+        glm::vec3 direction = randomDirection(generator);
+        glm::vec3 origin = center - direction * 20.0f;
+        checkQueries(bvh, scene, cameraFrustum(origin, direction, 25.0f), center, 0.5f,
+                     origin, direction, 40.0f);
+      }
+    }
+
+    void
+    fillScene(BVH &bvh, TestScene &scene, uint numBoxes, std::mt19937 &generator,
+              float worldSize, float maxExtent)
+    {
+      for (uint i = 0; i < numBoxes; i++)
+      {
+        // Sparse IDs, like entity handles.
+        uint id = i * 3 + 7;
+        scene[id] = randomBox(generator, worldSize, maxExtent);
+        bvh.insert(id, scene[id].min, scene[id].max);
+      }
+    }
+  }
+
+  SR_TEST(BVH, queriesMatchScanAfterBuild)
+  {
+    constexpr float worldSize = 100.0f;
+    std::mt19937 generator(1);
+
+    // Sizes around the leaf size, then a real tree.
+    for (uint numBoxes : { 1u, 3u, 4u, 5u, 17u, 5000u })
+    {
+      BVH bvh;
+      TestScene scene;
+      fillScene(bvh, scene, numBoxes, generator, worldSize, 5.0f);
+      SR_CHECK(bvh.commit());
+      checkQueries(bvh, scene, generator, worldSize);
+    }
+  }
+
+  SR_TEST(BVH, queriesMatchScanAfterRefit)
+  {
+    constexpr float worldSize = 100.0f;
+    std::mt19937 generator(2);
+    std::uniform_real_distribution<float> jitter(-2.0f, 2.0f);
+
+    BVH bvh;
+    TestScene scene;
+    fillScene(bvh, scene, 5000, generator, worldSize, 5.0f);
+    bvh.commit();
+
+    // A few boxes moved well out of their nodes, refit along their paths to
+    // the root.
+    std::vector<uint> ids = bvh.getIDs();
+    std::vector<uint> movedIDs;
+    for (uint i = 0; i < 50; i++)
+    {
+      uint id = ids[(i * 97) % ids.size()];
+      scene[id] = movedBox(scene[id], 20.0f * randomDirection(generator));
+      bvh.insert(id, scene[id].min, scene[id].max);
+      movedIDs.push_back(id);
+    }
+    SR_CHECK(!bvh.commit());
+    checkQueries(bvh, scene, generator, worldSize, movedIDs);
+
+    // Everything jittered, refit in one pass.
+    for (uint id : ids)
+    {
+      scene[id] = movedBox(scene[id], glm::vec3(jitter(generator), jitter(generator), jitter(generator)));
+      bvh.insert(id, scene[id].min, scene[id].max);
+    }
+    bvh.commit();
+    checkQueries(bvh, scene, generator, worldSize, movedIDs);
+
+    // Everything scattered somewhere else. The refit tree is far worse than
+    // a fresh one, so it has to be rebuilt.
+    for (uint id : ids)
+    {
+      scene[id] = randomBox(generator, worldSize, 5.0f);
+      bvh.insert(id, scene[id].min, scene[id].max);
+    }
+    SR_CHECK(bvh.commit());
+    checkQueries(bvh, scene, generator, worldSize, movedIDs);
+  }
+
+  SR_TEST(BVH, queriesMatchScanAfterEdits)
+  {
+    constexpr float worldSize = 100.0f;
+    std::mt19937 generator(3);
+
+    BVH bvh;
+    TestScene scene;
+    fillScene(bvh, scene, 3000, generator, worldSize, 5.0f);
+    bvh.commit();
+
+    // Remove every tenth box, add some new ones and move others, all in
+    // one commit.
+    std::vector<uint> ids = bvh.getIDs();
+    for (uint i = 0; i < ids.size(); i += 10)
+    {
+      bvh.remove(ids[i]);
+      scene.erase(ids[i]);
+    }
+    for (uint i = 0; i < 150; i++)
+    {
+      uint id = 100000 + i;
+      scene[id] = randomBox(generator, worldSize, 5.0f);
+      bvh.insert(id, scene[id].min, scene[id].max);
+    }
+    std::vector<uint> movedIDs = { 100000, 100149 };
+    for (uint i = 5; i < ids.size(); i += 10)
+    {
+      scene[ids[i]] = randomBox(generator, worldSize, 5.0f);
+      bvh.insert(ids[i], scene[ids[i]].min, scene[ids[i]].max);
+      movedIDs.push_back(ids[i]);
+    }
+    SR_CHECK(bvh.commit());
+
+    SR_CHECK(!bvh.contains(ids[0]) && bvh.contains(ids[1]) && bvh.contains(100000));
+    checkQueries(bvh, scene, generator, worldSize, movedIDs);
+
+    // Removing something that isn't there changes nothing.
+    bvh.remove(ids[0]);
+    SR_CHECK(bvh.size() == scene.size());
+  }
+
+  SR_TEST(BVH, boundsAndClear)
+  {
+    std::mt19937 generator(4);
+
+    BVH bvh;
+    glm::vec3 min, max;
+    SR_CHECK(!bvh.getBounds(min, max));
+
+    TestScene scene;
+    fillScene(bvh, scene, 1000, generator, 50.0f, 3.0f);
+    bvh.commit();
+
+    glm::vec3 expectedMin(std::numeric_limits<float>::max());
+    glm::vec3 expectedMax(-std::numeric_limits<float>::max());
+    for (auto& [id, box] : scene)
+    {
+      expectedMin = glm::min(expectedMin, box.min);
+      expectedMax = glm::max(expectedMax, box.max);
+    }
+    SR_CHECK(bvh.getBounds(min, max));
+    SR_CHECK(min == expectedMin && max == expectedMax);
+
+    bvh.clear();
+    SR_CHECK(bvh.size() == 0 && !bvh.contains(7));
+    SR_CHECK(!bvh.getBounds(min, max));
+
+    std::vector<uint> ids;
+    bvh.querySphere(glm::vec3(0.0f), 1000.0f, ids);
+    BVHRayHit hit;
+    SR_CHECK(ids.empty());
+    SR_CHECK(!bvh.raycast(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 1000.0f, hit));
+  }
+
+  // Build, refit and query times at three scene sizes, with the linear scan
+  // for comparison. Boxes are spread so each covers a similar share of the
+  // world at every size.
+  SR_BENCHMARK(BVH, buildRefitQuery)
+  {
+    std::mt19937 generator(5);
+
+    for (uint numBoxes : { 10000u, 100000u, 1000000u })
+    {
+      const float worldSize = 10.0f * std::cbrt(static_cast<float>(numBoxes));
+      std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+
+      BVH bvh;
+      TestScene scene;
+      fillScene(bvh, scene, numBoxes, generator, worldSize, 2.0f);
+
+      auto start = std::chrono::steady_clock::now();
+      bvh.commit();
+      double buildMs = Testing::millisecondsSince(start);
+
+      // Jittered moves don't degrade the tree enough to rebuild, so these
+      // are refits alone.
+      std::vector<uint> ids = bvh.getIDs();
+      double refitMs[2];
+      uint moveStrides[2] = { 100, 1 };
+      for (uint pass = 0; pass < 2; pass++)
+      {
+        for (uint i = 0; i < ids.size(); i += moveStrides[pass])
+        {
+          TestBox &box = scene[ids[i]];
+          box = movedBox(box, glm::vec3(jitter(generator), jitter(generator), jitter(generator)));
+        }
+
+        start = std::chrono::steady_clock::now();
+        for (uint i = 0; i < ids.size(); i += moveStrides[pass])
+        {
+          const TestBox &box = scene[ids[i]];
+          bvh.insert(ids[i], box.min, box.max);
+        }
+        bvh.commit();
+        refitMs[pass] = Testing::millisecondsSince(start);
+      }
+
+      constexpr uint numQueries = 100;
+      std::vector<Frustum> frustums;
+      std::vector<glm::vec3> points;
+      std::vector<glm::vec3> directions;
+      for (uint i = 0; i < numQueries; i++)
+      {
+        frustums.push_back(randomFrustum(generator, worldSize));
+        points.push_back(randomBox(generator, worldSize, 0.0f).min);
+        directions.push_back(randomDirection(generator));
+      }
+
+      std::vector<uint> found;
+      start = std::chrono::steady_clock::now();
+      for (uint i = 0; i < numQueries; i++)
+      {
+        found.clear();
+        bvh.queryFrustum(frustums[i], found);
+      }
+      double frustumMs = Testing::millisecondsSince(start) / numQueries;
+
+      start = std::chrono::steady_clock::now();
+      for (uint i = 0; i < numQueries; i++)
+      {
+        found.clear();
+        bvh.querySphere(points[i], worldSize * 0.05f, found);
+      }
+      double sphereMs = Testing::millisecondsSince(start) / numQueries;
+
+      BVHRayHit hit;
+      uint numHits = 0;
+      start = std::chrono::steady_clock::now();
+      for (uint i = 0; i < numQueries; i++)
+        numHits += bvh.raycast(points[i], directions[i], worldSize * 4.0f, hit) ? 1 : 0;
+      double rayMs = Testing::millisecondsSince(start) / numQueries;
+
+      // The scans walk a hash map, so time them over fewer queries.
+      constexpr uint numScans = 5;
+      start = std::chrono::steady_clock::now();
+      for (uint i = 0; i < numScans; i++)
+        scanFrustum(scene, frustums[i]);
+      double scanFrustumMs = Testing::millisecondsSince(start) / numScans;
+
+      start = std::chrono::steady_clock::now();
+      for (uint i = 0; i < numScans; i++)
+        scanRay(scene, points[i], directions[i], worldSize * 4.0f);
+      double scanRayMs = Testing::millisecondsSince(start) / numScans;
+
+      std::cout << "  " << numBoxes << " boxes: build " << buildMs << " ms, refit 1% "
+                << refitMs[0] << " ms, refit 100% " << refitMs[1] << " ms" << std::endl
+                << "    frustum " << frustumMs << " ms (scan " << scanFrustumMs
+                << " ms), sphere " << sphereMs << " ms, raycast " << rayMs
+                << " ms (scan " << scanRayMs << " ms), " << numHits << "/" << numQueries
+                << " rays hit" << std::endl;
+    }
+  }
+}
@@ -0,0 +1,170 @@
+#include "Testing.h"
+
+// Project includes.
+#include "Graphics/Culling.h"
+
+// STL includes.
+#include <random>
+
+namespace Strontium
+{
+  namespace
+  {
+    // Boxes scattered through a cube around the origin, some of them
+    // degenerate.
+    void
+    fillRandomBounds(CullingBounds &bounds, uint numBounds, uint seed)
+    {
+      std::mt19937 generator(seed);
+      std::uniform_real_distribution<float> position(-300.0f, 300.0f);
+      std::uniform_real_distribution<float> extent(0.0f, 8.0f);
+
+      bounds.resize(numBounds);
+      for (uint i = 0; i < numBounds; i++)
+      {
+        BoundingBox box;
+        box.center = glm::vec3(position(generator), position(generator), position(generator));
+        box.extents = i % 17 == 0 ? glm::vec3(0.0f)
+                                  : glm::vec3(extent(generator), extent(generator), extent(generator));
+        bounds.set(i, box);
+      }
+    }
+
+    // A camera frustum and four orthographic cascades along a light, like
+    // the renderer culls against with shadows on.
+    uint
+    buildTestFrustums(Frustum* frustums)
+    {
+      constexpr uint numCascades = 4;
+
+      const glm::vec3 camPosition(10.0f, 20.0f, 30.0f);
+      const glm::vec3 camFront = glm::normalize(glm::vec3(-0.3f, -0.2f, -1.0f));
+      glm::mat4 camView = glm::lookAt(camPosition, camPosition + camFront, glm::vec3(0.0f, 1.0f, 0.0f));
+      glm::mat4 camProj = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 400.0f);
+      frustums[0] = buildCameraFrustum(camProj * camView, camFront);
+
+      const glm::vec3 lightDir = glm::normalize(glm::vec3(0.4f, -1.0f, 0.3f));
+      float split = 25.0f;
+      for (uint i = 0; i < numCascades; i++)
+      {
+        glm::vec3 center = camPosition + camFront * split;
+        glm::mat4 lightView = glm::lookAt(center - lightDir * 300.0f, center,
+                                          glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 lightProj = glm::ortho(-split, split, -split, split, 0.0f, 600.0f);
+        frustums[i + 1] = buildCameraFrustum(lightProj * lightView, lightDir);
+        split *= 2.5f;
+      }
+
+      return numCascades + 1;
+    }
+
+    // The per-box path the culler replaced.
+    std::vector<uint>
+    linearScan(const CullingBounds &bounds, const Frustum &frustum)
+    {
+      std::vector<uint> visible;
+      for (uint i = 0; i < bounds.size(); i++)
+      {
+        BoundingBox box;
+        box.center = glm::vec3(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+        box.extents = glm::vec3(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]);
+
+        bool inFrustum = true;
+        for (uint p = 0; p < 6; p++)
+          inFrustum = inFrustum && boundingBoxOnPlane(frustum.sides[p], box);
+
+        if (inFrustum)
+          visible.push_back(i);
+      }
+
+      return visible;
+    }
+  }
+
+  // Every chunking, threaded or not, gives the lists a linear scan does.
+  SR_TEST(Culling, matchesLinearScan)
+  {
+    CullingBounds bounds;
+    fillRandomBounds(bounds, 20011, 1);
+
+    Frustum frustums[MAX_CULLING_FRUSTUMS];
+    uint numFrustums = buildTestFrustums(frustums);
+
+    std::vector<uint> expected[MAX_CULLING_FRUSTUMS];
+    for (uint f = 0; f < numFrustums; f++)
+    {
+      expected[f] = linearScan(bounds, frustums[f]);
+      SR_CHECK(!expected[f].empty() && expected[f].size() < bounds.size());
+    }
+
+    FrustumCuller culler;
+    for (uint grainSize : { 1u, 7u, 1000u, 4096u, 100000u })
+    {
+      for (ThreadPool* pool : { static_cast<ThreadPool*>(nullptr), ThreadPool::getInstance() })
+      {
+        culler.cull(bounds, frustums, numFrustums, pool, grainSize);
+        SR_CHECK(culler.getNumFrustums() == numFrustums);
+        for (uint f = 0; f < numFrustums; f++)
+          SR_CHECK(culler.getVisible(f) == expected[f]);
+      }
+    }
+  }
+
+  SR_TEST(Culling, emptyAndAllVisible)
+  {
+    CullingBounds bounds;
+    Frustum frustums[MAX_CULLING_FRUSTUMS];
+    uint numFrustums = buildTestFrustums(frustums);
+
+    FrustumCuller culler;
+    culler.cull(bounds, frustums, numFrustums, ThreadPool::getInstance());
+    for (uint f = 0; f < numFrustums; f++)
+      SR_CHECK(culler.getVisible(f).empty());
+
+    culler.setAllVisible(10, 2);
+    SR_CHECK(culler.getNumFrustums() == 2);
+    SR_CHECK(culler.getVisible(1).size() == 10 && culler.getVisible(1)[9] == 9);
+  }
+
+  // 100k boxes against the camera and four cascades: the per-box path, then
+  // the culler on one thread and across the pool.
+  SR_BENCHMARK(Culling, cull100k)
+  {
+    constexpr uint numBounds = 100000;
+    constexpr uint numRuns = 20;
+
+    CullingBounds bounds;
+    fillRandomBounds(bounds, numBounds, 2);
+    Frustum frustums[MAX_CULLING_FRUSTUMS];
+    uint numFrustums = buildTestFrustums(frustums);
+
+    uint numVisible = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint run = 0; run < numRuns; run++)
+    {
+      for (uint f = 0; f < numFrustums; f++)
+        numVisible += static_cast<uint>(linearScan(bounds, frustums[f]).size());
+    }
+    double linearMs = Testing::millisecondsSince(start) / numRuns;
+
+    FrustumCuller culler;
+    start = std::chrono::steady_clock::now();
+    for (uint run = 0; run < numRuns; run++)
+      culler.cull(bounds, frustums, numFrustums);
+    double serialMs = Testing::millisecondsSince(start) / numRuns;
+
+    auto pool = ThreadPool::getInstance();
+    start = std::chrono::steady_clock::now();
+    for (uint run = 0; run < numRuns; run++)
+      culler.cull(bounds, frustums, numFrustums, pool);
+    double pooledMs = Testing::millisecondsSince(start) / numRuns;
+
+    for (uint f = 0; f < numFrustums; f++)
+      numVisible -= static_cast<uint>(culler.getVisible(f).size()) * numRuns;
+    SR_CHECK(numVisible == 0);
+
+    std::cout << "  per box: " << linearMs << " ms, culler: " << serialMs
+              << " ms (x" << linearMs / serialMs << "), culler on the pool: "
+              << pooledMs << " ms (x" << linearMs / pooledMs << ")" << std::endl;
+  }
+}
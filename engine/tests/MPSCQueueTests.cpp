@@ -0,0 +1,148 @@
+#include "Testing.h"
+
+// Project includes.
+#include "Core/MPSCQueue.h"
+
+// STL includes.
+#include <atomic>
+#include <thread>
+
+namespace Strontium
+{
+  namespace
+  {
+    struct TaggedValue
+    {
+      uint producer = 0;
+      uint sequence = 0;
+    };
+  }
+
+  SR_TEST(MPSCQueue, fillsAndDrainsInOrder)
+  {
+    MPSCQueue<uint> queue(5);
+    SR_CHECK(queue.capacity() == 8);
+    SR_CHECK(queue.empty());
+    SR_CHECK(queue.peek() == nullptr);
+
+    for (uint i = 0; i < queue.capacity(); i++)
+      SR_CHECK(queue.tryPush(std::move(i)));
+
+    uint overflow = 100;
+    SR_CHECK(!queue.tryPush(std::move(overflow)));
+    SR_CHECK(queue.size() == queue.capacity());
+
+    // Wrap around a few laps to reuse every slot.
+    for (uint lap = 0; lap < 3; lap++)
+    {
+      for (uint i = 0; i < queue.capacity(); i++)
+      {
+        uint* front = queue.peek();
+        SR_CHECK(front != nullptr && *front == lap * queue.capacity() + i);
+
+        uint value = 0;
+        SR_CHECK(queue.tryPop(value));
+        SR_CHECK(value == lap * queue.capacity() + i);
+
+        uint next = (lap + 1) * queue.capacity() + i;
+        SR_CHECK(queue.tryPush(std::move(next)));
+      }
+    }
+
+    uint value = 0;
+    uint numLeft = 0;
+    while (queue.tryPop(value))
+      numLeft++;
+    SR_CHECK(numLeft == queue.capacity());
+    SR_CHECK(queue.empty());
+  }
+
+  // Hundreds of producers push into a queue much smaller than the total, so
+  // most pushes hit backpressure. The consumer only ever calls tryPop. Every
+  // value has to arrive exactly once, and each producer's values in order.
+  SR_TEST(MPSCQueue, multiProducerStress)
+  {
+    constexpr uint numProducers = 256;
+    constexpr uint valuesPerProducer = 2000;
+
+    MPSCQueue<TaggedValue> queue(64);
+    std::atomic<bool> startFlag(false);
+    std::atomic<bool> consumerGone(false);
+
+    std::vector<std::thread> producers;
+    for (uint p = 0; p < numProducers; p++)
+    {
+      producers.emplace_back([p, &queue, &startFlag, &consumerGone]()
+      {
+        while (!startFlag.load())
+          std::this_thread::yield();
+
+        for (uint i = 0; i < valuesPerProducer; i++)
+        {
+          TaggedValue value;
+          value.producer = p;
+          value.sequence = i;
+          if (!queue.push(std::move(value), [&consumerGone]() { return consumerGone.load(); }))
+            return;
+        }
+      });
+    }
+
+    std::vector<uint> nextSequence(numProducers, 0);
+    uint numReceived = 0;
+    bool inOrder = true;
+
+    startFlag.store(true);
+    auto start = std::chrono::steady_clock::now();
+    while (numReceived < numProducers * valuesPerProducer)
+    {
+      TaggedValue value;
+      if (!queue.tryPop(value))
+      {
+        // Bail out instead of hanging if values went missing.
+        if (Testing::millisecondsSince(start) > 60000.0)
+          break;
+        std::this_thread::yield();
+        continue;
+      }
+
+      inOrder = inOrder && value.producer < numProducers
+                && value.sequence == nextSequence[value.producer];
+      if (value.producer < numProducers)
+        nextSequence[value.producer] = value.sequence + 1;
+      numReceived++;
+    }
+
+    consumerGone.store(true);
+    for (auto& producer : producers)
+      producer.join();
+
+    SR_CHECK(numReceived == numProducers * valuesPerProducer);
+    SR_CHECK(inOrder);
+    SR_CHECK(queue.empty());
+  }
+
+  // Producers give up on a full queue once the consumer stops, instead of
+  // spinning forever.
+  SR_TEST(MPSCQueue, pushGivesUp)
+  {
+    MPSCQueue<uint> queue(2);
+    uint value = 1;
+    SR_CHECK(queue.tryPush(std::move(value)));
+    value = 2;
+    SR_CHECK(queue.tryPush(std::move(value)));
+
+    std::atomic<bool> giveUp(false);
+    std::atomic<bool> pushed(true);
+    std::thread producer([&queue, &giveUp, &pushed]()
+    {
+      uint blocked = 3;
+      pushed.store(queue.push(std::move(blocked), [&giveUp]() { return giveUp.load(); }));
+    });
+
+    giveUp.store(true);
+    producer.join();
+    SR_CHECK(!pushed.load());
+    SR_CHECK(queue.size() == 2);
+  }
+}
@@ -0,0 +1,307 @@
+#include "Testing.h"
+
+// Project includes.
+#include "Core/Math.h"
+
+// STL includes.
+#include <cmath>
+#include <random>
+
+// Built twice, once as the engine is and once with AVX2 enabled, so both
+// SIMD paths are checked against the scalar one.
+namespace Strontium
+{
+  namespace
+  {
+    struct TestBoxes
+    {
+      std::vector<float> centerX, centerY, centerZ;
+      std::vector<float> extentX, extentY, extentZ;
+
+      void
+      add(const glm::vec3 &center, const glm::vec3 &extents)
+      {
+        this->centerX.push_back(center.x);
+        this->centerY.push_back(center.y);
+        this->centerZ.push_back(center.z);
+        this->extentX.push_back(extents.x);
+        this->extentY.push_back(extents.y);
+        this->extentZ.push_back(extents.z);
+      }
+
+      uint size() const { return static_cast<uint>(this->centerX.size()); }
+
+      BoundingBox
+      get(uint index) const
+      {
+        BoundingBox box;
+        box.center = glm::vec3(this->centerX[index], this->centerY[index], this->centerZ[index]);
+        box.extents = glm::vec3(this->extentX[index], this->extentY[index], this->extentZ[index]);
+        return box;
+      }
+
+      BoundingBoxArrays
+      getArrays() const
+      {
+        return { this->centerX.data(), this->centerY.data(), this->centerZ.data(),
+                 this->extentX.data(), this->extentY.data(), this->extentZ.data() };
+      }
+    };
+
+    bool
+    boxInFrustum(const Frustum &frustum, const BoundingBox &box)
+    {
+      bool inFrustum = true;
+      for (uint p = 0; p < 6; p++)
+        inFrustum = inFrustum && boundingBoxOnPlane(frustum.sides[p], box);
+      return inFrustum;
+    }
+
+    void
+    setPlane(Plane &plane, const glm::vec3 &normal, float d)
+    {
+      plane.normal = normal;
+      plane.d = d;
+      plane.point = normal * d;
+    }
+
+    // Six unrelated planes. Only the normals and distances are used by the
+    // tests, so they don't need to enclose anything.
+    Frustum
+    randomFrustum(std::mt19937 &generator)
+    {
+      std::uniform_real_distribution<float> component(-1.0f, 1.0f);
+      std::uniform_real_distribution<float> distance(-60.0f, 20.0f);
+
+      Frustum frustum;
+      for (uint p = 0; p < 6; p++)
+      {
+        glm::vec3 normal(component(generator), component(generator), component(generator));
+        setPlane(frustum.sides[p], glm::normalize(normal + glm::vec3(0.0f, 0.0f, 1e-3f)),
+                 distance(generator));
+      }
+
+      return frustum;
+    }
+
+    // Runs the kernel over [start, end) of masks prefilled with a pattern,
+    // and checks the result against the scalar loop and per-box tests. Masks
+    // outside the range and the other bits have to be left alone.
+    bool
+    kernelMatches(const Frustum &frustum, const TestBoxes &boxes, uint start, uint end)
+    {
+      constexpr uint8_t pattern = 0x5A;
+      constexpr uint8_t bit = 0x80;
+
+      FrustumPlanes planes = packFrustumPlanes(frustum);
+      std::vector<uint8_t> simdMasks(boxes.size(), pattern);
+      std::vector<uint8_t> scalarMasks(boxes.size(), pattern);
+      boundingBoxesInFrustum(planes, boxes.getArrays(), start, end, bit, simdMasks.data());
+      boundingBoxesInFrustumScalar(planes, boxes.getArrays(), start, end, bit, scalarMasks.data());
+
+      bool matches = simdMasks == scalarMasks;
+      for (uint i = 0; i < boxes.size(); i++)
+      {
+        bool expected = i >= start && i < end && boxInFrustum(frustum, boxes.get(i));
+        matches = matches && simdMasks[i] == (expected ? pattern | bit : pattern);
+      }
+
+      return matches;
+    }
+
+    // Ranges with starts and ends off the SIMD width, and ones shorter
+    // than it.
+    template <typename Func>
+    void
+    forEachRange(uint numBoxes, Func &&func)
+    {
+      for (uint start : { 0u, 1u, 3u, 5u, 8u })
+      {
+        for (uint end : { numBoxes, numBoxes - 1, numBoxes - 7, start + 3, start })
+          func(start, end);
+      }
+    }
+  }
+
+  SR_TEST(Math, kernelMatchesScalarOnRandomBoxes)
+  {
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> extent(0.0f, 40.0f);
+
+    for (uint run = 0; run < 50; run++)
+    {
+      Frustum frustum = randomFrustum(generator);
+
+      TestBoxes boxes;
+      for (uint i = 0; i < 1037; i++)
+      {
+        glm::vec3 center(position(generator), position(generator), position(generator));
+        glm::vec3 extents = i % 13 == 0 ? glm::vec3(0.0f)
+                                        : glm::vec3(extent(generator), extent(generator), extent(generator));
+        boxes.add(center, extents);
+      }
+
+      forEachRange(boxes.size(), [&](uint start, uint end)
+      {
+        SR_CHECK(kernelMatches(frustum, boxes, start, end));
+      });
+    }
+  }
+
+  // Boxes moved onto random planes, so the signed distance lands within
+  // rounding of -r and the comparison goes either way.
+  SR_TEST(Math, kernelMatchesScalarNearPlanes)
+  {
+    std::mt19937 generator(2);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> extent(0.0f, 10.0f);
+
+    for (uint run = 0; run < 50; run++)
+    {
+      Frustum frustum = randomFrustum(generator);
+
+      TestBoxes boxes;
+      for (uint i = 0; i < 515; i++)
+      {
+        const Plane &plane = frustum.sides[i % 6];
+        BoundingBox box;
+        box.center = glm::vec3(position(generator), position(generator), position(generator));
+        box.extents = i % 7 == 0 ? glm::vec3(0.0f)
+                                 : glm::vec3(extent(generator), extent(generator), extent(generator));
+
+        const float r = box.extents.x * std::abs(plane.normal.x) +
+                        box.extents.y * std::abs(plane.normal.y) +
+                        box.extents.z * std::abs(plane.normal.z);
+        box.center -= plane.normal * (signedPlaneDistance(plane, box.center) + r);
+        boxes.add(box.center, box.extents);
+      }
+
+      forEachRange(boxes.size(), [&](uint start, uint end)
+      {
+        SR_CHECK(kernelMatches(frustum, boxes, start, end));
+      });
+    }
+  }
+
+  // An axis aligned frustum with exactly representable values, so boxes
+  // can touch a plane exactly (distance == -r) and sit one ulp past it.
+  SR_TEST(Math, boxesTouchingPlanes)
+  {
+    const float halfSize = 10.0f;
+    const glm::vec3 axes[3] = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
+                                glm::vec3(0.0f, 0.0f, 1.0f) };
+
+    Frustum frustum;
+    for (uint axis = 0; axis < 3; axis++)
+    {
+      setPlane(frustum.sides[2 * axis], axes[axis], -halfSize);
+      setPlane(frustum.sides[2 * axis + 1], -1.0f * axes[axis], -halfSize);
+    }
+
+    TestBoxes boxes;
+    std::vector<bool> expected;
+    for (float e : { 0.0f, 0.5f, 1.25f, 3.0f })
+    {
+      for (uint axis = 0; axis < 3; axis++)
+      {
+        for (float side : { -1.0f, 1.0f })
+        {
+          // Touching from outside, and one ulp further out.
+          const float touching = side * (halfSize + e);
+          const float beyond = std::nextafter(touching, side * 1000.0f);
+          boxes.add(axes[axis] * touching, glm::vec3(e));
+          expected.push_back(true);
+          boxes.add(axes[axis] * beyond, glm::vec3(e));
+          expected.push_back(false);
+
+          // Touching from inside.
+          boxes.add(axes[axis] * (side * (halfSize - e)), glm::vec3(e));
+          expected.push_back(true);
+        }
+      }
+    }
+
+    for (uint i = 0; i < boxes.size(); i++)
+      SR_CHECK(boxInFrustum(frustum, boxes.get(i)) == expected[i]);
+
+    forEachRange(boxes.size(), [&](uint start, uint end)
+    {
+      SR_CHECK(kernelMatches(frustum, boxes, start, end));
+    });
+  }
+
+  // The kernel against the scalar loop it falls back to, and against the
+  // per-box test it replaced, over 1M boxes.
+  SR_BENCHMARK(Math, boxesInFrustum)
+  {
+    constexpr uint numBoxes = 1 << 20;
+    constexpr uint numRuns = 20;
+
+#if defined(SR_FRUSTUM_SIMD_AVX2)
+    std::cout << "  SIMD path: AVX2" << std::endl;
+#elif defined(SR_FRUSTUM_SIMD_SSE2)
+    std::cout << "  SIMD path: SSE2" << std::endl;
+#else
+    std::cout << "  SIMD path: none" << std::endl;
+#endif
+
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> extent(0.0f, 10.0f);
+    std::uniform_real_distribution<float> component(-1.0f, 1.0f);
+
+    // A frustum roughly a quarter of the boxes are in.
+    Frustum frustum;
+    for (uint p = 0; p < 6; p++)
+    {
+      glm::vec3 normal(component(generator), component(generator), component(generator));
+      setPlane(frustum.sides[p], glm::normalize(normal + glm::vec3(0.0f, 0.0f, 1e-3f)), -40.0f);
+    }
+
+    TestBoxes boxes;
+    for (uint i = 0; i < numBoxes; i++)
+    {
+      boxes.add(glm::vec3(position(generator), position(generator), position(generator)),
+                glm::vec3(extent(generator), extent(generator), extent(generator)));
+    }
+
+    FrustumPlanes planes = packFrustumPlanes(frustum);
+    std::vector<uint8_t> masks(numBoxes, 0);
+    uint numVisible[3] = { 0, 0, 0 };
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint run = 0; run < numRuns; run++)
+    {
+      for (uint i = 0; i < numBoxes; i++)
+        numVisible[0] += boxInFrustum(frustum, boxes.get(i)) ? 1 : 0;
+    }
+    double perBoxMs = Testing::millisecondsSince(start) / numRuns;
+
+    start = std::chrono::steady_clock::now();
+    for (uint run = 0; run < numRuns; run++)
+    {
+      std::fill(masks.begin(), masks.end(), 0);
+      boundingBoxesInFrustumScalar(planes, boxes.getArrays(), 0, numBoxes, 1, masks.data());
+      for (uint8_t mask : masks)
+        numVisible[1] += mask;
+    }
+    double scalarMs = Testing::millisecondsSince(start) / numRuns;
+
+    start = std::chrono::steady_clock::now();
+    for (uint run = 0; run < numRuns; run++)
+    {
+      std::fill(masks.begin(), masks.end(), 0);
+      boundingBoxesInFrustum(planes, boxes.getArrays(), 0, numBoxes, 1, masks.data());
+      for (uint8_t mask : masks)
+        numVisible[2] += mask;
+    }
+    double simdMs = Testing::millisecondsSince(start) / numRuns;
+
+    SR_CHECK(numVisible[0] == numVisible[1] && numVisible[1] == numVisible[2]);
+    std::cout << "  " << numVisible[0] / numRuns << " of " << numBoxes << " visible" << std::endl;
+    std::cout << "  per box: " << perBoxMs << " ms, scalar loop: " << scalarMs
+              << " ms (x" << perBoxMs / scalarMs << "), SIMD: " << simdMs << " ms (x"
+              << perBoxMs / simdMs << ")" << std::endl;
+  }
+}
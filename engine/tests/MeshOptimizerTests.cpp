@@ -0,0 +1,484 @@
+#include "Testing.h"
+
+// Project includes.
+#include "Graphics/MeshOptimizer.h"
+
+// STL includes.
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+
+namespace Strontium
+{
+  using namespace MeshOptimizer;
+
+  namespace
+  {
+    // A grid of cells by cells quads over the xz plane, two triangles each,
+    // facing up. The heights roll so the overdraw pass has something to sort.
+    void
+    buildGrid(uint cells, std::vector<Vertex> &outVertices, std::vector<uint> &outIndices)
+    {
+      outVertices.clear();
+      outIndices.clear();
+      for (uint z = 0; z <= cells; z++)
+      {
+        for (uint x = 0; x <= cells; x++)
+        {
+          Vertex vertex;
+          float height = 4.0f * std::sin(0.15f * x) * std::cos(0.1f * z);
+          vertex.position = glm::vec4(static_cast<float>(x), height, static_cast<float>(z), 1.0f);
+          vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+          vertex.uv = glm::vec2(static_cast<float>(x), static_cast<float>(z)) / static_cast<float>(cells);
+          outVertices.push_back(vertex);
+        }
+      }
+
+      for (uint z = 0; z < cells; z++)
+      {
+        for (uint x = 0; x < cells; x++)
+        {
+          uint corner = z * (cells + 1) + x;
+          outIndices.insert(outIndices.end(), { corner, corner + cells + 1, corner + 1 });
+          outIndices.insert(outIndices.end(), { corner + 1, corner + cells + 1, corner + cells + 2 });
+        }
+      }
+    }
+
+    // Shuffle the triangle order, the worst case for the vertex cache.
+    void
+    shuffleTriangles(std::vector<uint> &indices, uint seed)
+    {
+      std::vector<std::array<uint, 3>> triangles(indices.size() / 3);
+      for (std::size_t i = 0; i < triangles.size(); i++)
+        triangles[i] = { indices[3 * i], indices[3 * i + 1], indices[3 * i + 2] };
+
+      std::shuffle(triangles.begin(), triangles.end(), std::mt19937(seed));
+      for (std::size_t i = 0; i < triangles.size(); i++)
+        std::copy(triangles[i].begin(), triangles[i].end(), indices.begin() + 3 * i);
+    }
+
+    // Every triangle rotated to start at its smallest index, which keeps the
+    // winding, then sorted. Two buffers holding the same triangles in any
+    // order give the same list.
+    std::vector<std::array<uint, 3>>
+    canonicalTriangles(const std::vector<uint> &indices)
+    {
+      std::vector<std::array<uint, 3>> triangles(indices.size() / 3);
+      for (std::size_t i = 0; i < triangles.size(); i++)
+      {
+        const uint* triangle = &indices[3 * i];
+        uint first = triangle[0] <= triangle[1] && triangle[0] <= triangle[2] ? 0
+                   : triangle[1] <= triangle[2] ? 1 : 2;
+        triangles[i] = { triangle[first], triangle[(first + 1) % 3], triangle[(first + 2) % 3] };
+      }
+
+      std::sort(triangles.begin(), triangles.end());
+      return triangles;
+    }
+
+    // A closed UV sphere around the origin. The first and last column of
+    // every ring share positions but not texture coordinates, so there's a
+    // seam, and each pole is a ring of vertices in one spot.
+    void
+    buildSphere(uint slices, uint stacks, float radius, std::vector<Vertex> &outVertices,
+                std::vector<uint> &outIndices)
+    {
+      const float pi = 3.14159265358979f;
+
+      outVertices.clear();
+      outIndices.clear();
+      for (uint stack = 0; stack <= stacks; stack++)
+      {
+        float theta = pi * stack / stacks;
+        for (uint slice = 0; slice <= slices; slice++)
+        {
+          float phi = 2.0f * pi * (slice % slices) / slices;
+          glm::vec3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+
+          Vertex vertex;
+          vertex.position = glm::vec4(normal * radius, 1.0f);
+          vertex.normal = normal;
+          vertex.uv = glm::vec2(static_cast<float>(slice) / slices, static_cast<float>(stack) / stacks);
+          outVertices.push_back(vertex);
+        }
+      }
+
+      for (uint stack = 0; stack < stacks; stack++)
+      {
+        for (uint slice = 0; slice < slices; slice++)
+        {
+          uint corner = stack * (slices + 1) + slice;
+          uint below = corner + slices + 1;
+          if (stack != 0)
+            outIndices.insert(outIndices.end(), { corner, corner + 1, below });
+          if (stack != stacks - 1)
+            outIndices.insert(outIndices.end(), { corner + 1, below + 1, below });
+        }
+      }
+    }
+
+    // Distance from a point to the closest point of a triangle, by
+    // projecting onto the plane and falling back to the edges when that
+    // lands outside.
+    float
+    distanceToTriangle(const glm::vec3 &point, const glm::vec3 &a, const glm::vec3 &b,
+                       const glm::vec3 &c)
+    {
+      glm::vec3 normal = glm::normalize(glm::cross(b - a, c - a));
+      glm::vec3 projected = point - normal * glm::dot(normal, point - a);
+      if (glm::dot(glm::cross(b - a, projected - a), normal) >= 0.0f
+          && glm::dot(glm::cross(c - b, projected - b), normal) >= 0.0f
+          && glm::dot(glm::cross(a - c, projected - c), normal) >= 0.0f)
+        return glm::length(point - projected);
+
+      float distance = std::numeric_limits<float>::max();
+      const glm::vec3 edges[3][2] = { { a, b }, { b, c }, { c, a } };
+      for (auto& edge : edges)
+      {
+        glm::vec3 direction = edge[1] - edge[0];
+        float t = std::clamp(glm::dot(point - edge[0], direction) / glm::dot(direction, direction),
+                             0.0f, 1.0f);
+        distance = std::min(distance, glm::length(point - edge[0] - direction * t));
+      }
+      return distance;
+    }
+
+    glm::vec3
+    corner(const std::vector<uint> &indices, const std::vector<Vertex> &vertices, std::size_t i)
+    {
+      return glm::vec3(vertices[indices[i]].position);
+    }
+
+    // How far the triangles sag inside a sphere around the origin, relative
+    // to its diameter: the radius less the closest distance of any triangle
+    // to the center.
+    float
+    sphereSag(const std::vector<uint> &indices, const std::vector<Vertex> &vertices, float radius)
+    {
+      float sag = 0.0f;
+      for (std::size_t i = 0; i < indices.size(); i += 3)
+      {
+        float distance = distanceToTriangle(glm::vec3(0.0f), corner(indices, vertices, i),
+                                            corner(indices, vertices, i + 1),
+                                            corner(indices, vertices, i + 2));
+        sag = std::max(sag, radius - distance);
+      }
+
+      return sag / (2.0f * radius);
+    }
+
+    // The largest distance from a point on one surface to the other, either
+    // way round, by brute force over points spread across every triangle.
+    // Relative to the given extent.
+    float
+    surfaceDeviation(const std::vector<uint> &source, const std::vector<uint> &simplified,
+                     const std::vector<Vertex> &vertices, float extent)
+    {
+      constexpr uint steps = 8;
+
+      float deviation = 0.0f;
+      auto oneWay = [&](const std::vector<uint> &from, const std::vector<uint> &to)
+      {
+        for (std::size_t i = 0; i < from.size(); i += 3)
+        {
+          glm::vec3 a = corner(from, vertices, i), b = corner(from, vertices, i + 1);
+          glm::vec3 c = corner(from, vertices, i + 2);
+          for (uint u = 0; u <= steps; u++)
+          {
+            for (uint v = 0; u + v <= steps; v++)
+            {
+              glm::vec3 point = a + (b - a) * (static_cast<float>(u) / steps)
+                                  + (c - a) * (static_cast<float>(v) / steps);
+              float distance = std::numeric_limits<float>::max();
+              for (std::size_t j = 0; j < to.size(); j += 3)
+                distance = std::min(distance, distanceToTriangle(point, corner(to, vertices, j),
+                                                                 corner(to, vertices, j + 1),
+                                                                 corner(to, vertices, j + 2)));
+              deviation = std::max(deviation, distance);
+            }
+          }
+        }
+      };
+      oneWay(source, simplified);
+      oneWay(simplified, source);
+
+      return deviation / extent;
+    }
+  }
+
+  SR_TEST(MeshOptimizer, analyzeVertexCacheCounts)
+  {
+    // One triangle transforms all three vertices.
+    VertexCacheStats single = analyzeVertexCache({ 0, 1, 2 }, 3);
+    SR_CHECK(single.acmr == 3.0f && single.atvr == 1.0f);
+
+    // A strip-like pair shares an edge, and repeating a cached triangle is free.
+    VertexCacheStats pair = analyzeVertexCache({ 0, 1, 2, 2, 1, 3, 0, 1, 2 }, 4);
+    SR_CHECK(pair.acmr == 4.0f / 3.0f && pair.atvr == 1.0f);
+
+    // A cache of 3 evicts vertex 0 before it's used again.
+    VertexCacheStats evicted = analyzeVertexCache({ 0, 1, 2, 3, 4, 5, 0, 1, 2 }, 6, 3);
+    SR_CHECK(evicted.acmr == 3.0f && evicted.atvr == 1.5f);
+  }
+
+  // The shuffled 80k triangle grid from the import report. Both reorderings
+  // have to keep exactly the input triangles, with their winding.
+  SR_TEST(MeshOptimizer, reorderingKeepsTrianglesAndHelpsTheCache)
+  {
+    std::vector<Vertex> vertices;
+    std::vector<uint> indices;
+    buildGrid(200, vertices, indices);
+    shuffleTriangles(indices, 1);
+    SR_CHECK(indices.size() == 3 * 80000);
+
+    const uint numVertices = static_cast<uint>(vertices.size());
+    const auto inputTriangles = canonicalTriangles(indices);
+    VertexCacheStats shuffled = analyzeVertexCache(indices, numVertices);
+    SR_CHECK(shuffled.acmr > 2.9f && shuffled.atvr > 5.0f);
+
+    optimizeVertexCache(indices, numVertices);
+    SR_CHECK(canonicalTriangles(indices) == inputTriangles);
+    VertexCacheStats cacheOptimized = analyzeVertexCache(indices, numVertices);
+    std::cout << "  ACMR / ATVR: shuffled " << shuffled.acmr << " / " << shuffled.atvr
+              << ", cache optimised " << cacheOptimized.acmr << " / " << cacheOptimized.atvr;
+    SR_CHECK(cacheOptimized.acmr < 0.8f && cacheOptimized.atvr < 1.6f);
+
+    // The overdraw pass may only give back the threshold it's allowed.
+    const std::vector<uint> cacheOrder = indices;
+    optimizeOverdraw(indices, vertices, 1.05f);
+    SR_CHECK(indices != cacheOrder);
+    SR_CHECK(canonicalTriangles(indices) == inputTriangles);
+    VertexCacheStats overdrawOptimized = analyzeVertexCache(indices, numVertices);
+    std::cout << ", overdraw optimised " << overdrawOptimized.acmr << " / "
+              << overdrawOptimized.atvr << std::endl;
+    SR_CHECK(overdrawOptimized.acmr <= cacheOptimized.acmr * 1.05f + 1e-4f);
+
+    // Already optimised input stays a permutation too.
+    optimizeVertexCache(indices, numVertices);
+    SR_CHECK(canonicalTriangles(indices) == inputTriangles);
+  }
+
+  SR_TEST(MeshOptimizer, vertexFetchRemapsAndDropsUnused)
+  {
+    std::vector<Vertex> vertices;
+    std::vector<uint> indices;
+    buildGrid(40, vertices, indices);
+    shuffleTriangles(indices, 2);
+
+    // Mix in vertices which no triangle uses.
+    std::vector<Vertex> padded;
+    std::vector<uint> paddedIndex(vertices.size());
+    for (uint i = 0; i < vertices.size(); i++)
+    {
+      if (i % 5 == 0)
+      {
+        Vertex unused;
+        unused.position = glm::vec4(-1.0f, -1.0f, -1.0f, 1.0f);
+        padded.push_back(unused);
+      }
+      paddedIndex[i] = static_cast<uint>(padded.size());
+      padded.push_back(vertices[i]);
+    }
+    vertices = padded;
+    for (uint &index : indices)
+      index = paddedIndex[index];
+
+    std::vector<bool> used(vertices.size(), false);
+    for (uint index : indices)
+      used[index] = true;
+    uint numUsed = static_cast<uint>(std::count(used.begin(), used.end(), true));
+    SR_CHECK(numUsed < vertices.size());
+
+    const std::vector<Vertex> inputVertices = vertices;
+    const std::vector<uint> inputIndices = indices;
+    optimizeVertexFetch(vertices, indices);
+
+    SR_CHECK(vertices.size() == numUsed);
+    SR_CHECK(indices.size() == inputIndices.size());
+
+    // Same triangles, in the same order, through the new vertex order.
+    bool sameVertices = true;
+    for (std::size_t i = 0; i < indices.size(); i++)
+    {
+      const Vertex& before = inputVertices[inputIndices[i]];
+      const Vertex& after = vertices[indices[i]];
+      sameVertices = sameVertices && before.position == after.position && before.uv == after.uv;
+    }
+    SR_CHECK(sameVertices);
+
+    // Vertices come in the order they're first used.
+    uint nextNew = 0;
+    bool firstUseOrder = true;
+    for (uint index : indices)
+    {
+      if (index == nextNew)
+        nextNew++;
+      else
+        firstUseOrder = firstUseOrder && index < nextNew;
+    }
+    SR_CHECK(firstUseOrder && nextNew == numUsed);
+  }
+
+  SR_TEST(MeshOptimizer, simplifyReachesTargetCount)
+  {
+    std::vector<Vertex> vertices;
+    std::vector<uint> indices;
+    buildSphere(48, 33, 1.0f, vertices, indices);
+
+    for (uint ratio : { 2u, 4u, 8u })
+    {
+      uint target = static_cast<uint>(indices.size() / ratio) / 3 * 3;
+      auto result = simplify(indices, vertices, target, 1.0f);
+      SR_CHECK(result.size() % 3 == 0);
+      SR_CHECK(result.size() <= target && result.size() > target * 9 / 10);
+    }
+
+    // A tight error budget stops well short of the target.
+    float error = 0.0f;
+    auto result = simplify(indices, vertices, static_cast<uint>(indices.size() / 8) / 3 * 3,
+                           1e-4f, &error);
+    SR_CHECK(result.size() > indices.size() / 2);
+
+    // Nothing to do if the mesh is already small enough.
+    result = simplify(indices, vertices, static_cast<uint>(indices.size()), 1.0f, &error);
+    SR_CHECK(result == indices && error == 0.0f);
+  }
+
+  // Vertices on the border of an open mesh and on UV seams may only be
+  // collapsed onto, never moved, or the levels would crack.
+  SR_TEST(MeshOptimizer, simplifyKeepsBordersAndSeams)
+  {
+    constexpr uint cells = 40;
+    std::vector<Vertex> vertices;
+    std::vector<uint> indices;
+    buildGrid(cells, vertices, indices);
+
+    // Split the grid down the middle column with its own copy of the
+    // vertices there, like a UV seam.
+    constexpr uint seamColumn = cells / 2;
+    std::vector<uint> seamCopy(vertices.size(), 0);
+    for (uint z = 0; z <= cells; z++)
+    {
+      uint vertex = z * (cells + 1) + seamColumn;
+      seamCopy[vertex] = static_cast<uint>(vertices.size());
+      Vertex copy = vertices[vertex];
+      copy.uv.x += 1.0f;
+      vertices.push_back(copy);
+    }
+    for (std::size_t i = 0; i < indices.size(); i += 3)
+    {
+      float centerX = 0.0f;
+      for (uint j = 0; j < 3; j++)
+        centerX += vertices[indices[i + j]].position.x / 3.0f;
+      if (centerX > seamColumn)
+      {
+        for (uint j = 0; j < 3; j++)
+          if (static_cast<uint>(vertices[indices[i + j]].position.x) == seamColumn)
+            indices[i + j] = seamCopy[indices[i + j]];
+      }
+    }
+
+    auto isKept = [&](uint vertex)
+    {
+      float x = vertices[vertex].position.x, z = vertices[vertex].position.z;
+      return x == 0.0f || z == 0.0f || x == cells || z == cells || x == seamColumn;
+    };
+
+    float error = 0.0f;
+    auto result = simplify(indices, vertices, static_cast<uint>(indices.size() / 6) / 3 * 3,
+                           1.0f, &error);
+    SR_CHECK(result.size() < indices.size() / 2);
+
+    std::vector<bool> used(vertices.size(), false);
+    for (uint index : result)
+      used[index] = true;
+
+    uint numKept = 0;
+    bool keptAll = true;
+    for (uint i = 0; i < vertices.size(); i++)
+    {
+      if (isKept(i))
+      {
+        keptAll = keptAll && used[i];
+        numKept++;
+      }
+    }
+    // The border, the inside of the seam and both copies' ends.
+    SR_CHECK(keptAll && numKept == 4 * cells + (cells - 1) + (cells + 1));
+
+    // The seam copies stay on their own side.
+    bool seamSplit = true;
+    for (std::size_t i = 0; i < result.size(); i += 3)
+    {
+      bool usesOriginal = false, usesCopy = false;
+      for (uint j = 0; j < 3; j++)
+      {
+        usesOriginal = usesOriginal || (result[i + j] < seamCopy.size() && seamCopy[result[i + j]] != 0);
+        usesCopy = usesCopy || result[i + j] >= seamCopy.size();
+      }
+      seamSplit = seamSplit && !(usesOriginal && usesCopy);
+    }
+    SR_CHECK(seamSplit);
+  }
+
+  // The reported error has to keep up with how far the surface actually
+  // moved, however dense the mesh. On a small sphere that's checked against
+  // the deviation by brute force. That's too slow for a dense one, but the
+  // coarse triangles sag inside the sphere by more than the source triangles
+  // do, and the difference is a lower bound on the deviation.
+  SR_TEST(MeshOptimizer, simplifyReportsTheDeviation)
+  {
+    constexpr float radius = 3.0f;
+
+    std::vector<Vertex> vertices;
+    std::vector<uint> indices;
+    buildSphere(24, 21, radius, vertices, indices);
+
+    float coarseError = 0.0f;
+    auto result = simplify(indices, vertices, static_cast<uint>(indices.size() / 8) / 3 * 3,
+                           1.0f, &coarseError);
+    float deviation = surfaceDeviation(indices, result, vertices, 2.0f * radius);
+    std::cout << "  " << indices.size() / 3 << " -> " << result.size() / 3
+              << " triangles: reported " << coarseError << ", deviation " << deviation << std::endl;
+    SR_CHECK(coarseError >= 0.9f * deviation && coarseError <= 1.5f * deviation);
+
+    buildSphere(256, 129, radius, vertices, indices);
+
+    float denseError = 0.0f;
+    result = simplify(indices, vertices, static_cast<uint>(indices.size() / 8) / 3 * 3,
+                      1.0f, &denseError);
+    deviation = sphereSag(result, vertices, radius) - sphereSag(indices, vertices, radius);
+    std::cout << "  " << indices.size() / 3 << " -> " << result.size() / 3
+              << " triangles: reported " << denseError << ", deviation at least "
+              << deviation << std::endl;
+    SR_CHECK(deviation > 0.0f && denseError >= deviation);
+    SR_CHECK(denseError < coarseError);
+  }
+
+  SR_BENCHMARK(MeshOptimizer, optimizeGrid)
+  {
+    std::vector<Vertex> vertices;
+    std::vector<uint> indices;
+    buildGrid(400, vertices, indices);
+    shuffleTriangles(indices, 3);
+    const uint numVertices = static_cast<uint>(vertices.size());
+
+    auto start = std::chrono::steady_clock::now();
+    optimizeVertexCache(indices, numVertices);
+    double cacheMs = Testing::millisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    optimizeOverdraw(indices, vertices);
+    double overdrawMs = Testing::millisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    optimizeVertexFetch(vertices, indices);
+    double fetchMs = Testing::millisecondsSince(start);
+
+    std::cout << "  " << indices.size() / 3 << " triangles: vertex cache " << cacheMs
+              << " ms, overdraw " << overdrawMs << " ms, vertex fetch " << fetchMs
+              << " ms" << std::endl;
+  }
+}
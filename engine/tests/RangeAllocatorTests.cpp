@@ -0,0 +1,203 @@
+#include "Testing.h"
+
+// Project includes.
+#include "Graphics/GeometryArena.h"
+
+// STL includes.
+#include <random>
+
+namespace Strontium
+{
+  namespace
+  {
+    // One flag per element, and the first fit answer a perfectly merged set
+    // of free ranges would give.
+    struct ReferenceRanges
+    {
+      std::vector<bool> taken;
+
+      bool
+      allocate(uint size, uint &outOffset)
+      {
+        uint runStart = 0, runSize = 0;
+        for (uint i = 0; i < this->taken.size(); i++)
+        {
+          if (this->taken[i])
+          {
+            runStart = i + 1;
+            runSize = 0;
+            continue;
+          }
+
+          if (++runSize == size)
+          {
+            std::fill(this->taken.begin() + runStart, this->taken.begin() + runStart + size, true);
+            outOffset = runStart;
+            return true;
+          }
+        }
+
+        return false;
+      }
+
+      void
+      free(uint offset, uint size)
+      {
+        std::fill(this->taken.begin() + offset, this->taken.begin() + offset + size, false);
+      }
+
+      uint
+      largestFree() const
+      {
+        uint largest = 0, runSize = 0;
+        for (bool taken : this->taken)
+        {
+          runSize = taken ? 0 : runSize + 1;
+          largest = std::max(largest, runSize);
+        }
+        return largest;
+      }
+    };
+  }
+
+  SR_TEST(RangeAllocator, freedNeighboursMerge)
+  {
+    RangeAllocator ranges;
+    ranges.grow(300);
+
+    uint a, b, c;
+    SR_CHECK(ranges.allocate(100, a) && a == 0);
+    SR_CHECK(ranges.allocate(100, b) && b == 100);
+    SR_CHECK(ranges.allocate(100, c) && c == 200);
+    SR_CHECK(ranges.getUsed() == 300);
+
+    // Freed out of order, the middle range joins both sides.
+    uint offset;
+    ranges.free(a, 100);
+    ranges.free(c, 100);
+    SR_CHECK(!ranges.allocate(150, offset));
+    ranges.free(b, 100);
+    SR_CHECK(ranges.getUsed() == 0);
+    SR_CHECK(ranges.allocate(300, offset) && offset == 0);
+    ranges.free(offset, 300);
+
+    // Joining only the range before, then only the range after.
+    SR_CHECK(ranges.allocate(100, a) && ranges.allocate(100, b) && ranges.allocate(100, c));
+    ranges.free(a, 100);
+    ranges.free(b, 100);
+    SR_CHECK(ranges.allocate(200, offset) && offset == 0);
+    ranges.free(offset, 200);
+    ranges.free(c, 100);
+    SR_CHECK(ranges.allocate(300, offset) && offset == 0);
+  }
+
+  SR_TEST(RangeAllocator, growMergesWithTheFreeTail)
+  {
+    RangeAllocator ranges;
+    uint offset;
+    SR_CHECK(!ranges.allocate(1, offset));
+
+    ranges.grow(100);
+    SR_CHECK(ranges.getCapacity() == 100 && ranges.getUsed() == 0);
+
+    uint head;
+    SR_CHECK(ranges.allocate(60, head) && head == 0);
+
+    // The 40 free at the end and the 100 new make one range.
+    ranges.grow(200);
+    SR_CHECK(ranges.getCapacity() == 200 && ranges.getUsed() == 60);
+    SR_CHECK(ranges.allocate(140, offset) && offset == 60);
+
+    // Nothing free at the end, so the new space stands alone.
+    ranges.grow(250);
+    SR_CHECK(ranges.allocate(50, offset) && offset == 200);
+    SR_CHECK(ranges.getUsed() == 250);
+
+    // Shrinking isn't allowed.
+    ranges.grow(10);
+    SR_CHECK(ranges.getCapacity() == 250);
+  }
+
+  SR_TEST(RangeAllocator, zeroSizeRanges)
+  {
+    RangeAllocator ranges;
+
+    // Empty meshes get an empty range even with no space at all.
+    uint offset = 123;
+    SR_CHECK(ranges.allocate(0, offset) && offset == 0);
+    SR_CHECK(ranges.getUsed() == 0);
+
+    ranges.grow(64);
+    uint full;
+    SR_CHECK(ranges.allocate(64, full));
+    SR_CHECK(ranges.allocate(0, offset));
+    ranges.free(offset, 0);
+    ranges.free(17, 0);
+    SR_CHECK(ranges.getUsed() == 64);
+
+    ranges.free(full, 64);
+    SR_CHECK(ranges.allocate(64, offset) && offset == 0);
+  }
+
+  // Random allocations, frees and grows, checked against the reference after
+  // every step. First fit only gives the same offsets as the reference if
+  // every pair of neighbouring free ranges was merged.
+  SR_TEST(RangeAllocator, matchesReferenceModel)
+  {
+    std::mt19937 generator(7);
+
+    for (uint run = 0; run < 20; run++)
+    {
+      RangeAllocator ranges;
+      ReferenceRanges reference;
+      std::vector<std::pair<uint, uint>> live;
+
+      bool matches = true;
+      for (uint step = 0; step < 2000 && matches; step++)
+      {
+        uint action = generator() % 16;
+        if (action == 0 && ranges.getCapacity() < 4096)
+        {
+          uint capacity = ranges.getCapacity() + generator() % 200;
+          ranges.grow(capacity);
+          reference.taken.resize(capacity, false);
+        }
+        else if (action < 8 || live.empty())
+        {
+          // Mostly small, sometimes empty, sometimes too big to fit.
+          uint size = generator() % 4 == 0 ? generator() % 3 : generator() % 64 + 1;
+          if (generator() % 32 == 0)
+            size = reference.largestFree() + generator() % 2;
+
+          uint offset = 0, expected = 0;
+          bool allocated = ranges.allocate(size, offset);
+          bool fits = size == 0 || reference.allocate(size, expected);
+          matches = allocated == fits && (!allocated || offset == expected);
+          if (allocated && size > 0)
+            live.emplace_back(offset, size);
+        }
+        else
+        {
+          std::size_t index = generator() % live.size();
+          ranges.free(live[index].first, live[index].second);
+          reference.free(live[index].first, live[index].second);
+          live[index] = live.back();
+          live.pop_back();
+        }
+
+        uint used = 0;
+        for (auto& range : live)
+          used += range.second;
+        matches = matches && ranges.getUsed() == used && ranges.getCapacity() == reference.taken.size();
+      }
+      SR_CHECK(matches);
+
+      // Everything freed is one range again.
+      for (auto& range : live)
+        ranges.free(range.first, range.second);
+      uint offset;
+      SR_CHECK(ranges.getUsed() == 0);
+      SR_CHECK(ranges.getCapacity() == 0 || (ranges.allocate(ranges.getCapacity(), offset) && offset == 0));
+    }
+  }
+}
@@ -0,0 +1,191 @@
+#include "Testing.h"
+
+// Project includes.
+#include "Graphics/RenderQueue.h"
+
+// STL includes.
+#include <algorithm>
+#include <random>
+
+namespace Strontium
+{
+  using namespace RenderQueue;
+
+  namespace
+  {
+    // Entries numbered in order, so the sorted indices show stability.
+    std::vector<SortEntry>
+    makeEntries(const std::vector<uint64_t> &keys)
+    {
+      std::vector<SortEntry> entries(keys.size());
+      for (uint i = 0; i < keys.size(); i++)
+        entries[i] = { keys[i], i };
+      return entries;
+    }
+
+    // Sorts both ways and compares keys and indices.
+    bool
+    sortsLikeStableSort(const std::vector<uint64_t> &keys, std::vector<SortEntry> &scratch)
+    {
+      auto entries = makeEntries(keys);
+      auto expected = entries;
+      std::stable_sort(expected.begin(), expected.end(),
+                       [](const SortEntry &a, const SortEntry &b) { return a.key < b.key; });
+
+      radixSort(entries, scratch);
+      if (entries.size() != expected.size())
+        return false;
+      for (std::size_t i = 0; i < entries.size(); i++)
+        if (entries[i].key != expected[i].key || entries[i].index != expected[i].index)
+          return false;
+      return true;
+    }
+
+    uint64_t
+    field(uint64_t key, uint shift, uint bits)
+    {
+      return (key >> shift) & ((1ull << bits) - 1ull);
+    }
+  }
+
+  SR_TEST(RenderQueue, makeKeyPacksFieldsInOrder)
+  {
+    uint64_t key = makeKey(0x9, 0xABC, 0x1234, 0x5678, 0x5, 0.5f);
+    SR_CHECK(field(key, 60, shaderBits) == 0x9);
+    SR_CHECK(field(key, 48, textureSetBits) == 0xABC);
+    SR_CHECK(field(key, 32, materialBits) == 0x1234);
+    SR_CHECK(field(key, 16, meshBits) == 0x5678);
+    SR_CHECK(field(key, 13, lodBits) == 0x5);
+    SR_CHECK(field(key, 0, depthBits) == static_cast<uint64_t>(0.5f * ((1u << depthBits) - 1u)));
+
+    // Full fields fill the key with nothing left over.
+    SR_CHECK(shaderBits + textureSetBits + materialBits + meshBits + lodBits + depthBits == 64);
+    SR_CHECK(makeKey(0xF, 0xFFF, 0xFFFF, 0xFFFF, 0x7, 1.0f) == ~0ull);
+    SR_CHECK(makeKey(0, 0, 0, 0, 0, 0.0f) == 0ull);
+
+    // Earlier fields outweigh everything after them.
+    SR_CHECK(makeKey(1, 0, 0, 0, 0, 0.0f) > makeKey(0, 0xFFF, 0xFFFF, 0xFFFF, 0x7, 1.0f));
+    SR_CHECK(makeKey(0, 0, 1, 0, 0, 0.0f) > makeKey(0, 0, 0, 0xFFFF, 0x7, 1.0f));
+    SR_CHECK(makeKey(0, 0, 0, 0, 1, 0.0f) > makeKey(0, 0, 0, 0, 0, 1.0f));
+    SR_CHECK(makeKey(2, 3, 4, 5, 1, 0.25f) < makeKey(2, 3, 4, 5, 1, 0.75f));
+  }
+
+  // IDs wider than their field wrap without touching the fields next to
+  // them, and depths outside [0, 1] clamp.
+  SR_TEST(RenderQueue, makeKeyWrapsIDsAndClampsDepth)
+  {
+    SR_CHECK(makeKey(16 + 3, 0, 0, 0, 0, 0.0f) == makeKey(3, 0, 0, 0, 0, 0.0f));
+    SR_CHECK(makeKey(0, 4096 + 7, 0, 0, 0, 0.0f) == makeKey(0, 7, 0, 0, 0, 0.0f));
+    SR_CHECK(makeKey(0, 0, 65536 + 11, 0, 0, 0.0f) == makeKey(0, 0, 11, 0, 0, 0.0f));
+    SR_CHECK(makeKey(0, 0, 0, 65536 + 13, 0, 0.0f) == makeKey(0, 0, 0, 13, 0, 0.0f));
+    SR_CHECK(makeKey(0, 0, 0, 0, 8 + 2, 0.0f) == makeKey(0, 0, 0, 0, 2, 0.0f));
+    SR_CHECK(makeKey(0xFFFFFFFF, 0, 0, 0, 0, 0.0f) == makeKey(0xF, 0, 0, 0, 0, 0.0f));
+    SR_CHECK(makeKey(0, 0, 0xFFFFFFFF, 0, 0, 0.0f) == makeKey(0, 0, 0xFFFF, 0, 0, 0.0f));
+
+    SR_CHECK(makeKey(1, 2, 3, 4, 5, -0.5f) == makeKey(1, 2, 3, 4, 5, 0.0f));
+    SR_CHECK(makeKey(1, 2, 3, 4, 5, 7.0f) == makeKey(1, 2, 3, 4, 5, 1.0f));
+    SR_CHECK(field(makeKey(1, 2, 3, 4, 5, 7.0f), 0, depthBits) == (1u << depthBits) - 1u);
+    SR_CHECK(field(makeKey(1, 2, 3, 4, 5, 7.0f), 13, lodBits) == 5);
+  }
+
+  SR_TEST(RenderQueue, radixSortIsStable)
+  {
+    std::mt19937_64 generator(3);
+    std::vector<SortEntry> scratch;
+
+    // Tiny queues, then random keys of all kinds. Few distinct keys make
+    // lots of ties.
+    SR_CHECK(sortsLikeStableSort({}, scratch));
+    SR_CHECK(sortsLikeStableSort({ 5 }, scratch));
+    SR_CHECK(sortsLikeStableSort({ 5, 5 }, scratch));
+    SR_CHECK(sortsLikeStableSort({ 9, 2 }, scratch));
+
+    bool matches = true;
+    for (uint size : { 3u, 100u, 4097u, 50000u })
+    {
+      std::vector<uint64_t> keys(size);
+      for (auto& key : keys)
+        key = generator();
+      matches = matches && sortsLikeStableSort(keys, scratch);
+
+      for (auto& key : keys)
+        key = makeKey(generator() % 4, generator() % 3, generator() % 5, generator() % 7,
+                      generator() % 4, static_cast<float>(generator() % 9) / 8.0f);
+      matches = matches && sortsLikeStableSort(keys, scratch);
+
+      for (auto& key : keys)
+        key = generator() % 3;
+      matches = matches && sortsLikeStableSort(keys, scratch);
+    }
+    SR_CHECK(matches);
+  }
+
+  // Keys that only differ in some bytes skip the other passes. An odd or
+  // even number of passes leaves the result in different buffers, and no
+  // passes at all must leave the queue alone.
+  SR_TEST(RenderQueue, radixSortSkipsConstantBytes)
+  {
+    std::mt19937_64 generator(5);
+    std::vector<SortEntry> scratch;
+
+    const uint64_t masks[] = {
+      0x00000000000000FFull, // One pass.
+      0xFF00000000000000ull, // One pass at the top.
+      0x00FF0000FF000000ull, // Two passes.
+      0x0000FF00FF0000FFull, // Three passes.
+      0x0F000000000F0000ull, // Part bytes.
+      0x8000000000000001ull, // The outermost bits.
+    };
+
+    bool matches = true;
+    for (uint64_t mask : masks)
+    {
+      uint64_t base = generator() & ~mask;
+      std::vector<uint64_t> keys(3000);
+      for (auto& key : keys)
+        key = base | (generator() & mask);
+      matches = matches && sortsLikeStableSort(keys, scratch);
+    }
+    SR_CHECK(matches);
+
+    // Every key the same.
+    std::vector<uint64_t> sameKeys(1000, 0x0123456789ABCDEFull);
+    auto entries = makeEntries(sameKeys);
+    radixSort(entries, scratch);
+    bool unchanged = true;
+    for (uint i = 0; i < entries.size(); i++)
+      unchanged = unchanged && entries[i].index == i && entries[i].key == sameKeys[i];
+    SR_CHECK(unchanged);
+  }
+
+  SR_BENCHMARK(RenderQueue, sortFrameQueue)
+  {
+    std::mt19937_64 generator(1);
+    std::vector<uint64_t> keys(100000);
+    for (auto& key : keys)
+      key = makeKey(generator() % 8, generator() % 200, generator() % 1000, generator() % 2000,
+                    generator() % 4, static_cast<float>(generator() % 1000) / 1000.0f);
+
+    std::vector<SortEntry> scratch;
+    auto entries = makeEntries(keys);
+    auto start = std::chrono::steady_clock::now();
+    for (uint i = 0; i < 20; i++)
+    {
+      entries = makeEntries(keys);
+      radixSort(entries, scratch);
+    }
+    double radixMs = Testing::millisecondsSince(start) / 20.0;
+
+    start = std::chrono::steady_clock::now();
+    for (uint i = 0; i < 20; i++)
+    {
+      entries = makeEntries(keys);
+      std::stable_sort(entries.begin(), entries.end(),
+                       [](const SortEntry &a, const SortEntry &b) { return a.key < b.key; });
+    }
+    double stableMs = Testing::millisecondsSince(start) / 20.0;
+
+    std::cout << "  100k keys: radix sort " << radixMs << " ms, std::stable_sort "
+              << stableMs << " ms" << std::endl;
+  }
+}
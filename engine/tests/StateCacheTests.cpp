@@ -0,0 +1,161 @@
+#include "Testing.h"
+
+// Project includes.
+#include "Graphics/StateCache.h"
+
+// OpenGL includes. Only for the enums, nothing here calls into OpenGL.
+#include "glad/glad.h"
+
+namespace Strontium
+{
+  namespace
+  {
+    // Counts the calls which would have reached the driver.
+    class CountingBackend : public StateCacheBackend
+    {
+    public:
+      void useProgram(uint programID) override { this->programBinds++; this->lastProgram = programID; }
+      void bindVertexArray(uint arrayID) override { this->arrayBinds++; this->lastArray = arrayID; }
+      void activeTexture(uint unit) override { this->unitChanges++; this->lastUnit = unit; }
+      void bindTexture(uint target, uint textureID) override { this->textureBinds++; this->lastTexture = textureID; }
+
+      uint total() const { return this->programBinds + this->arrayBinds + this->unitChanges + this->textureBinds; }
+
+      uint programBinds = 0;
+      uint arrayBinds = 0;
+      uint unitChanges = 0;
+      uint textureBinds = 0;
+
+      uint lastProgram = 0;
+      uint lastArray = 0;
+      uint lastUnit = 0;
+      uint lastTexture = 0;
+    };
+
+    // Swaps the counting backend in for the length of a test.
+    struct ScopedBackend
+    {
+      CountingBackend backend;
+
+      ScopedBackend()
+      {
+        StateCache::setBackend(&this->backend);
+        StateCache::resetStats();
+      }
+
+      ~ScopedBackend() { StateCache::setBackend(nullptr); }
+    };
+  }
+
+  SR_TEST(StateCache, redundantBindsAreSkipped)
+  {
+    ScopedBackend scope;
+    auto& calls = scope.backend;
+
+    StateCache::useProgram(3);
+    StateCache::useProgram(3);
+    StateCache::bindVertexArray(7);
+    StateCache::bindVertexArray(7);
+    StateCache::useProgram(4);
+    StateCache::bindVertexArray(8);
+
+    SR_CHECK(calls.programBinds == 2 && calls.lastProgram == 4);
+    SR_CHECK(calls.arrayBinds == 2 && calls.lastArray == 8);
+    SR_CHECK(StateCache::getStats().bindsIssued == 4);
+    SR_CHECK(StateCache::getStats().bindsSkipped == 2);
+  }
+
+  SR_TEST(StateCache, texturesAreCachedPerUnitAndTarget)
+  {
+    ScopedBackend scope;
+    auto& calls = scope.backend;
+
+    // First bind to a unit selects it, rebinding the same texture doesn't.
+    StateCache::bindTexture(0, GL_TEXTURE_2D, 10);
+    StateCache::bindTexture(0, GL_TEXTURE_2D, 10);
+    SR_CHECK(calls.unitChanges == 1 && calls.textureBinds == 1);
+
+    // Different targets on one unit are tracked separately.
+    StateCache::bindTexture(0, GL_TEXTURE_CUBE_MAP, 11);
+    StateCache::bindTexture(0, GL_TEXTURE_2D, 10);
+    SR_CHECK(calls.unitChanges == 1 && calls.textureBinds == 2);
+
+    // A texture already bound to another unit doesn't change the active unit.
+    StateCache::bindTexture(1, GL_TEXTURE_2D, 12);
+    SR_CHECK(calls.unitChanges == 2 && calls.lastUnit == 1);
+    StateCache::bindTexture(0, GL_TEXTURE_2D, 10);
+    SR_CHECK(calls.unitChanges == 2 && calls.textureBinds == 3);
+
+    // Binds to the active unit go through the same cache.
+    StateCache::bindTexture(GL_TEXTURE_2D, 12);
+    SR_CHECK(calls.textureBinds == 3);
+    StateCache::bindTexture(GL_TEXTURE_2D, 13);
+    SR_CHECK(calls.textureBinds == 4 && calls.lastTexture == 13);
+  }
+
+  SR_TEST(StateCache, uncachedStateAlwaysBinds)
+  {
+    ScopedBackend scope;
+    auto& calls = scope.backend;
+
+    // Targets without a cached slot.
+    StateCache::bindTexture(0, GL_TEXTURE_1D, 5);
+    StateCache::bindTexture(0, GL_TEXTURE_1D, 5);
+    SR_CHECK(calls.textureBinds == 2);
+
+    // Units past the cached range.
+    StateCache::bindTexture(MAX_CACHED_TEXTURE_UNITS, GL_TEXTURE_2D, 6);
+    StateCache::bindTexture(MAX_CACHED_TEXTURE_UNITS, GL_TEXTURE_2D, 6);
+    SR_CHECK(calls.textureBinds == 4);
+    SR_CHECK(calls.unitChanges == 2 && calls.lastUnit == MAX_CACHED_TEXTURE_UNITS);
+  }
+
+  SR_TEST(StateCache, forgottenObjectsAreRebound)
+  {
+    ScopedBackend scope;
+    auto& calls = scope.backend;
+
+    StateCache::useProgram(3);
+    StateCache::bindVertexArray(7);
+    StateCache::bindTexture(2, GL_TEXTURE_2D, 20);
+    StateCache::bindTexture(3, GL_TEXTURE_2D, 20);
+    uint before = calls.total();
+
+    // Deleted names get reused, so a new object with the same name has to be
+    // bound for real.
+    StateCache::forgetProgram(3);
+    StateCache::forgetVertexArray(7);
+    StateCache::forgetTexture(20);
+    StateCache::useProgram(3);
+    StateCache::bindVertexArray(7);
+    StateCache::bindTexture(2, GL_TEXTURE_2D, 20);
+    StateCache::bindTexture(3, GL_TEXTURE_2D, 20);
+    SR_CHECK(calls.programBinds == 2);
+    SR_CHECK(calls.arrayBinds == 2);
+    SR_CHECK(calls.textureBinds == 4);
+
+    // Forgetting something which isn't bound changes nothing.
+    StateCache::forgetProgram(99);
+    StateCache::forgetTexture(99);
+    StateCache::useProgram(3);
+    StateCache::bindTexture(3, GL_TEXTURE_2D, 20);
+    SR_CHECK(calls.total() == before + 6);
+  }
+
+  SR_TEST(StateCache, invalidateForgetsEverything)
+  {
+    ScopedBackend scope;
+    auto& calls = scope.backend;
+
+    StateCache::useProgram(1);
+    StateCache::bindVertexArray(1);
+    StateCache::bindTexture(0, GL_TEXTURE_2D, 1);
+    SR_CHECK(calls.total() == 4);
+
+    StateCache::invalidate();
+    StateCache::useProgram(1);
+    StateCache::bindVertexArray(1);
+    StateCache::bindTexture(0, GL_TEXTURE_2D, 1);
+    SR_CHECK(calls.total() == 8);
+  }
+}
@@ -0,0 +1,215 @@
+#include "Testing.h"
+
+// Project includes.
+#include "Core/TaskGraph.h"
+
+// STL includes.
+#include <atomic>
+#include <random>
+#include <thread>
+
+namespace Strontium
+{
+  namespace
+  {
+    // Records when each task started and finished, as ticks of a shared
+    // counter, so the order can be checked after the graph has run.
+    struct TaskTimeline
+    {
+      std::atomic<uint> clock;
+      std::vector<std::atomic<uint>> started;
+      std::vector<std::atomic<uint>> finished;
+      std::vector<std::atomic<uint>> numRuns;
+
+      TaskTimeline(uint numTasks)
+        : clock(1)
+        , started(numTasks)
+        , finished(numTasks)
+        , numRuns(numTasks)
+      {
+        this->reset();
+      }
+
+      void
+      reset()
+      {
+        for (uint i = 0; i < this->started.size(); i++)
+        {
+          this->started[i].store(0);
+          this->finished[i].store(0);
+          this->numRuns[i].store(0);
+        }
+      }
+
+      std::function<void()>
+      task(uint index)
+      {
+        return [this, index]()
+        {
+          this->started[index].store(this->clock.fetch_add(1));
+          // Long enough that a child started too early would overlap.
+          std::this_thread::sleep_for(std::chrono::microseconds(50));
+          this->numRuns[index]++;
+          this->finished[index].store(this->clock.fetch_add(1));
+        };
+      }
+
+      bool
+      ranAfter(uint child, uint parent) const
+      {
+        return this->finished[parent].load() != 0
+               && this->finished[parent].load() < this->started[child].load();
+      }
+    };
+  }
+
+  SR_TEST(TaskGraph, diamondJoinsAfterBothBranches)
+  {
+    auto pool = ThreadPool::getInstance();
+    TaskTimeline timeline(4);
+
+    TaskGraph graph;
+    TaskHandle top = graph.addTask(timeline.task(0));
+    TaskHandle left = graph.addTask(timeline.task(1), { top });
+    TaskHandle right = graph.addTask(timeline.task(2), { top });
+    TaskHandle join = graph.addTask(timeline.task(3), { left, right });
+    SR_CHECK(graph.size() == 4);
+
+    // Executed repeatedly, the counters have to be reset for every run.
+    for (uint run = 0; run < 50; run++)
+    {
+      timeline.reset();
+      graph.execute(pool);
+
+      for (uint i = 0; i < 4; i++)
+        SR_CHECK(timeline.numRuns[i].load() == 1);
+      SR_CHECK(timeline.ranAfter(left, top) && timeline.ranAfter(right, top));
+      SR_CHECK(timeline.ranAfter(join, left) && timeline.ranAfter(join, right));
+    }
+  }
+
+  // Random graphs where each task has up to four parents among the tasks
+  // before it. Every task runs once, and only after all of its parents.
+  SR_TEST(TaskGraph, tasksRunAfterTheirParents)
+  {
+    auto pool = ThreadPool::getInstance();
+    std::mt19937 generator(1);
+
+    for (uint numTasks : { 1u, 2u, 17u, 200u })
+    {
+      TaskTimeline timeline(numTasks);
+      std::vector<std::vector<TaskHandle>> parents(numTasks);
+
+      TaskGraph graph;
+      for (uint i = 0; i < numTasks; i++)
+      {
+        if (i > 0)
+        {
+          std::uniform_int_distribution<uint> parent(0, i - 1);
+          uint numParents = std::min(static_cast<uint>(generator() % 5), i);
+          for (uint p = 0; p < numParents; p++)
+            parents[i].push_back(parent(generator));
+        }
+
+        SR_CHECK(graph.addTask(timeline.task(i), parents[i]) == i);
+      }
+
+      graph.execute(pool);
+
+      bool ordered = true;
+      for (uint i = 0; i < numTasks; i++)
+      {
+        ordered = ordered && timeline.numRuns[i].load() == 1;
+        for (TaskHandle parent : parents[i])
+          ordered = ordered && timeline.ranAfter(i, parent);
+      }
+      SR_CHECK(ordered);
+    }
+  }
+
+  // Wide fan outs and a long tail, so the calling thread runs out of ready
+  // tasks while workers are still busy. Nothing may still be running, or
+  // left to run, when execute() returns.
+  SR_TEST(TaskGraph, executeWaitsForEveryTask)
+  {
+    auto pool = ThreadPool::getInstance();
+    constexpr uint fanOut = 64;
+
+    std::atomic<uint> numRunning(0);
+    std::atomic<uint> numDone(0);
+    auto slowTask = [&numRunning, &numDone]()
+    {
+      numRunning++;
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+      numDone++;
+      numRunning--;
+    };
+
+    TaskGraph graph;
+    TaskHandle root = graph.addTask(slowTask);
+    std::vector<TaskHandle> middle;
+    for (uint i = 0; i < fanOut; i++)
+      middle.push_back(graph.addTask(slowTask, { root }));
+    TaskHandle join = graph.addTask(slowTask, middle);
+    TaskHandle tail = join;
+    for (uint i = 0; i < 8; i++)
+      tail = graph.addTask(slowTask, { tail });
+    for (uint i = 0; i < fanOut; i++)
+      graph.addTask(slowTask, { tail });
+
+    const uint numTasks = graph.size();
+    for (uint run = 0; run < 20; run++)
+    {
+      numDone.store(0);
+      graph.execute(pool);
+      SR_CHECK(numDone.load() == numTasks);
+      SR_CHECK(numRunning.load() == 0);
+    }
+
+    // Independent roots only, which all start at once.
+    graph.clear();
+    SR_CHECK(graph.size() == 0);
+    for (uint i = 0; i < fanOut; i++)
+      graph.addTask(slowTask);
+
+    numDone.store(0);
+    graph.execute(pool);
+    SR_CHECK(numDone.load() == fanOut);
+    SR_CHECK(numRunning.load() == 0);
+
+    // An empty graph returns straight away.
+    TaskGraph empty;
+    empty.execute(pool);
+  }
+
+  // A task may run parallelFor on the same pool, like the scene update does
+  // for its animators.
+  SR_TEST(TaskGraph, tasksCanUseParallelFor)
+  {
+    auto pool = ThreadPool::getInstance();
+    std::vector<uint> hits(10007, 0);
+    std::atomic<uint> numRan(0);
+
+    TaskGraph graph;
+    TaskHandle first = graph.addTask([pool, &hits]()
+    {
+      pool->parallelFor(0, static_cast<uint>(hits.size()), 64, [&hits](uint i) { hits[i]++; });
+    });
+    TaskHandle second = graph.addTask([pool, &hits]()
+    {
+      pool->parallelFor(0, static_cast<uint>(hits.size()), 64, [&hits](uint i) { hits[i]++; });
+    }, { first });
+    graph.addTask([&numRan]() { numRan++; });
+    graph.addTask([&hits, &numRan]()
+    {
+      bool allTwice = true;
+      for (uint hit : hits)
+        allTwice = allTwice && hit == 2;
+      if (allTwice)
+        numRan++;
+    }, { second });
+
+    graph.execute(pool);
+    SR_CHECK(numRan.load() == 2);
+  }
+}
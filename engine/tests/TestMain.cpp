@@ -0,0 +1,128 @@
+#include "Testing.h"
+
+#if defined(__AVX2__) && defined(_MSC_VER)
+  #include <intrin.h>
+#endif
+
+// Usage: StrontiumTests [--bench] [group or Group.name ...]
+//
+// Runs the tests, or the benchmarks with --bench, whose names match any of
+// the filters. Without filters everything of that kind runs.
+namespace Strontium
+{
+  namespace Testing
+  {
+    static uint numFailures = 0;
+
+    std::vector<TestCase>&
+    getTests()
+    {
+      // Function local so registration from other files' static
+      // initialisers can't run before the vector exists.
+      static std::vector<TestCase> tests;
+      return tests;
+    }
+
+    bool
+    registerTest(const char* group, const char* name, TestFunction function,
+                 bool isBenchmark)
+    {
+      getTests().push_back({ std::string(group) + "." + name, function, isBenchmark });
+      return true;
+    }
+
+    void
+    reportFailure(const char* expression, const char* file, int line)
+    {
+      std::cout << "  " << file << ":" << line << ": check failed: " << expression << std::endl;
+      numFailures++;
+    }
+
+    // A filter matches a whole name, or the group before the dot.
+    static bool
+    matchesFilter(const std::string &name, const std::vector<std::string> &filters)
+    {
+      if (filters.empty())
+        return true;
+
+      for (auto& filter : filters)
+      {
+        if (name == filter || name.compare(0, filter.size() + 1, filter + ".") == 0)
+          return true;
+      }
+
+      return false;
+    }
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  using namespace Strontium;
+
+  // Built with AVX2 for the math tests. Tell ctest to skip rather than
+  // crashing on a CPU without it.
+#if defined(__AVX2__)
+  #if defined(_MSC_VER)
+  int cpuInfo[4];
+  __cpuidex(cpuInfo, 7, 0);
+  bool hasAVX2 = (cpuInfo[1] & (1 << 5)) != 0;
+  #else
+  bool hasAVX2 = __builtin_cpu_supports("avx2");
+  #endif
+  if (!hasAVX2)
+  {
+    std::cout << "This CPU doesn't support AVX2, skipping." << std::endl;
+    return 77;
+  }
+#endif
+
+  bool runBenchmarks = false;
+  std::vector<std::string> filters;
+  for (int i = 1; i < argc; i++)
+  {
+    std::string argument = argv[i];
+    if (argument == "--bench")
+      runBenchmarks = true;
+    else
+      filters.push_back(argument);
+  }
+
+  // Sorted so the order doesn't depend on the link order.
+  auto tests = Testing::getTests();
+  std::sort(tests.begin(), tests.end(), [](const Testing::TestCase &a, const Testing::TestCase &b)
+  {
+    return a.name < b.name;
+  });
+
+  uint numRun = 0;
+  uint numFailed = 0;
+  for (auto& test : tests)
+  {
+    if (test.isBenchmark != runBenchmarks || !Testing::matchesFilter(test.name, filters))
+      continue;
+
+    std::cout << "[ RUN  ] " << test.name << std::endl;
+    uint failuresBefore = Testing::numFailures;
+    auto start = std::chrono::steady_clock::now();
+    test.function();
+    double elapsed = Testing::millisecondsSince(start);
+
+    bool passed = Testing::numFailures == failuresBefore;
+    std::cout << (passed ? "[  OK  ] " : "[ FAIL ] ") << test.name
+              << " (" << elapsed << " ms)" << std::endl;
+
+    numRun++;
+    numFailed += passed ? 0 : 1;
+  }
+
+  if (numRun == 0)
+  {
+    std::cout << "Nothing matched the filters." << std::endl;
+    return 1;
+  }
+
+  std::cout << numRun - numFailed << "/" << numRun << " passed." << std::endl;
+  return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+// Macro include file.
+#include "StrontiumPCH.h"
+
+// Project includes.
+#include "Core/ApplicationBase.h"
+
+// STL includes.
+#include <chrono>
+
+namespace Strontium
+{
+  // A minimal test runner for the engine code which doesn't need a graphics
+  // context. Tests and benchmarks register themselves with the macros below
+  // and are named "Group.name", so a group can be run on its own.
+  namespace Testing
+  {
+    typedef void (*TestFunction)();
+
+    struct TestCase
+    {
+      std::string name;
+      TestFunction function;
+      bool isBenchmark;
+    };
+
+    std::vector<TestCase>& getTests();
+    bool registerTest(const char* group, const char* name, TestFunction function,
+                      bool isBenchmark);
+
+    // Record a failed check. The test keeps going, so every failure in it
+    // gets reported.
+    void reportFailure(const char* expression, const char* file, int line);
+
+    // Milliseconds since the given time.
+    inline double
+    millisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+      std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+      return elapsed.count();
+    }
+  }
+}
+
+#define SR_TEST(group, name) \
+  static void group##_##name(); \
+  static bool group##_##name##Registered = \
+    Strontium::Testing::registerTest(#group, #name, group##_##name, false); \
+  static void group##_##name()
+
+#define SR_BENCHMARK(group, name) \
+  static void group##_##name(); \
+  static bool group##_##name##Registered = \
+    Strontium::Testing::registerTest(#group, #name, group##_##name, true); \
+  static void group##_##name()
+
+#define SR_CHECK(condition) \
+  do \
+  { \
+    if (!(condition)) \
+      Strontium::Testing::reportFailure(#condition, __FILE__, __LINE__); \
+  } while (false)
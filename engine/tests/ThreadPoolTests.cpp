@@ -0,0 +1,170 @@
+#include "Testing.h"
+
+// Project includes.
+#include "Core/ThreadPool.h"
+
+// STL includes.
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+namespace Strontium
+{
+  namespace
+  {
+    // A few microseconds of arithmetic the compiler can't fold away.
+    uint
+    busyWork(uint seed, uint iterations)
+    {
+      uint value = seed;
+      for (uint i = 0; i < iterations; i++)
+        value = value * 1664525u + 1013904223u;
+      return value;
+    }
+
+    // Set or clear an environment variable. The pool only reads its sizing
+    // from the environment.
+    void
+    setVariable(const char* variable, const char* value)
+    {
+#ifdef _WIN32
+      _putenv_s(variable, value == nullptr ? "" : value);
+#else
+      if (value == nullptr)
+        unsetenv(variable);
+      else
+        setenv(variable, value, 1);
+#endif
+    }
+  }
+
+  SR_TEST(ThreadPool, pushReturnsFutures)
+  {
+    auto pool = ThreadPool::getInstance();
+
+    std::vector<std::future<uint>> futures;
+    for (uint i = 0; i < 10000; i++)
+      futures.push_back(pool->push([](uint value) { return value * 2; }, i));
+
+    uint64_t sum = 0;
+    for (auto& future : futures)
+      sum += future.get();
+
+    SR_CHECK(sum == 2ull * (9999ull * 10000ull / 2ull));
+  }
+
+  SR_TEST(ThreadPool, jobsPushedFromJobsRun)
+  {
+    auto pool = ThreadPool::getInstance();
+    auto group = createShared<JobGroup>();
+    std::atomic<uint> numRun(0);
+
+    // Every job pushes more onto its own worker's deque, so idle workers
+    // only get work by stealing it.
+    for (uint i = 0; i < 64; i++)
+    {
+      pool->pushJob(JobParams(JobLane::CPU, group), [pool, group, &numRun]()
+      {
+        for (uint j = 0; j < 64; j++)
+          pool->pushJob(JobParams(JobLane::CPU, group), [&numRun]() { numRun++; });
+        numRun++;
+      });
+    }
+    group->wait();
+
+    SR_CHECK(numRun.load() == 64 * 65);
+  }
+
+  SR_TEST(ThreadPool, parallelForCoversRange)
+  {
+    auto pool = ThreadPool::getInstance();
+
+    std::vector<uint> hits(100003, 0);
+    pool->parallelFor(0, static_cast<uint>(hits.size()), 1000, [&hits](uint i) { hits[i]++; });
+
+    bool allOnce = true;
+    for (uint hit : hits)
+      allOnce = allOnce && hit == 1;
+    SR_CHECK(allOnce);
+  }
+
+  // Job throughput for 1 up to the number of hardware threads, each with a
+  // freshly created pool. Jobs are pushed from the main thread and from
+  // other jobs, the second being where stealing matters.
+  SR_BENCHMARK(ThreadPool, throughputScaling)
+  {
+    constexpr uint numJobs = 200000;
+    constexpr uint jobIterations = 2000;
+
+    // Start from a pool with the requested size, not whatever the tests used.
+    delete ThreadPool::getInstance();
+
+    const char* cpuWorkers = std::getenv("SR_CPU_WORKERS");
+    const char* ioWorkers = std::getenv("SR_IO_WORKERS");
+    bool hadCPUWorkers = cpuWorkers != nullptr;
+    bool hadIOWorkers = ioWorkers != nullptr;
+    std::string oldCPUWorkers = hadCPUWorkers ? cpuWorkers : "";
+    std::string oldIOWorkers = hadIOWorkers ? ioWorkers : "";
+    setVariable("SR_IO_WORKERS", "1");
+
+    uint maxWorkers = std::max(std::thread::hardware_concurrency(), 1u);
+    double baseFlat = 0.0;
+    double baseNested = 0.0;
+    for (uint numWorkers = 1; numWorkers <= maxWorkers; numWorkers *= 2)
+    {
+      setVariable("SR_CPU_WORKERS", std::to_string(numWorkers).c_str());
+      auto pool = ThreadPool::getInstance();
+
+      std::atomic<uint> checksum(0);
+      auto group = createShared<JobGroup>();
+      auto start = std::chrono::steady_clock::now();
+      for (uint i = 0; i < numJobs; i++)
+      {
+        pool->pushJob(JobParams(JobLane::CPU, group), [i, &checksum]()
+        {
+          checksum.fetch_add(busyWork(i, jobIterations), std::memory_order_relaxed);
+        });
+      }
+      group->wait();
+      double flatMs = Testing::millisecondsSince(start);
+
+      start = std::chrono::steady_clock::now();
+      constexpr uint numParents = 256;
+      for (uint i = 0; i < numParents; i++)
+      {
+        pool->pushJob(JobParams(JobLane::CPU, group), [i, pool, group, &checksum]()
+        {
+          for (uint j = 0; j < numJobs / numParents; j++)
+          {
+            pool->pushJob(JobParams(JobLane::CPU, group), [i, j, &checksum]()
+            {
+              checksum.fetch_add(busyWork(i + j, jobIterations), std::memory_order_relaxed);
+            });
+          }
+        });
+      }
+      group->wait();
+      double nestedMs = Testing::millisecondsSince(start);
+
+      if (numWorkers == 1)
+      {
+        baseFlat = flatMs;
+        baseNested = nestedMs;
+      }
+
+      std::cout << "  " << numWorkers << " worker(s): flat "
+                << numJobs / flatMs / 1000.0 << " M jobs/s (x" << baseFlat / flatMs
+                << "), nested " << numJobs / nestedMs / 1000.0 << " M jobs/s (x"
+                << baseNested / nestedMs << ")" << std::endl;
+
+      delete pool;
+      if (numWorkers < maxWorkers && numWorkers * 2 > maxWorkers)
+        numWorkers = maxWorkers / 2;
+    }
+
+    // Later benchmarks get the pool they would have had.
+    setVariable("SR_CPU_WORKERS", hadCPUWorkers ? oldCPUWorkers.c_str() : nullptr);
+    setVariable("SR_IO_WORKERS", hadIOWorkers ? oldIOWorkers.c_str() : nullptr);
+  }
+}
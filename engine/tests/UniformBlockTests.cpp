@@ -0,0 +1,57 @@
+#include "Testing.h"
+
+// Project includes.
+#include "Graphics/UniformBlocks.h"
+
+namespace Strontium
+{
+  using namespace Renderer3D;
+
+  // Byte offsets of the shader declarations under std140 (std430 for the
+  // instance block), worked out by hand rather than with the Std140 helpers,
+  // so a mistake in the helpers can't hide one in the structs.
+  static_assert(NUM_CASCADES == 4, "The shaders declare 4 cascades.");
+
+  // CameraBlock: mat4 view, proj, invViewProj, vec3 camPosition, vec4 nearFar.
+  static_assert(offsetof(CameraBlockData, viewMatrix) == 0, "");
+  static_assert(offsetof(CameraBlockData, projMatrix) == 64, "");
+  static_assert(offsetof(CameraBlockData, invViewProjMatrix) == 128, "");
+  static_assert(offsetof(CameraBlockData, camPosition) == 192, "");
+  static_assert(offsetof(CameraBlockData, nearFar) == 208, "");
+  static_assert(sizeof(CameraBlockData) == 224, "");
+
+  // ModelBlock: mat4 model, vec4 vertexFormat.
+  static_assert(offsetof(ModelBlockData, modelMatrix) == 0, "");
+  static_assert(offsetof(ModelBlockData, vertexFormat) == 64, "");
+  static_assert(sizeof(ModelBlockData) == 80, "");
+
+  // CascadedShadowBlock: mat4 lightVP[4], vec4 cascadeData[4],
+  // vec4 shadowParams1, vec4 shadowParams2.
+  static_assert(offsetof(CascadedShadowBlockData, lightVP) == 0, "");
+  static_assert(offsetof(CascadedShadowBlockData, cascadeData) == 256, "");
+  static_assert(offsetof(CascadedShadowBlockData, shadowParams) == 320, "");
+  static_assert(sizeof(CascadedShadowBlockData) == 352, "");
+
+  // InstanceBlock entries: mat4 model, vec4 maskColourID, tightly packed.
+  static_assert(offsetof(InstanceData, modelMatrix) == 0, "");
+  static_assert(offsetof(InstanceData, maskColourID) == 64, "");
+  static_assert(sizeof(InstanceData) == 80, "");
+
+  // The layouts are checked at compile time above. This covers the helpers
+  // the engine's own asserts are written with.
+  SR_TEST(UniformBlocks, std140Helpers)
+  {
+    SR_CHECK(Std140::align(0, 16) == 0);
+    SR_CHECK(Std140::align(1, 16) == 16);
+    SR_CHECK(Std140::align(16, 16) == 16);
+    SR_CHECK(Std140::align(17, 4) == 20);
+
+    // A vec3 is followed by a vec4 on the next 16 byte boundary, but a
+    // scalar packs into its last 4 bytes.
+    SR_CHECK(Std140::next(192, 3 * Std140::scalarSize) == 208);
+    SR_CHECK(Std140::next(192, 3 * Std140::scalarSize, Std140::scalarSize) == 204);
+
+    SR_CHECK(Std140::next(0, Std140::mat4Size) == 64);
+    SR_CHECK(Std140::next(0, NUM_CASCADES * Std140::mat4Size) == 256);
+  }
+}